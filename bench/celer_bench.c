@@ -0,0 +1,303 @@
+// Suite de benchmarks del intérprete. Para cada workload mide por separado
+// las fases de lexer, parser, resolver, checker y ejecución (optimizador +
+// evaluador o VM), repite las corridas y escribe en stdout un JSON con
+// mediana/p95 de tiempo de pared, ops/s y RSS pico.
+//
+// Cada workload corre en un proceso hijo, así el RSS pico es sólo suyo. Las
+// ops de un workload salen de una línea `*-- ops: N` de su fuente (trabajo
+// lógico de main: llamadas, iteraciones...); en las fases previas son tokens.
+// Además de los archivos se mide un fuente sintético grande (todo menos la
+// ejecución). Requiere POSIX (fork, clock_gettime, getrusage).
+//
+// Compilar (desde la raíz del repo):
+//   cc -std=c99 -O2 -Iinclude bench/celer_bench.c $(ls src/*.c | grep -v -e main.c -e repl.c -e run.c) -o build/celer_bench -lm
+// Uso:
+//   ./build/celer_bench [--runs N] [--vm] [--no-opt] [--no-jit] [--source-kb K] bench/workloads/*.celer
+
+#define _POSIX_C_SOURCE 200809L
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/ast.h"
+#include "../include/env.h"
+#include "../include/eval.h"
+#include "../include/resolver.h"
+#include "../include/typecheck.h"
+#include "../include/optimizer.h"
+#include "../include/jit.h"
+#include "../include/bytecode.h"
+#include "../include/vm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+typedef struct {
+    int runs;
+    bool use_vm, optimize, use_jit;
+    size_t source_kb;
+} bench_opts;
+
+typedef struct {
+    double *ms; int count;
+} samples;
+
+static double now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static int cmp_double(const void *a, const void *b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+// p en [0,1], por rango más cercano sobre las muestras ordenadas
+static double percentile(const samples *s, double p){
+    size_t k = (size_t)(p * (double)s->count + 0.999999);
+    if(k == 0) k = 1;
+    if(k > (size_t)s->count) k = (size_t)s->count;
+    return s->ms[k - 1];
+}
+
+static void print_phase(const char *name, samples *s, unsigned long long ops, bool last){
+    qsort(s->ms, (size_t)s->count, sizeof(double), cmp_double);
+    double med = percentile(s, 0.5);
+    printf("      \"%s\": {\"median_ms\": %.4f, \"p95_ms\": %.4f, \"min_ms\": %.4f, \"ops\": %llu, \"ops_per_sec\": %.1f}%s\n",
+           name, med, percentile(s, 0.95), s->ms[0], ops, med > 0 ? (double)ops / (med / 1e3) : 0.0, last ? "" : ",");
+}
+
+static void print_json_string(const char *s){
+    putchar('"');
+    for(; *s; s++){
+        if(*s == '"' || *s == '\\') putchar('\\');
+        if((unsigned char)*s < 0x20) printf("\\u%04x", (unsigned char)*s);
+        else putchar(*s);
+    }
+    putchar('"');
+}
+
+static char *read_file(const char *path, size_t *out_len){
+    FILE *f = fopen(path, "rb"); if(!f) return NULL;
+    fseek(f, 0, SEEK_END); long n = ftell(f); fseek(f, 0, SEEK_SET);
+    if(n < 0){ fclose(f); return NULL; }
+    char *buf = (char*)malloc((size_t)n + 1);
+    if(!buf){ fclose(f); return NULL; }
+    size_t rd = fread(buf, 1, (size_t)n, f);
+    fclose(f);
+    buf[rd] = '\0';
+    if(out_len) *out_len = rd;
+    return buf;
+}
+
+// Fuente sintético de ~kb KB: funciones con nombres distintos (sin main).
+static char *synthetic_source(size_t kb, size_t *out_len){
+    size_t cap = kb * 1024u + 1024u, len = 0;
+    char *src = (char*)malloc(cap);
+    if(!src) return NULL;
+    for(unsigned i = 0; len + 512u < cap; i++){
+        len += (size_t)snprintf(src + len, cap - len,
+            "*-- bloque %u\n"
+            "const limite%u : int = %u;\n"
+            "Function acumula%u(n : int, paso : float) -> float {\n"
+            "    variable suma : float = 0.5;\n"
+            "    for (variable i : int = 0; i < n; i += 1) {\n"
+            "        if (i %% 2 == 0 && paso >= 0.25) { suma += paso * 2.0; } else { continue; }\n"
+            "        if (suma > 1000.0) { break; }\n"
+            "    }\n"
+            "    variable msg : string = \"hola\\tmundo\";\n"
+            "    return suma;\n"
+            "}\n", i, i, i, i);
+    }
+    src[len] = '\0';
+    *out_len = len;
+    return src;
+}
+
+static unsigned long long ops_of(const char *src){
+    const char *p = strstr(src, "*-- ops:");
+    return p ? strtoull(p + 8, NULL, 10) : 0u;
+}
+
+// ----- fases -----
+
+static size_t lex_all(const char *src, size_t len){
+    lexer_t lx; lexer_init(&lx, src, len);
+    size_t n = 0;
+    for(;;){
+        token_t t = lexer_next_token(&lx);
+        n++;
+        if(t.type == TOK_EOF) break;
+    }
+    return n;
+}
+
+typedef struct {
+    lexer_t lx; parser_t ps;
+    program_ast P;
+    env_t *global;
+} parsed;
+
+// Parsea, resuelve y chequea; false si hubo errores. Si `ms` no es NULL deja
+// el tiempo de parseo, resolver y checker en ms[0..2].
+static bool parse_all(const char *src, size_t len, parsed *out, double *ms){
+    double t0 = now_ms();
+    lexer_init(&out->lx, src, len);
+    parser_init(&out->ps, &out->lx);
+    out->P = parse_program(&out->ps);
+    double t1 = now_ms();
+    out->global = env_new(NULL);
+    if(ms){ ms[0] = t1 - t0; ms[1] = ms[2] = 0.0; }
+    if(parser_errors(&out->ps)->count) return false;
+    resolve_program(&out->P, out->global);
+    double t2 = now_ms();
+    eval_register_builtins(out->global);
+    parse_error_list terrs = { NULL, 0, 0 };
+    bool ok = typecheck_program(&out->P, out->global, true, &terrs);
+    typecheck_errors_free(&terrs);
+    if(ms){ ms[1] = t2 - t1; ms[2] = now_ms() - t2; }
+    return ok;
+}
+
+static void parsed_free(parsed *p){
+    env_free(p->global);
+    program_free(&p->P);
+    parser_dispose(&p->ps);
+}
+
+// Optimiza y ejecuta como run.c; false si hubo un error de ejecución.
+static bool exec_program(parsed *p, const bench_opts *o){
+    if(o->optimize){
+        inline_program(&p->P, p->global);
+        optimize_program(&p->P);
+    }
+    if(o->use_jit) jit_enable(p->global);
+    bool ok = true;
+    bc_program prog; char err[256];
+    if(o->use_vm && bc_compile_program(&p->P, p->global, &prog, err, sizeof(err))){
+        ok = vm_run(&prog, p->global);
+        bc_program_free(&prog);
+    } else {
+        ok = eval_program(p->global, &p->P).sig != SIG_RUNTIME_ERROR;
+    }
+    jit_release();
+    return ok;
+}
+
+// Corre un workload completo y escribe su objeto JSON (proceso hijo).
+static int bench_one(const char *name, const char *src, size_t len, bool run_main, const bench_opts *o){
+    samples lex = { NULL, 0 }, parse = { NULL, 0 }, resolve = { NULL, 0 }, check = { NULL, 0 }, exec = { NULL, 0 };
+    lex.ms = (double*)malloc((size_t)o->runs * sizeof(double));
+    parse.ms = (double*)malloc((size_t)o->runs * sizeof(double));
+    resolve.ms = (double*)malloc((size_t)o->runs * sizeof(double));
+    check.ms = (double*)malloc((size_t)o->runs * sizeof(double));
+    exec.ms = (double*)malloc((size_t)o->runs * sizeof(double));
+    size_t ntok = 0;
+    const char *error = NULL;
+
+    for(int r = 0; r < o->runs && !error; r++){
+        double t0 = now_ms();
+        ntok = lex_all(src, len);
+        lex.ms[lex.count++] = now_ms() - t0;
+
+        parsed p;
+        double ms[3];
+        bool ok = parse_all(src, len, &p, ms);
+        parse.ms[parse.count++] = ms[0];
+        resolve.ms[resolve.count++] = ms[1];
+        check.ms[check.count++] = ms[2];
+        if(!ok){ error = "errores de parseo o de tipos"; parsed_free(&p); break; }
+        parsed_free(&p);
+
+        if(!run_main) continue;
+        // el AST se rehace fuera de la medición: el optimizador y el JIT lo modifican
+        parse_all(src, len, &p, NULL);
+        fflush(stdout);
+        int saved = dup(STDOUT_FILENO), devnull = open("/dev/null", O_WRONLY);
+        if(devnull >= 0){ dup2(devnull, STDOUT_FILENO); close(devnull); }
+        t0 = now_ms();
+        ok = exec_program(&p, o);
+        double dt = now_ms() - t0;
+        fflush(stdout);
+        if(saved >= 0){ dup2(saved, STDOUT_FILENO); close(saved); }
+        exec.ms[exec.count++] = dt;
+        parsed_free(&p);
+        if(!ok) error = "error de ejecución";
+    }
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    printf("    {\"name\": "); print_json_string(name);
+    printf(", \"bytes\": %zu, \"tokens\": %zu, \"runs\": %d,\n", len, ntok, lex.count);
+    if(error){ printf("     \"error\": "); print_json_string(error); printf(",\n"); }
+    printf("     \"phases\": {\n");
+    print_phase("lex", &lex, ntok, false);
+    print_phase("parse", &parse, ntok, false);
+    print_phase("resolve", &resolve, ntok, false);
+    print_phase("check", &check, ntok, exec.count == 0);
+    if(exec.count) print_phase("exec", &exec, ops_of(src), true);
+    printf("     },\n     \"peak_rss_kb\": %ld}", (long)ru.ru_maxrss);
+    fflush(stdout);
+    free(lex.ms); free(parse.ms); free(resolve.ms); free(check.ms); free(exec.ms);
+    return error ? 1 : 0;
+}
+
+static bool fork_bench(const char *name, const char *src, size_t len, bool run_main, const bench_opts *o){
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid < 0) return false;
+    if(pid == 0) _exit(bench_one(name, src, len, run_main, o));
+    int st = 0;
+    if(waitpid(pid, &st, 0) < 0) return false;
+    return WIFEXITED(st) && WEXITSTATUS(st) == 0;
+}
+
+static void usage(const char *prog){
+    fprintf(stderr, "Uso: %s [--runs N] [--vm] [--no-opt] [--no-jit] [--source-kb K] archivo.celer...\n", prog);
+}
+
+int main(int argc, char **argv){
+    bench_opts o = { 10, false, true, true, 1024u };
+    int first = argc;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--runs") == 0 && i + 1 < argc) o.runs = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--source-kb") == 0 && i + 1 < argc) o.source_kb = (size_t)strtoul(argv[++i], NULL, 10);
+        else if(strcmp(argv[i], "--vm") == 0) o.use_vm = true;
+        else if(strcmp(argv[i], "--no-opt") == 0) o.optimize = false;
+        else if(strcmp(argv[i], "--no-jit") == 0) o.use_jit = false;
+        else if(strncmp(argv[i], "--", 2) == 0){ usage(argv[0]); return 1; }
+        else { first = i; break; }
+    }
+    if(o.runs <= 0) o.runs = 1;
+
+    printf("{\n  \"engine\": \"%s\", \"optimize\": %s, \"jit\": %s, \"runs\": %d,\n  \"workloads\": [\n",
+           o.use_vm ? "vm" : "eval", o.optimize ? "true" : "false",
+           o.use_jit && jit_available() ? "true" : "false", o.runs);
+    int failed = 0;
+    bool sep = false;
+    for(int i = first; i < argc; i++){
+        size_t len = 0;
+        char *src = read_file(argv[i], &len);
+        if(!src){ fprintf(stderr, "No pude leer %s\n", argv[i]); failed++; continue; }
+        const char *base = strrchr(argv[i], '/');
+        if(sep) printf(",\n");
+        if(!fork_bench(base ? base + 1 : argv[i], src, len, true, &o)) failed++;
+        sep = true;
+        free(src);
+    }
+    if(o.source_kb){
+        size_t len = 0;
+        char *src = synthetic_source(o.source_kb, &len);
+        if(src){
+            if(sep) printf(",\n");
+            if(!fork_bench("synthetic_source", src, len, false, &o)) failed++;
+            free(src);
+        }
+    }
+    printf("\n  ]\n}\n");
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,107 @@
+// Benchmark de throughput del lexer (MB/s) sobre un fuente sintético grande.
+//
+// Compilar (desde la raíz del repo):
+//   cc -std=c99 -O2 -Iinclude bench/lexer_bench.c src/token.c src/lexer.c -o lexer_bench
+// Uso:
+//   ./lexer_bench [MB] [repeticiones]      (por defecto 32 MB, 5 repeticiones)
+
+#include "../include/lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Fragmento representativo: keywords, identificadores, números, strings y comentarios.
+static const char *SNIPPET =
+    "*-- comentario de línea\n"
+    "const limite : int = 1000;\n"
+    "variable total : float = 0.5;\n"
+    "Function acumula(n: int, paso: float) -> float {\n"
+    "    variable suma : float = 0.0;\n"
+    "    for (variable i : int = 0; i < n; i += 1) {\n"
+    "        if (i % 2 == 0 && paso >= 0.25) { suma += paso * 2.0; } else { continue; }\n"
+    "        /* bloque */ if (suma > 1e3) { break; }\n"
+    "    }\n"
+    "    return suma;\n"
+    "}\n"
+    "Function main() -> void {\n"
+    "    const ok : bool = true; variable msg : string = \"hola\\tmundo\\n\";\n"
+    "    print(acumula(limite, total), msg, ok != false);\n"
+    "}\n";
+
+// Búsqueda lineal original (referencia para comparar con token_keyword_lookup).
+static token_type linear_lookup(const char *ident, size_t len){
+    static const struct { const char *kw; token_type t; } KW[] = {
+        {"Function", TOK_Function}, {"variable", TOK_VARIABLE}, {"const", TOK_CONST},
+        {"return", TOK_RETURN}, {"for", TOK_FOR}, {"if", TOK_IF}, {"else", TOK_ELSE},
+        {"break", TOK_BREAK}, {"continue", TOK_CONTINUE}, {"int", TOK_INT},
+        {"bool", TOK_BOOL}, {"float", TOK_FLOAT}, {"string", TOK_STRING},
+        {"true", TOK_TRUE}, {"false", TOK_FALSE},
+    };
+    for(size_t i=0;i<sizeof(KW)/sizeof(KW[0]);i++){
+        if(strlen(KW[i].kw)==len && strncmp(ident, KW[i].kw, len)==0) return KW[i].t;
+    }
+    return TOK_IDENT;
+}
+
+static double seconds(void){ return (double)clock() / (double)CLOCKS_PER_SEC; }
+
+int main(int argc, char **argv){
+    size_t mb = argc > 1 ? (size_t)atoi(argv[1]) : 32u;
+    int reps = argc > 2 ? atoi(argv[2]) : 5;
+    if(mb == 0) mb = 1;
+    if(reps <= 0) reps = 1;
+
+    size_t snip = strlen(SNIPPET), target = mb * 1024u * 1024u;
+    size_t copies = target / snip + 1u, len = copies * snip;
+    char *src = (char*)malloc(len + 1u);
+    if(!src){ fprintf(stderr, "sin memoria\n"); return 1; }
+    for(size_t i=0;i<copies;i++) memcpy(src + i*snip, SNIPPET, snip);
+    src[len] = '\0';
+
+    // 1) lexer completo
+    double best = 1e30; size_t ntok = 0, nident = 0;
+    for(int r=0;r<reps;r++){
+        lexer_t lx; lexer_init(&lx, src, len);
+        size_t n = 0, ni = 0;
+        double t0 = seconds();
+        for(;;){
+            token_t t = lexer_next_token(&lx);
+            n++;
+            if(t.type == TOK_IDENT || (t.type >= TOK_VARIABLE && t.type <= TOK_FALSE)) ni++;
+            if(t.type == TOK_EOF) break;
+        }
+        double dt = seconds() - t0;
+        if(dt < best) best = dt;
+        ntok = n; nident = ni;
+    }
+    double mbs = (double)len / (1024.0*1024.0);
+    printf("lexer: %.1f MB, %zu tokens, mejor %.3f s, %.1f MB/s, %.1f Mtok/s\n",
+           mbs, ntok, best, mbs / best, (double)ntok / best / 1e6);
+
+    // 2) sólo el lookup de keywords sobre los identificadores del fuente
+    lexer_t lx; lexer_init(&lx, src, len);
+    const char **ids = (const char**)malloc(nident * sizeof(char*));
+    size_t *lens = (size_t*)malloc(nident * sizeof(size_t));
+    if(!ids || !lens){ fprintf(stderr, "sin memoria\n"); return 1; }
+    size_t k = 0;
+    for(;;){
+        token_t t = lexer_next_token(&lx);
+        if(t.type == TOK_EOF) break;
+        if(k < nident && (t.type == TOK_IDENT || (t.type >= TOK_VARIABLE && t.type <= TOK_FALSE))){
+            ids[k] = t.lexeme; lens[k] = t.length; k++;
+        }
+    }
+    volatile unsigned sink = 0;
+    double t0 = seconds();
+    for(size_t i=0;i<k;i++) sink += (unsigned)linear_lookup(ids[i], lens[i]);
+    double t_lin = seconds() - t0;
+    t0 = seconds();
+    for(size_t i=0;i<k;i++) sink += (unsigned)token_keyword_lookup(ids[i], lens[i]);
+    double t_sw = seconds() - t0;
+    printf("keywords: %zu identificadores, lineal %.1f ns/id, switch %.1f ns/id (x%.1f)\n",
+           k, t_lin * 1e9 / (double)k, t_sw * 1e9 / (double)k, t_sw > 0 ? t_lin / t_sw : 0.0);
+
+    free(ids); free(lens); free(src);
+    return 0;
+}
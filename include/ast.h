@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include "value.h"
 
 // -------------------- Tipos de Celer --------------------
 typedef enum {
@@ -10,7 +11,11 @@ typedef enum {
     TYPE_INT,
     TYPE_BOOL,
     TYPE_FLOAT,
-    TYPE_STRING
+    TYPE_STRING,
+    TYPE_ARRAY_INT,   // int[]
+    TYPE_ARRAY_FLOAT, // float[]
+    TYPE_ARRAY_BOOL,  // bool[]
+    TYPE_UNKNOWN      // sin tipo estático conocido (ver typecheck.h)
 } type_kind;
 
 typedef struct {
@@ -19,6 +24,21 @@ typedef struct {
 
 // Helpers
 static inline type_spec type_make(type_kind k) { type_spec t; t.kind = k; return t; }
+static inline bool type_is_array(type_kind k) { return k >= TYPE_ARRAY_INT && k <= TYPE_ARRAY_BOOL; }
+// T[] <-> T (TYPE_UNKNOWN si no hay)
+static inline type_kind type_array_of(type_kind elem) {
+    return elem == TYPE_INT ? TYPE_ARRAY_INT : elem == TYPE_FLOAT ? TYPE_ARRAY_FLOAT
+         : elem == TYPE_BOOL ? TYPE_ARRAY_BOOL : TYPE_UNKNOWN;
+}
+static inline type_kind type_elem_of(type_kind arr) {
+    return arr == TYPE_ARRAY_INT ? TYPE_INT : arr == TYPE_ARRAY_FLOAT ? TYPE_FLOAT
+         : arr == TYPE_ARRAY_BOOL ? TYPE_BOOL : TYPE_UNKNOWN;
+}
+// value_kind de los elementos de un tipo array (VAL_VOID si no lo es)
+static inline value_kind type_elem_value(type_kind arr) {
+    return arr == TYPE_ARRAY_INT ? VAL_INT : arr == TYPE_ARRAY_FLOAT ? VAL_FLOAT
+         : arr == TYPE_ARRAY_BOOL ? VAL_BOOL : VAL_VOID;
+}
 
 // -------------------- Forward decls --------------------
 typedef struct expr expr;
@@ -38,7 +58,10 @@ typedef enum {
     EXPR_ASSIGN,       // name op= value  (op puede ser =, +=, etc.)
     EXPR_GROUPING,     // (expr)
     EXPR_TERNARY,      // ¿cond? { true: a : false: b }
-    EXPR_CALL          // callee(args...)
+    EXPR_CALL,         // callee(args...)
+    EXPR_ARRAY,        // [a, b, ...]
+    EXPR_INDEX,        // target[index]
+    EXPR_INDEX_ASSIGN  // target[index] op= value
 } expr_kind;
 
 // Operadores soportados
@@ -67,25 +90,36 @@ typedef struct {
 struct expr {
     expr_kind kind;
     int line, col; // ubicación aproximada
+    type_kind type; // tipo estático garantizado (typecheck); TYPE_UNKNOWN si no
 
     union {
-        struct { char *name; } ident;
+        struct { char *name; int depth, slot; } ident; // depth<0 => global (por nombre)
 
         struct { long long value; } int_lit;
         struct { double value; } float_lit;
         struct { bool value; } bool_lit;
-        struct { char *text; } string_lit;
+        struct { char *text; value_t value; } string_lit; // text ya decodificado
 
         struct { op_kind op; expr *right; } unary;
         struct { expr *left; op_kind op; expr *right; } binary;
 
-        struct { char *name; op_kind op; expr *value; } assign;  // lvalue =/+= ... value
+        struct { char *name; op_kind op; expr *value; int depth, slot;
+                 type_spec decl_type; } assign;  // lvalue =/+= ... value; decl_type: de `variable x : T` en bloque
 
         struct { expr *inner; } grouping;
 
         struct { expr *cond; expr *when_true; expr *when_false; } ternary;
 
-        struct { expr *callee; expr_vec args; } call; // callee puede ser IDENT u otra expr
+        struct { expr *callee; expr_vec args;   // callee puede ser IDENT u otra expr
+                 // enlace resuelto por eval.c; vale mientras epoch == env_bind_epoch()
+                 struct { struct func_decl *fn; value_t (*builtin)(int, value_t*); unsigned epoch; } bind;
+               } call;
+
+        struct { expr_vec items; } array;
+
+        struct { expr *target; expr *index; } index;
+
+        struct { expr *target; expr *index; op_kind op; expr *value; } index_assign;
     } as;
 };
 
@@ -124,7 +158,7 @@ struct stmt {
         struct { /* vacío */ int _; } brk;
         struct { /* vacío */ int _2; } cont;
 
-        struct { stmt_vec stmts; } block;
+        struct { stmt_vec stmts; int nslots; } block; // nslots: lo fija el resolver
 
         struct { expr *cond; stmt *then_branch; stmt *else_branch; } if_stmt;
 
@@ -153,12 +187,14 @@ typedef struct {
     int line, col;
 } var_decl;
 
-typedef struct {
+typedef struct func_decl {
     char *name;
     param_vec params;
     type_spec ret_type;
     stmt *body; // un bloque obligatorio
     int line, col;
+    unsigned calls;          // llamadas contadas por el JIT (ver jit.h)
+    struct jit_fn *native;   // código nativo o intento fallido; NULL si no se intentó
 } func_decl;
 
 struct decl {
@@ -175,47 +211,62 @@ typedef struct {
     size_t cap;
 } decl_vec;
 
+// Arena del AST: todos los nodos, nombres y vectores de un programa se
+// reservan aquí por bump y se liberan juntos con program_free.
+typedef struct ast_arena ast_arena;
+
+ast_arena *ast_arena_new(void);
+void      *ast_arena_alloc(ast_arena *a, size_t n); // memoria en cero
+char      *ast_arena_strdup(ast_arena *a, const char *s);
+// Interna [s, s+n) en la arena: nombres iguales comparten el mismo puntero
+// (null-terminated). Los constructores internan todos los nombres.
+char      *ast_intern(ast_arena *a, const char *s, size_t n);
+void       ast_arena_free(ast_arena *a);
+
 typedef struct {
     decl_vec decls;
+    ast_arena *arena; // dueño de todo el AST
 } program_ast;
 
 // --------------- API: constructores y utils ------------
-expr *expr_ident(const char *name, int line, int col);
-expr *expr_int(long long v, int line, int col);
-expr *expr_float(double v, int line, int col);
-expr *expr_bool(bool v, int line, int col);
-expr *expr_string(const char *text, int line, int col);
-expr *expr_unary(op_kind op, expr *right, int line, int col);
-expr *expr_binary(expr *left, op_kind op, expr *right, int line, int col);
-expr *expr_assign(const char *name, op_kind op, expr *value, int line, int col);
-expr *expr_group(expr *inner, int line, int col);
-expr *expr_ternary(expr *cond, expr *when_true, expr *when_false, int line, int col);
-expr *expr_call(expr *callee, int line, int col);
-
-void expr_args_push(expr *call_expr, expr *arg);
-
-stmt *stmt_expr_stmt(expr *e, int line, int col);
-stmt *stmt_return(expr *e, int line, int col);
-stmt *stmt_break(int line, int col);
-stmt *stmt_continue(int line, int col);
-stmt *stmt_block(void);
-void  stmt_block_push(stmt *block, stmt *s);
-stmt *stmt_if(expr *cond, stmt *then_branch, stmt *else_branch, int line, int col);
-stmt *stmt_for_while(expr *cond, stmt *body, int line, int col);
-stmt *stmt_for_clike(stmt *init, expr *cond, expr *post, stmt *body, int line, int col);
-
-decl *decl_var(const char *name, bool is_const, type_spec t, expr *init, int line, int col);
-decl *decl_func(const char *name, type_spec ret_type, int line, int col);
-void  decl_func_param_push(decl *fn, const char *name, type_spec t);
+expr *expr_ident(ast_arena *a, const char *name, int line, int col);
+expr *expr_int(ast_arena *a, long long v, int line, int col);
+expr *expr_float(ast_arena *a, double v, int line, int col);
+expr *expr_bool(ast_arena *a, bool v, int line, int col);
+expr *expr_string(ast_arena *a, const char *text, int line, int col);
+expr *expr_unary(ast_arena *a, op_kind op, expr *right, int line, int col);
+expr *expr_binary(ast_arena *a, expr *left, op_kind op, expr *right, int line, int col);
+expr *expr_assign(ast_arena *a, const char *name, op_kind op, expr *value, int line, int col);
+expr *expr_group(ast_arena *a, expr *inner, int line, int col);
+expr *expr_ternary(ast_arena *a, expr *cond, expr *when_true, expr *when_false, int line, int col);
+expr *expr_call(ast_arena *a, expr *callee, int line, int col);
+
+expr *expr_array(ast_arena *a, int line, int col);
+expr *expr_index(ast_arena *a, expr *target, expr *index, int line, int col);
+expr *expr_index_assign(ast_arena *a, expr *target, expr *index, op_kind op, expr *value, int line, int col);
+
+void expr_args_push(ast_arena *a, expr *call_expr, expr *arg);
+void expr_array_push(ast_arena *a, expr *array_expr, expr *item);
+
+stmt *stmt_expr_stmt(ast_arena *a, expr *e, int line, int col);
+stmt *stmt_return(ast_arena *a, expr *e, int line, int col);
+stmt *stmt_break(ast_arena *a, int line, int col);
+stmt *stmt_continue(ast_arena *a, int line, int col);
+stmt *stmt_block(ast_arena *a);
+void  stmt_block_push(ast_arena *a, stmt *block, stmt *s);
+stmt *stmt_if(ast_arena *a, expr *cond, stmt *then_branch, stmt *else_branch, int line, int col);
+stmt *stmt_for_while(ast_arena *a, expr *cond, stmt *body, int line, int col);
+stmt *stmt_for_clike(ast_arena *a, stmt *init, expr *cond, expr *post, stmt *body, int line, int col);
+
+decl *decl_var(ast_arena *a, const char *name, bool is_const, type_spec t, expr *init, int line, int col);
+decl *decl_func(ast_arena *a, const char *name, type_spec ret_type, int line, int col);
+void  decl_func_param_push(ast_arena *a, decl *fn, const char *name, type_spec t);
 void  decl_func_set_body(decl *fn, stmt *body);
 
 program_ast program_make(void);
 void program_push_decl(program_ast *p, decl *d);
 
-// Liberación profunda
-void expr_free(expr *e);
-void stmt_free(stmt *s);
-void decl_free(decl *d);
+// Libera el programa completo (la arena entera)
 void program_free(program_ast *p);
 
 // Pretty print (para depuración)
@@ -0,0 +1,91 @@
+#ifndef BYTECODE_H_
+#define BYTECODE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "ast.h"
+#include "env.h"
+#include "value.h"
+
+// Juego de instrucciones de la VM de pila.
+// Operandos: u16 little-endian a continuación del opcode (k = constante,
+// s = slot del frame, n = cantidad, off = salto relativo al final de la instrucción,
+// i = inmediato int con signo de 16 bits).
+#define BC_OPCODES(X) \
+    X(BC_CONST)          /* k        push consts[k]                    */ \
+    X(BC_VOID)           /*          push void                         */ \
+    X(BC_POP)            /*          descarta el tope                  */ \
+    X(BC_SWAP)           /*          intercambia los dos del tope      */ \
+    X(BC_GET_LOCAL)      /* s        push slots[s]                     */ \
+    X(BC_SET_LOCAL)      /* s        slots[s] = tope (no lo saca)      */ \
+    X(BC_CLEAR)          /* s n      slots[s..s+n) = void              */ \
+    X(BC_GET_GLOBAL)     /* k        push global por nombre            */ \
+    X(BC_SET_GLOBAL)     /* k        set (o define) global, no saca    */ \
+    X(BC_DEFINE_GLOBAL)  /* k        define global mutable, saca       */ \
+    X(BC_DEFINE_CONST)   /* k        define global const, saca         */ \
+    X(BC_ADD) X(BC_SUB) X(BC_MUL) X(BC_DIV) X(BC_MOD)                     \
+    X(BC_EQ) X(BC_NEQ) X(BC_LT) X(BC_LTE) X(BC_GT) X(BC_GTE)              \
+    X(BC_NOT) X(BC_NEG)                                                   \
+    X(BC_JUMP)           /* off      salto hacia adelante              */ \
+    X(BC_JUMP_IF_FALSE)  /* off      saca la condición                 */ \
+    X(BC_JUMP_IF_TRUE)   /* off      saca la condición                 */ \
+    X(BC_LOOP)           /* off      salto hacia atrás                 */ \
+    X(BC_CALL)           /* f n      llama a funcs[f] con n args       */ \
+    X(BC_TAILCALL)       /* f n      return funcs[f](...) en el frame actual */ \
+    X(BC_CALL_BUILTIN)   /* b n      llama a builtins[b]               */ \
+    X(BC_POPN)           /* n        descarta n valores                */ \
+    X(BC_ARRAY)          /* n k      saca n valores, push el array (k = value_kind; void: se deduce) */ \
+    X(BC_INDEX)          /*          saca i, a; push a[i]              */ \
+    X(BC_SET_INDEX)      /* op       saca v, i, a; a[i] op= v; push el elemento */ \
+    X(BC_RETURN)         /*          retorna el tope                   */ \
+    X(BC_HALT)                                                            \
+    /* superinstrucciones tipadas: el checker garantiza operandos int     */ \
+    X(BC_GET_LOCAL_RAW)  /* s        push slots[s] escalar (sin refcount) */ \
+    X(BC_ADD_I) X(BC_SUB_I) X(BC_MUL_I) X(BC_DIV_I) X(BC_MOD_I)           \
+    X(BC_EQ_I) X(BC_NEQ_I) X(BC_LT_I) X(BC_LTE_I) X(BC_GT_I) X(BC_GTE_I)  \
+    X(BC_ADD_IMM_I)      /* i        tope += i (i16)                      */ \
+    X(BC_INC_LOCAL_I)    /* s i      slots[s] += i (i16), no apila        */ \
+    X(BC_JUMP_IF_NOT_LT_I)  /* off   saca b, a; salta si !(a <  b)        */ \
+    X(BC_JUMP_IF_NOT_LTE_I) /* off   saca b, a; salta si !(a <= b)        */ \
+    X(BC_JUMP_IF_NOT_GT_I)  /* off   saca b, a; salta si !(a >  b)        */ \
+    X(BC_JUMP_IF_NOT_GTE_I) /* off   saca b, a; salta si !(a >= b)        */ \
+    X(BC_JUMP_IF_NOT_EQ_I)  /* off   saca b, a; salta si !(a == b)        */ \
+    X(BC_JUMP_IF_NOT_NEQ_I) /* off   saca b, a; salta si !(a != b)        */
+
+typedef enum {
+#define BC_ENUM(op) op,
+    BC_OPCODES(BC_ENUM)
+#undef BC_ENUM
+    BC__COUNT
+} bc_op;
+
+typedef struct {
+    uint8_t *code; size_t count, cap;
+    int *lines;                 // línea de origen por byte (errores)
+} bc_chunk;
+
+typedef struct {
+    const char *name;           // vive en el AST
+    func_decl *decl;            // origen (para el JIT); NULL en el script
+    int arity;
+    int nslots;                 // parámetros + locales (plano)
+    int max_stack;              // temporales máximos sobre los slots
+    bc_chunk chunk;
+} bc_function;
+
+typedef struct {
+    bc_function *funcs;   size_t funcs_count, funcs_cap;
+    value_t *consts;      size_t consts_count, consts_cap;
+    builtin_fn *builtins; size_t builtins_count, builtins_cap;
+    bc_function script;         // inicializa globales y llama a main()
+} bc_program;
+
+// Compila un programa ya resuelto (ver resolver.h). `global` aporta los builtins.
+// En error devuelve false y deja un mensaje en err.
+bool bc_compile_program(const program_ast *P, env_t *global, bc_program *out, char *err, size_t errlen);
+void bc_program_free(bc_program *prog);
+
+const char *bc_op_name(bc_op op);
+
+#endif /* BYTECODE_H_ */
@@ -0,0 +1,26 @@
+#ifndef EMITC_H_
+#define EMITC_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ast.h"
+
+// Traductor AOT: escribe en `out` una unidad C99 autónoma equivalente al
+// programa (ya resuelto, chequeado y, si se quiere, optimizado). Cada Function
+// pasa a una función de C y los globales a variables estáticas; `main` de C
+// inicializa los globales en orden y llama a la `main` de Celer.
+//
+// Los valores viajan en un cel_v etiquetado que replica la semántica de
+// value.c (división entera por cero = 0, igualdad float con tolerancia...);
+// las expresiones con tipo garantizado por el checker (int, float, bool) se
+// emiten sin etiqueta. El runtime va incluido en la salida: sólo hace falta
+// `cc -std=c99 -O2 prog.c -lm`.
+//
+// Diferencias con el intérprete: los strings concatenados y los arrays no se
+// liberan y el error de profundidad (exit 3) se reporta en la función llamada.
+// `max_depth` fija el CEL_MAX_DEPTH por defecto del programa generado.
+// Devuelve false si falló la escritura.
+bool emit_c_program(const program_ast *P, size_t max_depth, FILE *out);
+
+#endif /* EMITC_H_ */
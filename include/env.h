@@ -3,6 +3,7 @@
 
 #include "ast.h"
 #include "value.h"
+#include "stats.h"
 #include <stddef.h>
 #include <stdbool.h>
 
@@ -21,15 +22,33 @@ typedef struct env {
     struct env *parent;
     var_entry *vars;   size_t vars_count, vars_cap;
     func_entry *funcs; size_t funcs_count, funcs_cap;
+    value_t *slots;    size_t slots_count; // locales resueltos (ver resolver.h)
 } env_t;
 
 env_t *env_new(env_t *parent);
 void    env_free(env_t *e);
 
+// Frames de bloque/función: se toman de una pila preasignada (bump) y se
+// liberan en orden LIFO; no hacen malloc en estado estable.
+env_t *env_push_frame(env_t *parent, size_t nslots);
+void   env_pop_frame(env_t *e);
+env_t *env_root(env_t *e);                          // entorno global
+
+// slots: acceso directo (depth saltos hacia arriba, sin comparar nombres)
+static inline value_t *env_slot(env_t *e, int depth, int slot){
+    stats_lookup(depth);
+    while(depth-- > 0) e = e->parent;
+    return &e->slots[slot];
+}
+
+// Profundidad máxima de llamadas por defecto (evaluador y VM; ver --max-depth).
+#define CELER_MAX_DEPTH_DEFAULT 10000u
+
 // variables
 bool env_define_var(env_t *e, const char *name, bool is_const, value_t v);
 bool env_set_var   (env_t *e, const char *name, value_t v);          // respeta const
 bool env_get_var   (env_t *e, const char *name, value_t *out);
+bool env_has_var   (env_t *e, const char *name, bool *is_const);
 
 // funciones
 bool env_define_func(env_t *e, const char *name, func_decl *fn);
@@ -40,4 +59,8 @@ typedef value_t (*builtin_fn)(int argc, value_t *argv);
 bool env_define_builtin(env_t *e, const char *name, builtin_fn fn);
 builtin_fn env_get_builtin(env_t *e, const char *name);
 
+// Cambia cada vez que se define una función o builtin; los enlaces cacheados
+// en los nodos de llamada con otra época se vuelven a resolver.
+unsigned env_bind_epoch(void);
+
 #endif /* ENV_H_ */
@@ -11,6 +11,7 @@ typedef enum {
     SIG_RETURN,
     SIG_BREAK,
     SIG_CONTINUE,
+    SIG_TAILCALL,      // interno: `return f(...)` pendiente de ejecutar
     SIG_RUNTIME_ERROR
 } eval_signal;
 
@@ -22,4 +23,15 @@ typedef struct {
 eval_result eval_program(env_t *global, const program_ast *P);
 // si existe Function main() -> void, la invoca automáticamente
 
+// builtins (print, len, push...) en el entorno global; idempotente
+void eval_register_builtins(env_t *global);
+
+// Error pendiente del último builtin (mensaje estático) o NULL; lo limpia.
+// Un builtin no conoce su línea: lo reporta quien lo llamó (evaluador o VM).
+const char *eval_builtin_error(void);
+
+// Profundidad máxima de llamadas anidadas (las de cola no cuentan).
+// Al superarla eval_program reporta un error de ejecución y devuelve SIG_RUNTIME_ERROR.
+void eval_set_max_depth(size_t n);
+
 #endif /* EVAL_H_ */
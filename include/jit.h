@@ -0,0 +1,38 @@
+#ifndef JIT_H_
+#define JIT_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "ast.h"
+#include "env.h"
+#include "value.h"
+
+// JIT de base a x86-64 (Linux). Una función se compila a código nativo cuando
+// sus llamadas cruzan CELER_JIT_THRESHOLD, si todo lo que toca es int, float
+// o bool con tipo garantizado por el checker: locales, aritmética,
+// comparaciones, &&/||/!, ternarios, if/for/break/continue/return y llamadas a
+// otras funciones que también compilen. Strings, globales, builtins o
+// cualquier otra cosa dejan la función en el intérprete.
+//
+// El código nativo no tiene efectos fuera de su propia pila, así que ante un
+// imprevisto (profundidad, pila nativa, caer al final sin return) abandona y
+// el intérprete repite la llamada desde el principio. Una función que abandonó
+// ya no vuelve a entrar a código nativo desde el intérprete.
+#define CELER_JIT_THRESHOLD 50u
+
+// Activa el JIT; `global` resuelve los nombres de las llamadas. Sin soporte
+// en la plataforma no hace nada.
+void jit_enable(env_t *global);
+bool jit_available(void);
+// Con `on`, informa en stderr qué funciones pasan a código nativo y cuáles no.
+void jit_set_log(bool on);
+
+// Cuenta una llamada a fn y, si tiene código nativo, la ejecuta con argv
+// (que no consume). `depth` son las llamadas ya en curso. Devuelve false si
+// la llamada debe ir al intérprete.
+bool jit_call(func_decl *fn, const value_t *argv, int argc, size_t depth, size_t max_depth, value_t *out);
+
+// Libera el código generado.
+void jit_release(void);
+
+#endif /* JIT_H_ */
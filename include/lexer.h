@@ -9,7 +9,7 @@ typedef struct {
     size_t len;
     size_t pos;   // índice actual (0..len)
     int line;     // 1..N
-    int col;      // 1..N
+    size_t line_start; // índice del primer byte de la línea actual (col = pos - line_start + 1)
 } lexer_t;
 
 // Inicializa el lexer con un buffer y longitud.
@@ -19,6 +19,7 @@ void lexer_init(lexer_t *lx, const char *src, size_t len);
 void lexer_from_cstr(lexer_t *lx, const char *src);
 
 // Obtiene el siguiente token (incluye EOF). En errores léxicos retorna TOK_ILLEGAL y avanza.
+// El lexema del token apunta dentro de `src`, que debe seguir vivo mientras se use.
 token_t lexer_next_token(lexer_t *lx);
 
 #endif /* LEXER_H_ */
@@ -0,0 +1,28 @@
+#ifndef OPTIMIZER_H_
+#define OPTIMIZER_H_
+
+#include "ast.h"
+#include "env.h"
+
+// Tamaño máximo (en nodos) del `return` de una función para expandirla.
+#define CELER_INLINE_MAX_NODES 16
+
+// Pasada de optimización sobre el AST ya resuelto (ver resolver.h):
+//  - pliega subárboles literales (unarios, binarios, ternarios y agrupaciones)
+//    con las mismas operaciones de value.h que usa el evaluador;
+//  - elimina los nodos de agrupación (sólo sirven al parser);
+//  - propaga los `const` globales cuyo inicializador queda literal;
+//  - saca de los bucles `for` las subexpresiones invariantes (LICM) y cambia
+//    `i * k` por un acumulador cuando `i` avanza con un paso constante; los
+//    temporales son slots nuevos del bloque que contiene al bucle.
+// Los nodos nuevos se reservan en la arena del programa.
+void optimize_program(program_ast *P);
+
+// Expande las llamadas a funciones pequeñas de la forma `{ return <expr>; }`
+// (no recursivas, sin asignaciones) sustituyendo los parámetros por los
+// argumentos cuando eso no cambia qué se evalúa ni en qué orden. `global`
+// aporta los builtins, que tienen prioridad sobre las funciones. Conviene
+// llamarla antes de optimize_program para que el plegado vea el resultado.
+void inline_program(program_ast *P, env_t *global);
+
+#endif /* OPTIMIZER_H_ */
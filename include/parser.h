@@ -21,6 +21,7 @@ typedef struct {
     token_t curr; // lookahead actual
     token_t prev; // último consumido (para ubicaciones)
     bool had_error;
+    ast_arena *arena; // arena del programa en construcción
 
     parse_error_list errors;
 } parser_t;
@@ -0,0 +1,53 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <signal.h>
+#include "ast.h"
+
+// Profiler por función (--profile). Por cada func_decl cuenta llamadas,
+// tiempo inclusivo y exclusivo (reloj monotónico) y reservas del runtime
+// (stats.h) hechas en su propio cuerpo; además acumula el tiempo exclusivo
+// por pila de llamadas para flame graphs.
+//
+// El evaluador y la VM llaman a los hooks sólo si g_prof_enabled. La
+// recursión no duplica el tiempo inclusivo (cuenta la activación exterior) y
+// una llamada de cola cierra la función actual antes de abrir la nueva.
+extern bool g_prof_enabled;
+
+void prof_enable(void);
+
+void prof_enter(const func_decl *fn);
+void prof_leave(void);
+void prof_tail(const func_decl *fn);   // prof_leave + prof_enter
+
+// Tabla ordenada por tiempo exclusivo. Cierra antes las llamadas que hayan
+// quedado abiertas (error de ejecución).
+void prof_report(FILE *out);
+
+// Pilas en formato "collapsed" (`main;fib;fib 1234`, microsegundos
+// exclusivos), la entrada de flamegraph.pl. Devuelve false si no pudo escribir.
+bool prof_write_collapsed(const char *path);
+
+// Libera todo (también las muestras) y desactiva el profiler.
+void prof_release(void);
+
+// ----- muestreo por línea (--sample) -----
+// Un temporizador SIGPROF (tiempo de CPU) sólo incrementa g_prof_sample; el
+// evaluador lo consulta al terminar cada sentencia simple y cada condición de
+// if/bucle, y la VM al descartar el valor de una sentencia, en saltos
+// condicionales y hacia atrás, llamadas y retornos. La muestra pendiente se
+// atribuye a la línea de ese punto.
+extern volatile sig_atomic_t g_prof_sample;
+
+// Arranca el temporizador; false si la plataforma no tiene SIGPROF.
+bool prof_sample_start(unsigned interval_us);
+void prof_sample_hit(int line);
+void prof_sample_stop(void);
+
+// Líneas con muestras, de más a menos, con el texto de `source`.
+void prof_sample_report(FILE *out, const char *source, size_t len);
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,20 @@
+#ifndef RESOLVER_H_
+#define RESOLVER_H_
+
+#include "ast.h"
+#include "env.h"
+
+// Pasada previa a eval: asigna a cada identificador local un par (depth, slot)
+// y a cada bloque su número de slots, de modo que las lecturas/escrituras de
+// locales sean accesos indexados sin comparar nombres.
+//
+// Reglas (iguales a las del evaluador):
+//  - cada función abre un frame con sus parámetros y cada bloque uno propio;
+//  - `x = ...` sobre un nombre inexistente (o sobre un global const) define x
+//    en el bloque actual;
+//  - lo que no es local queda con depth<0 y se busca por nombre en el global.
+//
+// `global` puede ser NULL; se usa para conocer globales ya definidos (REPL).
+void resolve_program(program_ast *P, env_t *global);
+
+#endif /* RESOLVER_H_ */
@@ -0,0 +1,62 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Contadores del runtime (--stats y el builtin stats()). value.c, env.c,
+// eval.c y ast.c reservan a través de estos envoltorios; el tamaño se pasa
+// también al liberar para llevar los bytes vivos sin cabeceras.
+typedef struct {
+    unsigned long long allocs, frees;   // realloc cuenta como liberación + reserva
+    unsigned long long bytes;           // total pedido
+    size_t live_bytes, peak_bytes;
+    unsigned long long frames;          // entornos creados (env_new y frames de bloque)
+    unsigned long long lookups, hops;   // accesos a variables y saltos por la cadena
+} celer_stats;
+
+extern celer_stats g_stats;
+
+static inline void stats_on_alloc(size_t n){
+    g_stats.allocs++;
+    g_stats.bytes += n;
+    if((g_stats.live_bytes += n) > g_stats.peak_bytes) g_stats.peak_bytes = g_stats.live_bytes;
+}
+static inline void stats_on_free(size_t n){ g_stats.frees++; g_stats.live_bytes -= n; }
+
+static inline void *stats_malloc(size_t n){
+    void *p = malloc(n);
+    if(p) stats_on_alloc(n);
+    return p;
+}
+static inline void *stats_calloc(size_t k, size_t n){
+    void *p = calloc(k, n);
+    if(p) stats_on_alloc(k * n);
+    return p;
+}
+// `old` es el tamaño actual de `p` (0 si es NULL)
+static inline void *stats_realloc(void *p, size_t old, size_t n){
+    void *q = realloc(p, n);
+    if(q){ if(p) stats_on_free(old); stats_on_alloc(n); }
+    return q;
+}
+static inline void stats_free(void *p, size_t n){
+    if(!p) return;
+    stats_on_free(n);
+    free(p);
+}
+
+// Un acceso a variable que sube `hops` entornos.
+static inline void stats_lookup(int hops){ g_stats.lookups++; g_stats.hops += (unsigned long long)hops; }
+
+// Valor de un contador por nombre ("allocs", "peak_bytes"...; "avg_depth" es
+// hops/lookups); false si no existe.
+bool stats_get(const char *name, double *out);
+
+// Resumen de una línea (`allocs=... bytes=...`) y el reporte de --stats.
+void stats_summary(char *buf, size_t n);
+void stats_report(FILE *out);
+
+#endif /* STATS_H_ */
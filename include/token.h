@@ -76,28 +76,33 @@ typedef enum {
 } token_type;
 
 // Estructura base de token.
+// El lexema es una vista [lexeme, lexeme+length) sobre el buffer fuente (o un
+// literal estático): NO termina en '\0' y no se reserva memoria por token.
 typedef struct {
     token_type type;
-    char *lexeme;       // Copia propia y null-terminated
-    size_t length;      // Longitud del lexema (sin el '\0')
+    const char *lexeme; // vista, no propia
+    size_t length;      // Longitud del lexema
     int line;           // 1..N
     int column;         // 1..N (columna del primer carácter)
 } token_t;
 
 // --- API ---
 
-// Crea un token duplicando [start, start+length).
+// Crea un token que referencia [start, start+length) (sin copiar).
 token_t token_make(token_type type, const char *start, size_t length, int line, int column);
 
-// Crea un token desde un C-string (usa strlen internamente).
+// Crea un token desde un C-string estático o de vida suficiente (usa strlen).
 token_t token_from_cstr(token_type type, const char *cstr, int line, int column);
 
-// Copia profunda.
+// Copia (la vista se comparte).
 token_t token_copy(const token_t *src);
 
-// Libera la memoria interna (lexeme) y pone el token en estado neutro.
+// Pone el token en estado neutro (no hay memoria que liberar).
 void token_free(token_t *tok);
 
+// ¿El lexema es exactamente `cstr`?
+int token_lexeme_is(const token_t *tok, const char *cstr);
+
 // Retorna un nombre legible del tipo (const char* estático).
 const char *token_type_name(token_type t);
 
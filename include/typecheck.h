@@ -0,0 +1,33 @@
+#ifndef TYPECHECK_H_
+#define TYPECHECK_H_
+
+#include <stdbool.h>
+#include "ast.h"
+#include "env.h"
+#include "parser.h"
+
+// Chequeo de tipos estáticos sobre un AST ya resuelto (ver resolver.h).
+//
+// Anota cada expr con el tipo que tendrá SIEMPRE en ejecución (expr.type) o
+// TYPE_UNKNOWN si no se puede garantizar; el evaluador usa esa anotación para
+// elegir kernels monomórficos (int+int, float*float, concat de strings...).
+// Los tipos de variables se calculan por punto fijo: una variable pierde su
+// tipo si recibe un valor desconocido o de otro tipo.
+//
+// Reglas:
+//  - aritmética sobre int/float (int se promueve en mezclas), `+` entre strings,
+//    `%` sólo int, comparaciones de orden sólo numéricas;
+//  - inicializaciones, asignaciones, argumentos y returns deben coincidir con
+//    el tipo declarado; un literal int se acepta (y convierte) donde se
+//    espera float;
+//  - las llamadas a funciones del programa verifican aridad.
+//
+// `closed_world` indica que el programa es completo (archivo): los globales y
+// funciones no pueden redefinirse después. En el REPL debe ser false.
+// Los errores se agregan a `errs` con el mismo formato que los de parseo.
+// Devuelve true si no hubo errores.
+bool typecheck_program(program_ast *P, env_t *global, bool closed_world, parse_error_list *errs);
+
+void typecheck_errors_free(parse_error_list *errs);
+
+#endif /* TYPECHECK_H_ */
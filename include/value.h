@@ -1,22 +1,44 @@
 #ifndef VALUE_H_
 #define VALUE_H_
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef enum {
     VAL_VOID = 0,
     VAL_INT,
     VAL_BOOL,
     VAL_FLOAT,
-    VAL_STRING
+    VAL_STRING,
+    VAL_ARRAY
 } value_kind;
 
+// String inmutable con conteo de referencias: copiar un valor string sólo
+// incrementa refs; la longitud se guarda para no recorrer con strlen.
+typedef struct celer_str {
+    size_t refs;
+    size_t len;
+    char data[];  // terminado en '\0'
+} celer_str;
+
+// Array contiguo de int, float o bool: los elementos se guardan sin caja
+// (long long, double o un byte) en un bloque que crece al doble. Se comparte
+// por referencia con conteo: `b = a` no copia y `b[0] = 1` se ve desde `a`.
+// `elem` es VAL_VOID sólo en un [] sin tipo, que adopta el del primer push.
+typedef struct celer_array {
+    size_t refs;
+    value_kind elem;
+    size_t len, cap;
+    union { long long *i; double *f; unsigned char *b; } data;
+} celer_array;
+
 typedef struct {
     value_kind kind;
     union {
-        long long   i;
-        double      f;
-        bool        b;
-        char       *s; // heap (propiedad del valor)
+        long long    i;
+        double       f;
+        bool         b;
+        celer_str   *s; // compartido (refcount)
+        celer_array *a; // compartido (refcount)
     } as;
 } value_t;
 
@@ -26,6 +48,35 @@ value_t v_int(long long x);
 value_t v_float(double x);
 value_t v_bool(bool x);
 value_t v_string(const char *s);
+value_t v_string_n(const char *s, size_t n);
+// string construido en memoria ajena (arena) de value_str_bytes(n) bytes;
+// su dueño conserva una referencia, así que value_free nunca lo libera
+size_t  value_str_bytes(size_t n);
+value_t v_string_at(void *mem, const char *s, size_t n);
+
+static inline const char *value_str(const value_t *v){ return v->as.s ? v->as.s->data : ""; }
+static inline size_t value_strlen(const value_t *v){ return v->as.s ? v->as.s->len : 0u; }
+
+// arrays: las operaciones que pueden fallar devuelven un mensaje estático
+// (NULL si todo fue bien) para que quien llama lo reporte con su línea.
+value_t     v_array(value_kind elem, size_t cap);  // vacío, con lugar para cap elementos
+// Array con items[0..n); con elem VAL_VOID el tipo sale de los items (int y
+// float mezclados dan float[]).
+const char *value_array_from(value_kind elem, const value_t *items, size_t n, value_t *out);
+const char *value_index(const value_t *a, const value_t *i, value_t *out);            // out = a[i]
+const char *value_index_set(const value_t *a, const value_t *i, const value_t *v, value_t *stored); // a[i] = v
+const char *value_array_push(const value_t *a, const value_t *v);                     // crecimiento amortizado
+
+// Elemento i (< len) como value_t.
+static inline value_t value_array_get(const celer_array *a, size_t i){
+    value_t v; v.kind = a->elem;
+    switch(a->elem){
+        case VAL_INT:   v.as.i = a->data.i[i]; break;
+        case VAL_FLOAT: v.as.f = a->data.f[i]; break;
+        default:        v.as.b = a->data.b[i] != 0; break;
+    }
+    return v;
+}
 
 // utilidades
 void value_free(value_t *v);
@@ -34,9 +85,10 @@ const char *value_kind_name(value_kind k);
 
 // coerciones sencillas
 value_t value_to_bool(const value_t *v);   // 0/false/empty -> false
+bool    value_truthy(const value_t *v);    // lo mismo, como bool de C
 value_t value_to_float(const value_t *v);  // int->float, bool->0/1, string no permitido
 value_t value_to_int(const value_t *v);    // float trunc, bool->0/1, string no permitido
-char   *value_to_cstr(const value_t *v);   // genera string (heap) para print
+char   *value_to_cstr(const value_t *v);   // genera string (heap) para print; liberar con stats_free(s, strlen(s)+1)
 
 // operaciones (devuelven VAL_VOID con s==NULL si error de tipo)
 value_t value_add(const value_t *a, const value_t *b); // soporta int/float; string + string concat
@@ -0,0 +1,17 @@
+#ifndef VM_H_
+#define VM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "bytecode.h"
+#include "env.h"
+
+// Ejecuta el script compilado (globales + main()) sobre `global`.
+// Devuelve false si hubo error de ejecución (ya reportado en stderr).
+bool vm_run(const bc_program *prog, env_t *global);
+
+// Profundidad máxima de llamadas anidadas (por defecto CELER_MAX_DEPTH_DEFAULT).
+// Las pilas de la VM están en el heap; las llamadas de cola reutilizan el frame.
+void vm_set_max_depth(size_t n);
+
+#endif /* VM_H_ */
@@ -1,178 +1,308 @@
 #include "../include/ast.h"
+#include "../include/stats.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
-// ---------------- helpers ----------------
-static char *dup_cstr(const char *s){
-    if(!s){ char *z = (char*)malloc(1); if(z) z[0]='\0'; return z; }
+// ---------------- arena ----------------
+#define ARENA_BLOCK_BYTES (64u * 1024u)
+#define ARENA_ALIGN 16u
+
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t cap, used;
+    unsigned char *data;
+} arena_block;
+
+struct ast_arena {
+    arena_block *head; // bloque actual (lista hacia atrás)
+    char **names;      // tabla de internado (direccionamiento abierto)
+    size_t names_count, names_cap;
+};
+
+static arena_block *arena_block_new(size_t cap){
+    arena_block *b = (arena_block*)stats_malloc(sizeof(*b));
+    if(!b) return NULL;
+    b->data = (unsigned char*)stats_calloc(1, cap); // memoria ya en cero
+    if(!b->data){ stats_free(b, sizeof(*b)); return NULL; }
+    b->next = NULL; b->cap = cap; b->used = 0;
+    return b;
+}
+
+ast_arena *ast_arena_new(void){
+    return (ast_arena*)stats_calloc(1, sizeof(ast_arena));
+}
+
+void *ast_arena_alloc(ast_arena *a, size_t n){
+    n = (n + ARENA_ALIGN - 1u) & ~(size_t)(ARENA_ALIGN - 1u);
+    arena_block *b = a->head;
+    if(!b || b->used + n > b->cap){
+        size_t cap = n > ARENA_BLOCK_BYTES ? n : ARENA_BLOCK_BYTES;
+        arena_block *nb = arena_block_new(cap);
+        if(!nb) return NULL;
+        nb->next = b;
+        a->head = nb;
+        b = nb;
+    }
+    void *p = b->data + b->used;
+    b->used += n;
+    return p;
+}
+
+// Como realloc: si `ptr` es lo último asignado, crece en el sitio.
+static void *arena_grow(ast_arena *a, void *ptr, size_t old_n, size_t new_n){
+    arena_block *b = a->head;
+    if(ptr && b){
+        size_t old_r = (old_n + ARENA_ALIGN - 1u) & ~(size_t)(ARENA_ALIGN - 1u);
+        size_t new_r = (new_n + ARENA_ALIGN - 1u) & ~(size_t)(ARENA_ALIGN - 1u);
+        if((unsigned char*)ptr + old_r == b->data + b->used && b->used - old_r + new_r <= b->cap){
+            b->used = b->used - old_r + new_r;
+            return ptr;
+        }
+    }
+    void *p = ast_arena_alloc(a, new_n);
+    if(p && ptr && old_n) memcpy(p, ptr, old_n);
+    return p;
+}
+
+char *ast_arena_strdup(ast_arena *a, const char *s){
+    if(!s) s = "";
     size_t n = strlen(s);
-    char *p = (char*)malloc(n+1);
+    char *p = (char*)ast_arena_alloc(a, n+1);
     if(!p) return NULL;
     memcpy(p, s, n+1);
     return p;
 }
 
-static void *xrealloc(void *ptr, size_t newcap, size_t elem){
-    return realloc(ptr, newcap * elem);
+static size_t hash_bytes(const char *s, size_t n){
+    size_t h = 2166136261u; // FNV-1a
+    for(size_t i=0;i<n;i++){ h ^= (unsigned char)s[i]; h *= 16777619u; }
+    return h;
 }
 
-static void expr_vec_push(expr_vec *v, expr *e){
+char *ast_intern(ast_arena *a, const char *s, size_t n){
+    if(!s){ s = ""; n = 0; }
+    if((a->names_count + 1u) * 2u > a->names_cap){
+        size_t nc = a->names_cap ? a->names_cap * 2u : 64u;
+        char **nt = (char**)stats_calloc(nc, sizeof(char*));
+        if(!nt) return NULL;
+        for(size_t i=0;i<a->names_cap;i++){
+            char *k = a->names[i];
+            if(!k) continue;
+            size_t j = hash_bytes(k, strlen(k)) & (nc - 1u);
+            while(nt[j]) j = (j + 1u) & (nc - 1u);
+            nt[j] = k;
+        }
+        stats_free(a->names, a->names_cap * sizeof(char*));
+        a->names = nt; a->names_cap = nc;
+    }
+    size_t j = hash_bytes(s, n) & (a->names_cap - 1u);
+    for(char *k; (k = a->names[j]) != NULL; j = (j + 1u) & (a->names_cap - 1u)){
+        if(strncmp(k, s, n) == 0 && k[n] == '\0') return k;
+    }
+    char *p = (char*)ast_arena_alloc(a, n+1);
+    if(!p) return NULL;
+    memcpy(p, s, n);
+    p[n] = '\0';
+    a->names[j] = p;
+    a->names_count++;
+    return p;
+}
+
+void ast_arena_free(ast_arena *a){
+    if(!a) return;
+    stats_free(a->names, a->names_cap * sizeof(char*));
+    arena_block *b = a->head;
+    while(b){ arena_block *n = b->next; stats_free(b->data, b->cap); stats_free(b, sizeof(*b)); b = n; }
+    stats_free(a, sizeof(*a));
+}
+
+// ---------------- helpers ----------------
+static void expr_vec_push(ast_arena *a, expr_vec *v, expr *e){
     if(v->count == v->cap){
         size_t nc = v->cap ? v->cap*2u : 4u;
-        v->items = (expr**)xrealloc(v->items, nc, sizeof(expr*));
+        v->items = (expr**)arena_grow(a, v->items, v->cap*sizeof(expr*), nc*sizeof(expr*));
         v->cap = nc;
     }
     v->items[v->count++] = e;
 }
 
-static void stmt_vec_push(stmt_vec *v, stmt *s){
+static void stmt_vec_push(ast_arena *a, stmt_vec *v, stmt *s){
     if(v->count == v->cap){
         size_t nc = v->cap ? v->cap*2u : 4u;
-        v->items = (stmt**)xrealloc(v->items, nc, sizeof(stmt*));
+        v->items = (stmt**)arena_grow(a, v->items, v->cap*sizeof(stmt*), nc*sizeof(stmt*));
         v->cap = nc;
     }
     v->items[v->count++] = s;
 }
 
-static void param_vec_push(param_vec *v, const char *name, type_spec t){
+static void param_vec_push(ast_arena *a, param_vec *v, const char *name, type_spec t){
     if(v->count == v->cap){
         size_t nc = v->cap ? v->cap*2u : 4u;
-        v->items = (param_decl*)xrealloc(v->items, nc, sizeof(param_decl));
+        v->items = (param_decl*)arena_grow(a, v->items, v->cap*sizeof(param_decl), nc*sizeof(param_decl));
         v->cap = nc;
     }
-    v->items[v->count].name = dup_cstr(name);
+    v->items[v->count].name = ast_intern(a, name, name ? strlen(name) : 0u);
     v->items[v->count].type = t;
     v->count++;
 }
 
 // ---------------- expr ctor ----------------
-expr *expr_ident(const char *name, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_IDENT; e->line=line; e->col=col;
-    e->as.ident.name = dup_cstr(name);
+// Los literales nacen con su tipo; el resto queda TYPE_UNKNOWN hasta el checker.
+static expr *new_expr(ast_arena *a, expr_kind k, int line, int col){
+    expr *e = (expr*)ast_arena_alloc(a, sizeof(*e));
+    e->kind = k; e->line=line; e->col=col;
+    switch(k){
+        case EXPR_INT_LIT:    e->type = TYPE_INT; break;
+        case EXPR_FLOAT_LIT:  e->type = TYPE_FLOAT; break;
+        case EXPR_BOOL_LIT:   e->type = TYPE_BOOL; break;
+        case EXPR_STRING_LIT: e->type = TYPE_STRING; break;
+        default:              e->type = TYPE_UNKNOWN; break;
+    }
+    return e;
+}
+
+expr *expr_ident(ast_arena *a, const char *name, int line, int col){
+    expr *e = new_expr(a, EXPR_IDENT, line, col);
+    e->as.ident.name = ast_intern(a, name, name ? strlen(name) : 0u);
+    e->as.ident.depth = -1; e->as.ident.slot = -1;
     return e;
 }
-expr *expr_int(long long v, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_INT_LIT; e->line=line; e->col=col;
+expr *expr_int(ast_arena *a, long long v, int line, int col){
+    expr *e = new_expr(a, EXPR_INT_LIT, line, col);
     e->as.int_lit.value = v;
     return e;
 }
-expr *expr_float(double v, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_FLOAT_LIT; e->line=line; e->col=col;
+expr *expr_float(ast_arena *a, double v, int line, int col){
+    expr *e = new_expr(a, EXPR_FLOAT_LIT, line, col);
     e->as.float_lit.value = v;
     return e;
 }
-expr *expr_bool(bool v, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_BOOL_LIT; e->line=line; e->col=col;
+expr *expr_bool(ast_arena *a, bool v, int line, int col){
+    expr *e = new_expr(a, EXPR_BOOL_LIT, line, col);
     e->as.bool_lit.value = v;
     return e;
 }
-expr *expr_string(const char *text, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_STRING_LIT; e->line=line; e->col=col;
-    e->as.string_lit.text = dup_cstr(text);
+expr *expr_string(ast_arena *a, const char *text, int line, int col){
+    expr *e = new_expr(a, EXPR_STRING_LIT, line, col);
+    // el celer_str vive en la arena; su referencia propia nunca se suelta
+    size_t n = text ? strlen(text) : 0u;
+    e->as.string_lit.value = v_string_at(ast_arena_alloc(a, value_str_bytes(n)), text ? text : "", n);
+    e->as.string_lit.text = e->as.string_lit.value.as.s->data;
     return e;
 }
-expr *expr_unary(op_kind op, expr *right, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_UNARY; e->line=line; e->col=col;
+expr *expr_unary(ast_arena *a, op_kind op, expr *right, int line, int col){
+    expr *e = new_expr(a, EXPR_UNARY, line, col);
     e->as.unary.op = op; e->as.unary.right = right;
     return e;
 }
-expr *expr_binary(expr *left, op_kind op, expr *right, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_BINARY; e->line=line; e->col=col;
+expr *expr_binary(ast_arena *a, expr *left, op_kind op, expr *right, int line, int col){
+    expr *e = new_expr(a, EXPR_BINARY, line, col);
     e->as.binary.left = left; e->as.binary.op = op; e->as.binary.right = right;
     return e;
 }
-expr *expr_assign(const char *name, op_kind op, expr *value, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_ASSIGN; e->line=line; e->col=col;
-    e->as.assign.name = dup_cstr(name);
+expr *expr_assign(ast_arena *a, const char *name, op_kind op, expr *value, int line, int col){
+    expr *e = new_expr(a, EXPR_ASSIGN, line, col);
+    e->as.assign.name = ast_intern(a, name, name ? strlen(name) : 0u);
     e->as.assign.op = op;
     e->as.assign.value = value;
+    e->as.assign.depth = -1; e->as.assign.slot = -1;
+    e->as.assign.decl_type = type_make(TYPE_UNKNOWN);
     return e;
 }
-expr *expr_group(expr *inner, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_GROUPING; e->line=line; e->col=col;
+expr *expr_group(ast_arena *a, expr *inner, int line, int col){
+    expr *e = new_expr(a, EXPR_GROUPING, line, col);
     e->as.grouping.inner = inner;
     return e;
 }
-expr *expr_ternary(expr *cond, expr *when_true, expr *when_false, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_TERNARY; e->line=line; e->col=col;
+expr *expr_ternary(ast_arena *a, expr *cond, expr *when_true, expr *when_false, int line, int col){
+    expr *e = new_expr(a, EXPR_TERNARY, line, col);
     e->as.ternary.cond = cond;
     e->as.ternary.when_true = when_true;
     e->as.ternary.when_false = when_false;
     return e;
 }
-expr *expr_call(expr *callee, int line, int col){
-    expr *e = (expr*)calloc(1, sizeof(*e));
-    e->kind = EXPR_CALL; e->line=line; e->col=col;
+expr *expr_call(ast_arena *a, expr *callee, int line, int col){
+    expr *e = new_expr(a, EXPR_CALL, line, col);
     e->as.call.callee = callee;
     e->as.call.args.items = NULL; e->as.call.args.count=0; e->as.call.args.cap=0;
+    e->as.call.bind.fn = NULL; e->as.call.bind.builtin = NULL; e->as.call.bind.epoch = 0;
     return e;
 }
-void expr_args_push(expr *call_expr, expr *arg){
+void expr_args_push(ast_arena *a, expr *call_expr, expr *arg){
     if(!call_expr || call_expr->kind != EXPR_CALL) return;
-    expr_vec_push(&call_expr->as.call.args, arg);
+    expr_vec_push(a, &call_expr->as.call.args, arg);
+}
+expr *expr_array(ast_arena *a, int line, int col){
+    return new_expr(a, EXPR_ARRAY, line, col); // items vacío (arena en cero)
+}
+void expr_array_push(ast_arena *a, expr *array_expr, expr *item){
+    if(!array_expr || array_expr->kind != EXPR_ARRAY) return;
+    expr_vec_push(a, &array_expr->as.array.items, item);
+}
+expr *expr_index(ast_arena *a, expr *target, expr *index, int line, int col){
+    expr *e = new_expr(a, EXPR_INDEX, line, col);
+    e->as.index.target = target; e->as.index.index = index;
+    return e;
+}
+expr *expr_index_assign(ast_arena *a, expr *target, expr *index, op_kind op, expr *value, int line, int col){
+    expr *e = new_expr(a, EXPR_INDEX_ASSIGN, line, col);
+    e->as.index_assign.target = target; e->as.index_assign.index = index;
+    e->as.index_assign.op = op; e->as.index_assign.value = value;
+    return e;
 }
 
 // ---------------- stmt ctor ----------------
-stmt *stmt_expr_stmt(expr *e, int line, int col){
-    stmt *s = (stmt*)calloc(1, sizeof(*s));
+stmt *stmt_expr_stmt(ast_arena *a, expr *e, int line, int col){
+    stmt *s = (stmt*)ast_arena_alloc(a, sizeof(*s));
     s->kind = STMT_EXPR; s->line=line; s->col=col;
     s->as.expr_stmt.value = e;
     return s;
 }
-stmt *stmt_return(expr *e, int line, int col){
-    stmt *s = (stmt*)calloc(1, sizeof(*s));
+stmt *stmt_return(ast_arena *a, expr *e, int line, int col){
+    stmt *s = (stmt*)ast_arena_alloc(a, sizeof(*s));
     s->kind = STMT_RETURN; s->line=line; s->col=col;
     s->as.ret.value = e;
     return s;
 }
-stmt *stmt_break(int line, int col){
-    stmt *s = (stmt*)calloc(1, sizeof(*s));
+stmt *stmt_break(ast_arena *a, int line, int col){
+    stmt *s = (stmt*)ast_arena_alloc(a, sizeof(*s));
     s->kind = STMT_BREAK; s->line=line; s->col=col;
     return s;
 }
-stmt *stmt_continue(int line, int col){
-    stmt *s = (stmt*)calloc(1, sizeof(*s));
+stmt *stmt_continue(ast_arena *a, int line, int col){
+    stmt *s = (stmt*)ast_arena_alloc(a, sizeof(*s));
     s->kind = STMT_CONTINUE; s->line=line; s->col=col;
     return s;
 }
-stmt *stmt_block(void){
-    stmt *s = (stmt*)calloc(1, sizeof(*s));
+stmt *stmt_block(ast_arena *a){
+    stmt *s = (stmt*)ast_arena_alloc(a, sizeof(*s));
     s->kind = STMT_BLOCK; s->line=0; s->col=0;
     s->as.block.stmts.items=NULL; s->as.block.stmts.count=0; s->as.block.stmts.cap=0;
+    s->as.block.nslots=0;
     return s;
 }
-void stmt_block_push(stmt *block, stmt *st){
+void stmt_block_push(ast_arena *a, stmt *block, stmt *st){
     if(!block || block->kind != STMT_BLOCK) return;
-    stmt_vec_push(&block->as.block.stmts, st);
+    stmt_vec_push(a, &block->as.block.stmts, st);
 }
-stmt *stmt_if(expr *cond, stmt *then_branch, stmt *else_branch, int line, int col){
-    stmt *s = (stmt*)calloc(1, sizeof(*s));
+stmt *stmt_if(ast_arena *a, expr *cond, stmt *then_branch, stmt *else_branch, int line, int col){
+    stmt *s = (stmt*)ast_arena_alloc(a, sizeof(*s));
     s->kind = STMT_IF; s->line=line; s->col=col;
     s->as.if_stmt.cond = cond;
     s->as.if_stmt.then_branch = then_branch;
     s->as.if_stmt.else_branch = else_branch;
     return s;
 }
-stmt *stmt_for_while(expr *cond, stmt *body, int line, int col){
-    stmt *s = (stmt*)calloc(1, sizeof(*s));
+stmt *stmt_for_while(ast_arena *a, expr *cond, stmt *body, int line, int col){
+    stmt *s = (stmt*)ast_arena_alloc(a, sizeof(*s));
     s->kind = STMT_FOR_WHILELIKE; s->line=line; s->col=col;
     s->as.for_while.cond = cond;
     s->as.for_while.body = body;
     return s;
 }
-stmt *stmt_for_clike(stmt *init, expr *cond, expr *post, stmt *body, int line, int col){
-    stmt *s = (stmt*)calloc(1, sizeof(*s));
+stmt *stmt_for_clike(ast_arena *a, stmt *init, expr *cond, expr *post, stmt *body, int line, int col){
+    stmt *s = (stmt*)ast_arena_alloc(a, sizeof(*s));
     s->kind = STMT_FOR_CLIKE; s->line=line; s->col=col;
     s->as.for_clike.init = init;
     s->as.for_clike.cond = cond;
@@ -182,29 +312,29 @@ stmt *stmt_for_clike(stmt *init, expr *cond, expr *post, stmt *body, int line, i
 }
 
 // ---------------- decl ctor ----------------
-decl *decl_var(const char *name, bool is_const, type_spec t, expr *init, int line, int col){
-    decl *d = (decl*)calloc(1, sizeof(*d));
+decl *decl_var(ast_arena *a, const char *name, bool is_const, type_spec t, expr *init, int line, int col){
+    decl *d = (decl*)ast_arena_alloc(a, sizeof(*d));
     d->kind = DECL_VAR;
-    d->as.var.name = dup_cstr(name);
+    d->as.var.name = ast_intern(a, name, name ? strlen(name) : 0u);
     d->as.var.is_const = is_const;
     d->as.var.type = t;
     d->as.var.init = init;
     d->as.var.line = line; d->as.var.col = col;
     return d;
 }
-decl *decl_func(const char *name, type_spec ret_type, int line, int col){
-    decl *d = (decl*)calloc(1, sizeof(*d));
+decl *decl_func(ast_arena *a, const char *name, type_spec ret_type, int line, int col){
+    decl *d = (decl*)ast_arena_alloc(a, sizeof(*d));
     d->kind = DECL_FUNC;
-    d->as.func.name = dup_cstr(name);
+    d->as.func.name = ast_intern(a, name, name ? strlen(name) : 0u);
     d->as.func.ret_type = ret_type;
     d->as.func.params.items=NULL; d->as.func.params.count=0; d->as.func.params.cap=0;
     d->as.func.body = NULL;
     d->as.func.line = line; d->as.func.col = col;
     return d;
 }
-void decl_func_param_push(decl *fn, const char *name, type_spec t){
+void decl_func_param_push(ast_arena *a, decl *fn, const char *name, type_spec t){
     if(!fn || fn->kind != DECL_FUNC) return;
-    param_vec_push(&fn->as.func.params, name, t);
+    param_vec_push(a, &fn->as.func.params, name, t);
 }
 void decl_func_set_body(decl *fn, stmt *body){
     if(!fn || fn->kind != DECL_FUNC) return;
@@ -213,82 +343,24 @@ void decl_func_set_body(decl *fn, stmt *body){
 
 // ---------------- program ----------------
 program_ast program_make(void){
-    program_ast p; p.decls.items=NULL; p.decls.count=0; p.decls.cap=0; return p;
+    program_ast p; p.decls.items=NULL; p.decls.count=0; p.decls.cap=0;
+    p.arena=ast_arena_new();
+    return p;
 }
 void program_push_decl(program_ast *p, decl *d){
     if(p->decls.count == p->decls.cap){
         size_t nc = p->decls.cap ? p->decls.cap*2u : 4u;
-        p->decls.items = (decl**)xrealloc(p->decls.items, nc, sizeof(decl*));
+        p->decls.items = (decl**)arena_grow(p->arena, p->decls.items, p->decls.cap*sizeof(decl*), nc*sizeof(decl*));
         p->decls.cap = nc;
     }
     p->decls.items[p->decls.count++] = d;
 }
 
 // ---------------- free ----------------
-void expr_free(expr *e){
-    if(!e) return;
-    switch(e->kind){
-        case EXPR_IDENT: free(e->as.ident.name); break;
-        case EXPR_INT_LIT: case EXPR_FLOAT_LIT: case EXPR_BOOL_LIT: break;
-        case EXPR_STRING_LIT: free(e->as.string_lit.text); break;
-        case EXPR_UNARY: expr_free(e->as.unary.right); break;
-        case EXPR_BINARY: expr_free(e->as.binary.left); expr_free(e->as.binary.right); break;
-        case EXPR_ASSIGN: free(e->as.assign.name); expr_free(e->as.assign.value); break;
-        case EXPR_GROUPING: expr_free(e->as.grouping.inner); break;
-        case EXPR_TERNARY: expr_free(e->as.ternary.cond); expr_free(e->as.ternary.when_true); expr_free(e->as.ternary.when_false); break;
-        case EXPR_CALL:
-            expr_free(e->as.call.callee);
-            for(size_t i=0;i<e->as.call.args.count;i++) expr_free(e->as.call.args.items[i]);
-            free(e->as.call.args.items);
-            break;
-    }
-    free(e);
-}
-void stmt_free(stmt *s){
-    if(!s) return;
-    switch(s->kind){
-        case STMT_EXPR: expr_free(s->as.expr_stmt.value); break;
-        case STMT_RETURN: expr_free(s->as.ret.value); break;
-        case STMT_BREAK: case STMT_CONTINUE: break;
-        case STMT_BLOCK:
-            for(size_t i=0;i<s->as.block.stmts.count;i++) stmt_free(s->as.block.stmts.items[i]);
-            free(s->as.block.stmts.items);
-            break;
-        case STMT_IF:
-            expr_free(s->as.if_stmt.cond);
-            stmt_free(s->as.if_stmt.then_branch);
-            stmt_free(s->as.if_stmt.else_branch);
-            break;
-        case STMT_FOR_WHILELIKE:
-            expr_free(s->as.for_while.cond);
-            stmt_free(s->as.for_while.body);
-            break;
-        case STMT_FOR_CLIKE:
-            stmt_free(s->as.for_clike.init);
-            expr_free(s->as.for_clike.cond);
-            expr_free(s->as.for_clike.post);
-            stmt_free(s->as.for_clike.body);
-            break;
-    }
-    free(s);
-}
-void decl_free(decl *d){
-    if(!d) return;
-    if(d->kind == DECL_VAR){
-        free(d->as.var.name);
-        expr_free(d->as.var.init);
-    } else {
-        free(d->as.func.name);
-        for(size_t i=0;i<d->as.func.params.count;i++) free(d->as.func.params.items[i].name);
-        free(d->as.func.params.items);
-        stmt_free(d->as.func.body);
-    }
-    free(d);
-}
 void program_free(program_ast *p){
     if(!p) return;
-    for(size_t i=0;i<p->decls.count;i++) decl_free(p->decls.items[i]);
-    free(p->decls.items);
+    ast_arena_free(p->arena); // todo el AST de una vez
+    p->arena=NULL;
     p->decls.items=NULL; p->decls.count=p->decls.cap=0;
 }
 
@@ -300,6 +372,10 @@ static const char* tname(type_kind k){
         case TYPE_BOOL: return "bool";
         case TYPE_FLOAT: return "float";
         case TYPE_STRING: return "string";
+        case TYPE_ARRAY_INT: return "int[]";
+        case TYPE_ARRAY_FLOAT: return "float[]";
+        case TYPE_ARRAY_BOOL: return "bool[]";
+        case TYPE_UNKNOWN: return "?";
         default: return "?";
     }
 }
@@ -331,10 +407,40 @@ static const char* opname(op_kind op){
 
 static void indent(int n){ for(int i=0;i<n;i++) putchar(' '); }
 
+// imprime un string ya decodificado con sus escapes de Celer
+static void print_quoted(const char *s){
+    putchar('"');
+    for(; *s; s++){
+        switch(*s){
+            case '\n': fputs("\\n", stdout); break;
+            case '\t': fputs("\\t", stdout); break;
+            case '\\': fputs("\\\\", stdout); break;
+            case '\"': fputs("\\\"", stdout); break;
+            default: putchar(*s); break;
+        }
+    }
+    putchar('"');
+}
+
 static void print_expr(const expr *e, int ind);
 
+// " : tipo" cuando el checker lo conoce
+static const char *tsuffix(const expr *e){
+    switch(e->type){
+        case TYPE_VOID:   return " : void";
+        case TYPE_INT:    return " : int";
+        case TYPE_BOOL:   return " : bool";
+        case TYPE_FLOAT:  return " : float";
+        case TYPE_STRING: return " : string";
+        case TYPE_ARRAY_INT:   return " : int[]";
+        case TYPE_ARRAY_FLOAT: return " : float[]";
+        case TYPE_ARRAY_BOOL:  return " : bool[]";
+        default:          return "";
+    }
+}
+
 static void print_call(const expr *e, int ind){
-    indent(ind); printf("Call:\n");
+    indent(ind); printf("Call%s:\n", tsuffix(e));
     indent(ind+2); printf("callee:\n");
     print_expr(e->as.call.callee, ind+4);
     indent(ind+2); printf("args:\n");
@@ -346,31 +452,34 @@ static void print_call(const expr *e, int ind){
 static void print_expr(const expr *e, int ind){
     if(!e){ indent(ind); printf("(null-expr)\n"); return; }
     switch(e->kind){
-        case EXPR_IDENT: indent(ind); printf("Ident %s\n", e->as.ident.name); break;
+        case EXPR_IDENT: indent(ind); printf("Ident %s%s\n", e->as.ident.name, tsuffix(e)); break;
         case EXPR_INT_LIT: indent(ind); printf("Int %lld\n", e->as.int_lit.value); break;
         case EXPR_FLOAT_LIT: indent(ind); printf("Float %g\n", e->as.float_lit.value); break;
         case EXPR_BOOL_LIT: indent(ind); printf("Bool %s\n", e->as.bool_lit.value?"true":"false"); break;
-        case EXPR_STRING_LIT: indent(ind); printf("String %s\n", e->as.string_lit.text); break;
+        case EXPR_STRING_LIT: indent(ind); printf("String "); print_quoted(e->as.string_lit.text); printf("\n"); break;
         case EXPR_GROUPING:
             indent(ind); printf("Group\n");
             print_expr(e->as.grouping.inner, ind+2);
             break;
         case EXPR_UNARY:
-            indent(ind); printf("Unary %s\n", opname(e->as.unary.op));
+            indent(ind); printf("Unary %s%s\n", opname(e->as.unary.op), tsuffix(e));
             print_expr(e->as.unary.right, ind+2);
             break;
         case EXPR_BINARY:
-            indent(ind); printf("Binary %s\n", opname(e->as.binary.op));
+            indent(ind); printf("Binary %s%s\n", opname(e->as.binary.op), tsuffix(e));
             print_expr(e->as.binary.left, ind+2);
             print_expr(e->as.binary.right, ind+2);
             break;
         case EXPR_ASSIGN:
-            indent(ind); printf("Assign %s\n", opname(e->as.assign.op));
+            indent(ind); printf("Assign %s%s\n", opname(e->as.assign.op), tsuffix(e));
             indent(ind+2); printf("name: %s\n", e->as.assign.name);
+            if(e->as.assign.decl_type.kind != TYPE_UNKNOWN){
+                indent(ind+2); printf("type: %s\n", tname(e->as.assign.decl_type.kind));
+            }
             print_expr(e->as.assign.value, ind+2);
             break;
         case EXPR_TERNARY:
-            indent(ind); printf("Ternary\n");
+            indent(ind); printf("Ternary%s\n", tsuffix(e));
             indent(ind+2); printf("cond:\n");
             print_expr(e->as.ternary.cond, ind+4);
             indent(ind+2); printf("true:\n");
@@ -381,6 +490,21 @@ static void print_expr(const expr *e, int ind){
         case EXPR_CALL:
             print_call(e, ind);
             break;
+        case EXPR_ARRAY:
+            indent(ind); printf("Array%s\n", tsuffix(e));
+            for(size_t i=0;i<e->as.array.items.count;i++) print_expr(e->as.array.items.items[i], ind+2);
+            break;
+        case EXPR_INDEX:
+            indent(ind); printf("Index%s\n", tsuffix(e));
+            print_expr(e->as.index.target, ind+2);
+            print_expr(e->as.index.index, ind+2);
+            break;
+        case EXPR_INDEX_ASSIGN:
+            indent(ind); printf("IndexAssign %s%s\n", opname(e->as.index_assign.op), tsuffix(e));
+            print_expr(e->as.index_assign.target, ind+2);
+            print_expr(e->as.index_assign.index, ind+2);
+            print_expr(e->as.index_assign.value, ind+2);
+            break;
     }
 }
 
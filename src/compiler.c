@@ -0,0 +1,636 @@
+#include "../include/bytecode.h"
+#include "../include/eval.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+// ---------------- estado del compilador ----------------
+typedef struct {
+    size_t *items; size_t count, cap;
+} patch_list;
+
+typedef struct {
+    patch_list breaks;      // saltos a parchear al salir del bucle
+    patch_list conts;       // saltos a parchear hacia el 'post' (for C-like)
+    size_t loop_start;      // destino de continue en for while-like
+    bool cont_is_forward;   // true => continue salta hacia adelante (post)
+} loop_ctx;
+
+typedef struct {
+    int base;   // primer slot plano del bloque
+    int count;  // slots del bloque (del resolver)
+} scope_ctx;
+
+typedef struct {
+    bc_program *prog;
+    const program_ast *P;
+    env_t *global;
+    bc_function *fn;
+
+    scope_ctx *scopes; size_t scopes_count, scopes_cap;
+    loop_ctx  *loops;  size_t loops_count,  loops_cap;
+
+    int depth;          // temporales actuales en la pila
+    int line;           // línea de la sentencia en curso
+    bool failed;
+    char *err; size_t errlen;
+} compiler_t;
+
+static void fail(compiler_t *c, const char *msg){
+    if(c->failed) return;
+    c->failed = true;
+    if(c->err && c->errlen) snprintf(c->err, c->errlen, "@%d %s", c->line, msg);
+}
+
+// ---------------- chunk ----------------
+static void chunk_write(bc_chunk *ch, uint8_t b, int line){
+    if(ch->count==ch->cap){
+        size_t nc = ch->cap ? ch->cap*2u : 64u;
+        ch->code = (uint8_t*)realloc(ch->code, nc);
+        ch->lines = (int*)realloc(ch->lines, nc*sizeof(int));
+        ch->cap = nc;
+    }
+    ch->code[ch->count] = b;
+    ch->lines[ch->count] = line;
+    ch->count++;
+}
+
+// delta: efecto neto de la instrucción en la pila
+static void emit_op(compiler_t *c, bc_op op, int delta){
+    chunk_write(&c->fn->chunk, (uint8_t)op, c->line);
+    c->depth += delta;
+    if(c->depth > c->fn->max_stack) c->fn->max_stack = c->depth;
+}
+static void emit_u16(compiler_t *c, int v){
+    if(v < 0 || v > 0xFFFF){ fail(c, "operando fuera de rango (u16)"); v = 0; }
+    chunk_write(&c->fn->chunk, (uint8_t)(v & 0xFF), c->line);
+    chunk_write(&c->fn->chunk, (uint8_t)((v >> 8) & 0xFF), c->line);
+}
+static void emit_op1(compiler_t *c, bc_op op, int delta, int a){ emit_op(c, op, delta); emit_u16(c, a); }
+static void emit_op2(compiler_t *c, bc_op op, int delta, int a, int b){ emit_op(c, op, delta); emit_u16(c, a); emit_u16(c, b); }
+
+static size_t emit_jump(compiler_t *c, bc_op op, int delta){
+    emit_op(c, op, delta);
+    emit_u16(c, 0xFFFF);
+    return c->fn->chunk.count - 2;
+}
+static void patch_jump(compiler_t *c, size_t at){
+    size_t off = c->fn->chunk.count - (at + 2);
+    if(off > 0xFFFF){ fail(c, "salto demasiado largo"); return; }
+    c->fn->chunk.code[at]   = (uint8_t)(off & 0xFF);
+    c->fn->chunk.code[at+1] = (uint8_t)((off >> 8) & 0xFF);
+}
+static void emit_loop(compiler_t *c, size_t target){
+    emit_op(c, BC_LOOP, 0);
+    size_t off = c->fn->chunk.count + 2 - target;
+    if(off > 0xFFFF){ fail(c, "bucle demasiado largo"); off = 0; }
+    emit_u16(c, (int)off);
+}
+
+static void patch_push(patch_list *l, size_t at){
+    if(l->count==l->cap){ size_t nc=l->cap?l->cap*2u:4u; l->items=(size_t*)realloc(l->items, nc*sizeof(size_t)); l->cap=nc; }
+    l->items[l->count++] = at;
+}
+// Parchea todos los saltos de la lista hacia aquí y la vacía.
+static void patch_all(compiler_t *c, patch_list *l){
+    for(size_t i=0;i<l->count;i++) patch_jump(c, l->items[i]);
+    free(l->items);
+    l->items = NULL; l->count = l->cap = 0;
+}
+
+// ---------------- constantes ----------------
+static bool const_same(const value_t *a, const value_t *b){
+    if(a->kind != b->kind) return false;
+    switch(a->kind){
+        case VAL_INT:    return a->as.i == b->as.i;
+        case VAL_BOOL:   return a->as.b == b->as.b;
+        case VAL_FLOAT:  return memcmp(&a->as.f, &b->as.f, sizeof(double)) == 0;
+        case VAL_STRING: return value_strlen(a) == value_strlen(b) && memcmp(value_str(a), value_str(b), value_strlen(a)) == 0;
+        default:         return true;
+    }
+}
+// toma posesión de v
+static int add_const(compiler_t *c, value_t v){
+    bc_program *p = c->prog;
+    for(size_t i=0;i<p->consts_count;i++){
+        if(const_same(&p->consts[i], &v)){ value_free(&v); return (int)i; }
+    }
+    if(p->consts_count==p->consts_cap){
+        size_t nc=p->consts_cap?p->consts_cap*2u:16u;
+        p->consts=(value_t*)realloc(p->consts, nc*sizeof(value_t)); p->consts_cap=nc;
+    }
+    p->consts[p->consts_count] = v;
+    return (int)p->consts_count++;
+}
+static int name_const(compiler_t *c, const char *name){ return add_const(c, v_string(name)); }
+
+static int builtin_index(compiler_t *c, builtin_fn b){
+    bc_program *p = c->prog;
+    for(size_t i=0;i<p->builtins_count;i++) if(p->builtins[i]==b) return (int)i;
+    if(p->builtins_count==p->builtins_cap){
+        size_t nc=p->builtins_cap?p->builtins_cap*2u:4u;
+        p->builtins=(builtin_fn*)realloc(p->builtins, nc*sizeof(builtin_fn)); p->builtins_cap=nc;
+    }
+    p->builtins[p->builtins_count] = b;
+    return (int)p->builtins_count++;
+}
+
+// Índice de la función del programa con ese nombre (la última definida gana).
+static int func_index(compiler_t *c, const char *name){
+    int found = -1, idx = 0;
+    for(size_t i=0;i<c->P->decls.count;i++){
+        const decl *d = c->P->decls.items[i];
+        if(d->kind != DECL_FUNC) continue;
+        if(strcmp(d->as.func.name, name)==0) found = idx;
+        idx++;
+    }
+    return found;
+}
+
+// ---------------- scopes ----------------
+static void push_scope(compiler_t *c, int count){
+    if(c->scopes_count==c->scopes_cap){
+        size_t nc=c->scopes_cap?c->scopes_cap*2u:8u;
+        c->scopes=(scope_ctx*)realloc(c->scopes, nc*sizeof(scope_ctx)); c->scopes_cap=nc;
+    }
+    int base = 0;
+    if(c->scopes_count){
+        const scope_ctx *par = &c->scopes[c->scopes_count-1];
+        base = par->base + par->count;
+    }
+    c->scopes[c->scopes_count].base = base;
+    c->scopes[c->scopes_count].count = count;
+    c->scopes_count++;
+    if(base + count > c->fn->nslots) c->fn->nslots = base + count;
+}
+static void pop_scope(compiler_t *c){ c->scopes_count--; }
+
+static int flat_slot(compiler_t *c, int depth, int slot){
+    if((size_t)depth >= c->scopes_count){ fail(c, "profundidad de variable inválida"); return 0; }
+    return c->scopes[c->scopes_count-1-(size_t)depth].base + slot;
+}
+
+// ---------------- expresiones ----------------
+static void compile_expr(compiler_t *c, const expr *e);
+
+static bc_op binop_code(op_kind op){
+    switch(op){
+        case OP_ADD: case OP_PLUS_ASSIGN:    return BC_ADD;
+        case OP_SUB: case OP_MINUS_ASSIGN:   return BC_SUB;
+        case OP_MUL: case OP_STAR_ASSIGN:    return BC_MUL;
+        case OP_DIV: case OP_SLASH_ASSIGN:   return BC_DIV;
+        case OP_MOD: case OP_PERCENT_ASSIGN: return BC_MOD;
+        case OP_EQ:  return BC_EQ;
+        case OP_NEQ: return BC_NEQ;
+        case OP_LT:  return BC_LT;
+        case OP_LTE: return BC_LTE;
+        case OP_GT:  return BC_GT;
+        case OP_GTE: return BC_GTE;
+        default:     return BC__COUNT;   // && y || se compilan con saltos
+    }
+}
+
+// Variante int de la operación si el checker garantiza ambos operandos int.
+static bc_op int_binop_code(op_kind op){
+    switch(binop_code(op)){
+        case BC_ADD: return BC_ADD_I;
+        case BC_SUB: return BC_SUB_I;
+        case BC_MUL: return BC_MUL_I;
+        case BC_DIV: return BC_DIV_I;
+        case BC_MOD: return BC_MOD_I;
+        case BC_EQ:  return BC_EQ_I;
+        case BC_NEQ: return BC_NEQ_I;
+        case BC_LT:  return BC_LT_I;
+        case BC_LTE: return BC_LTE_I;
+        case BC_GT:  return BC_GT_I;
+        case BC_GTE: return BC_GTE_I;
+        default:     return BC__COUNT;
+    }
+}
+static bc_op cmp_jump_code(op_kind op){
+    switch(op){
+        case OP_LT:  return BC_JUMP_IF_NOT_LT_I;
+        case OP_LTE: return BC_JUMP_IF_NOT_LTE_I;
+        case OP_GT:  return BC_JUMP_IF_NOT_GT_I;
+        case OP_GTE: return BC_JUMP_IF_NOT_GTE_I;
+        case OP_EQ:  return BC_JUMP_IF_NOT_EQ_I;
+        case OP_NEQ: return BC_JUMP_IF_NOT_NEQ_I;
+        default:     return BC__COUNT;
+    }
+}
+
+// Comparación opuesta (válida entre ints): !(a < b) == (a >= b).
+static op_kind negate_cmp(op_kind op){
+    switch(op){
+        case OP_LT:  return OP_GTE;
+        case OP_LTE: return OP_GT;
+        case OP_GT:  return OP_LTE;
+        case OP_GTE: return OP_LT;
+        case OP_EQ:  return OP_NEQ;
+        case OP_NEQ: return OP_EQ;
+        default:     return op;
+    }
+}
+
+static bool is_int(const expr *e){ return e->type == TYPE_INT; }
+
+// Literal int que cabe en un inmediato i16 (con el signo ya aplicado).
+static bool int_imm(const expr *e, bool negate, int *out){
+    if(e->kind != EXPR_INT_LIT) return false;
+    long long v = negate ? -e->as.int_lit.value : e->as.int_lit.value;
+    if(v < -32768 || v > 32767) return false;
+    *out = (int)v;
+    return true;
+}
+static void emit_imm(compiler_t *c, int v){ emit_u16(c, v & 0xFFFF); }
+
+static void compile_call(compiler_t *c, const expr *e){
+    if(e->as.call.callee->kind != EXPR_IDENT){ emit_op(c, BC_VOID, +1); return; }
+    const char *name = e->as.call.callee->as.ident.name;
+    int argc = (int)e->as.call.args.count;
+    for(int i=0;i<argc;i++) compile_expr(c, e->as.call.args.items[i]);
+
+    builtin_fn b = env_get_builtin(c->global, name);
+    if(b){
+        emit_op2(c, BC_CALL_BUILTIN, 1 - argc, builtin_index(c, b), argc);
+        return;
+    }
+    int f = func_index(c, name);
+    if(f >= 0){
+        emit_op2(c, BC_CALL, 1 - argc, f, argc);
+        return;
+    }
+    // función desconocida: como el evaluador, args evaluados y resultado void
+    if(argc) emit_op1(c, BC_POPN, -argc, argc);
+    emit_op(c, BC_VOID, +1);
+}
+
+// Índice de la función si `e` es una llamada a una función del programa
+// (no builtin) que puede hacerse como llamada de cola; -1 si no.
+static int tail_call_target(compiler_t *c, const expr *e){
+    if(!e || e->kind != EXPR_CALL || e->as.call.callee->kind != EXPR_IDENT) return -1;
+    const char *name = e->as.call.callee->as.ident.name;
+    if(env_get_builtin(c->global, name)) return -1;
+    return func_index(c, name);
+}
+
+static void compile_assign(compiler_t *c, const expr *e){
+    bool local = e->as.assign.depth >= 0;
+    int slot = local ? flat_slot(c, e->as.assign.depth, e->as.assign.slot) : 0;
+    int k = local ? 0 : name_const(c, e->as.assign.name);
+
+    compile_expr(c, e->as.assign.value);
+    if(e->as.assign.op != OP_ASSIGN){
+        // valor primero, luego el actual (mismo orden que el evaluador)
+        bool ints = is_int(e) && is_int(e->as.assign.value);
+        if(local) emit_op1(c, ints ? BC_GET_LOCAL_RAW : BC_GET_LOCAL, +1, slot);
+        else      emit_op1(c, BC_GET_GLOBAL, +1, k);
+        emit_op(c, BC_SWAP, 0);
+        emit_op(c, ints ? int_binop_code(e->as.assign.op) : binop_code(e->as.assign.op), -1);
+    }
+    if(local) emit_op1(c, BC_SET_LOCAL, 0, slot);
+    else      emit_op1(c, BC_SET_GLOBAL, 0, k);
+}
+
+// Evalúa `cond` y salta a `out` si su valor de verdad es `when`; si no, sigue.
+// && / || / ! se bajan a cadenas de saltos en cortocircuito, sin apilar bools
+// intermedios, y una comparación int-int se funde con su salto.
+static void compile_branch(compiler_t *c, const expr *cond, bool when, patch_list *out){
+    while(cond->kind == EXPR_GROUPING) cond = cond->as.grouping.inner;
+    if(cond->kind == EXPR_UNARY && cond->as.unary.op == OP_NOT){
+        compile_branch(c, cond->as.unary.right, !when, out);
+        return;
+    }
+    if(cond->kind == EXPR_BINARY){
+        op_kind op = cond->as.binary.op;
+        if(op == OP_AND || op == OP_OR){
+            if((op == OP_AND) != when){
+                // (a && b) falso / (a || b) verdadero: cualquiera de los lados decide
+                compile_branch(c, cond->as.binary.left, when, out);
+                compile_branch(c, cond->as.binary.right, when, out);
+            } else {
+                // el izquierdo sólo puede decidir lo contrario: salta por encima del derecho
+                patch_list skip = { NULL, 0, 0 };
+                compile_branch(c, cond->as.binary.left, !when, &skip);
+                compile_branch(c, cond->as.binary.right, when, out);
+                patch_all(c, &skip);
+            }
+            return;
+        }
+        if(is_int(cond->as.binary.left) && is_int(cond->as.binary.right)){
+            bc_op jop = cmp_jump_code(when ? negate_cmp(op) : op);
+            if(jop != BC__COUNT){
+                compile_expr(c, cond->as.binary.left);
+                compile_expr(c, cond->as.binary.right);
+                patch_push(out, emit_jump(c, jop, -2));
+                return;
+            }
+        }
+    }
+    compile_expr(c, cond);
+    patch_push(out, emit_jump(c, when ? BC_JUMP_IF_TRUE : BC_JUMP_IF_FALSE, -1));
+}
+
+// Expresión cuyo valor se descarta. `i = i + k`, `i += k` e `i -= k` sobre un
+// local int se reducen a un incremento en el slot.
+static void compile_effect(compiler_t *c, const expr *e){
+    if(e->kind == EXPR_ASSIGN && e->as.assign.depth >= 0 && is_int(e)){
+        const expr *v = e->as.assign.value;
+        int imm; bool fused = false;
+        switch(e->as.assign.op){
+            case OP_PLUS_ASSIGN:  fused = int_imm(v, false, &imm); break;
+            case OP_MINUS_ASSIGN: fused = int_imm(v, true, &imm); break;
+            case OP_ASSIGN:
+                if(v->kind == EXPR_BINARY && (v->as.binary.op == OP_ADD || v->as.binary.op == OP_SUB)){
+                    const expr *x = v->as.binary.left;
+                    fused = x->kind == EXPR_IDENT && is_int(x)
+                         && x->as.ident.depth == e->as.assign.depth && x->as.ident.slot == e->as.assign.slot
+                         && int_imm(v->as.binary.right, v->as.binary.op == OP_SUB, &imm);
+                }
+                break;
+            default: break;
+        }
+        if(fused){
+            emit_op(c, BC_INC_LOCAL_I, 0);
+            emit_u16(c, flat_slot(c, e->as.assign.depth, e->as.assign.slot));
+            emit_imm(c, imm);
+            return;
+        }
+    }
+    compile_expr(c, e);
+    emit_op(c, BC_POP, -1);
+}
+
+static void compile_expr(compiler_t *c, const expr *e){
+    if(c->failed) return;
+    switch(e->kind){
+        case EXPR_IDENT:
+            if(e->as.ident.depth >= 0)
+                emit_op1(c, (e->type == TYPE_INT || e->type == TYPE_FLOAT || e->type == TYPE_BOOL) ? BC_GET_LOCAL_RAW : BC_GET_LOCAL,
+                         +1, flat_slot(c, e->as.ident.depth, e->as.ident.slot));
+            else
+                emit_op1(c, BC_GET_GLOBAL, +1, name_const(c, e->as.ident.name));
+            break;
+        case EXPR_INT_LIT:   emit_op1(c, BC_CONST, +1, add_const(c, v_int(e->as.int_lit.value))); break;
+        case EXPR_FLOAT_LIT: emit_op1(c, BC_CONST, +1, add_const(c, v_float(e->as.float_lit.value))); break;
+        case EXPR_BOOL_LIT:  emit_op1(c, BC_CONST, +1, add_const(c, v_bool(e->as.bool_lit.value))); break;
+        case EXPR_STRING_LIT: emit_op1(c, BC_CONST, +1, add_const(c, value_copy(&e->as.string_lit.value))); break;
+        case EXPR_GROUPING: compile_expr(c, e->as.grouping.inner); break;
+        case EXPR_UNARY:
+            compile_expr(c, e->as.unary.right);
+            if(e->as.unary.op == OP_NOT)      emit_op(c, BC_NOT, 0);
+            else if(e->as.unary.op == OP_SUB) emit_op(c, BC_NEG, 0);
+            else { emit_op(c, BC_POP, -1); emit_op(c, BC_VOID, +1); }
+            break;
+        case EXPR_BINARY: {
+            if(e->as.binary.op == OP_AND || e->as.binary.op == OP_OR){
+                patch_list f = { NULL, 0, 0 };
+                compile_branch(c, e, false, &f);
+                emit_op1(c, BC_CONST, +1, add_const(c, v_bool(true)));
+                size_t jend = emit_jump(c, BC_JUMP, 0);
+                c->depth--;
+                patch_all(c, &f);
+                emit_op1(c, BC_CONST, +1, add_const(c, v_bool(false)));
+                patch_jump(c, jend);
+                break;
+            }
+            const expr *L = e->as.binary.left, *R = e->as.binary.right;
+            bool ints = is_int(L) && is_int(R);
+            int imm;
+            compile_expr(c, L);
+            // x + k / x - k con k pequeño: inmediato
+            if(ints && (e->as.binary.op == OP_ADD || e->as.binary.op == OP_SUB)
+               && int_imm(R, e->as.binary.op == OP_SUB, &imm)){
+                emit_op(c, BC_ADD_IMM_I, 0); emit_imm(c, imm);
+                break;
+            }
+            compile_expr(c, R);
+            bc_op op = ints ? int_binop_code(e->as.binary.op) : binop_code(e->as.binary.op);
+            if(op == BC__COUNT){ emit_op1(c, BC_POPN, -2, 2); emit_op(c, BC_VOID, +1); }
+            else emit_op(c, op, -1);
+            break;
+        }
+        case EXPR_ASSIGN: compile_assign(c, e); break;
+        case EXPR_TERNARY: {
+            patch_list jf = { NULL, 0, 0 };
+            compile_branch(c, e->as.ternary.cond, false, &jf);
+            compile_expr(c, e->as.ternary.when_true);
+            size_t jend = emit_jump(c, BC_JUMP, 0);
+            c->depth--; // sólo una de las ramas deja su valor
+            patch_all(c, &jf);
+            compile_expr(c, e->as.ternary.when_false);
+            patch_jump(c, jend);
+            break;
+        }
+        case EXPR_CALL: compile_call(c, e); break;
+        case EXPR_ARRAY: {
+            int n = (int)e->as.array.items.count;
+            for(int i=0;i<n;i++) compile_expr(c, e->as.array.items.items[i]);
+            emit_op2(c, BC_ARRAY, 1 - n, n, (int)type_elem_value(e->type));
+            break;
+        }
+        case EXPR_INDEX:
+            compile_expr(c, e->as.index.target);
+            compile_expr(c, e->as.index.index);
+            emit_op(c, BC_INDEX, -1);
+            break;
+        case EXPR_INDEX_ASSIGN:
+            compile_expr(c, e->as.index_assign.target);
+            compile_expr(c, e->as.index_assign.index);
+            compile_expr(c, e->as.index_assign.value);
+            emit_op1(c, BC_SET_INDEX, -2, (int)e->as.index_assign.op);
+            break;
+    }
+}
+
+// ---------------- sentencias ----------------
+static void compile_stmt(compiler_t *c, const stmt *s);
+
+static void compile_block(compiler_t *c, const stmt *s){
+    int n = s->as.block.nslots;
+    push_scope(c, n);
+    // frame fresco en cada entrada (p.ej. cada iteración de un for)
+    if(n) emit_op2(c, BC_CLEAR, 0, c->scopes[c->scopes_count-1].base, n);
+    for(size_t i=0;i<s->as.block.stmts.count;i++) compile_stmt(c, s->as.block.stmts.items[i]);
+    pop_scope(c);
+}
+
+static loop_ctx *push_loop(compiler_t *c){
+    if(c->loops_count==c->loops_cap){
+        size_t nc=c->loops_cap?c->loops_cap*2u:4u;
+        c->loops=(loop_ctx*)realloc(c->loops, nc*sizeof(loop_ctx)); c->loops_cap=nc;
+    }
+    loop_ctx *l = &c->loops[c->loops_count++];
+    memset(l, 0, sizeof(*l));
+    return l;
+}
+static void pop_loop(compiler_t *c){
+    loop_ctx *l = &c->loops[--c->loops_count];
+    for(size_t i=0;i<l->breaks.count;i++) patch_jump(c, l->breaks.items[i]);
+    free(l->breaks.items);
+    free(l->conts.items);
+}
+
+static void compile_stmt(compiler_t *c, const stmt *s){
+    if(c->failed || !s) return;
+    if(s->line) c->line = s->line;
+    switch(s->kind){
+        case STMT_EXPR:
+            compile_effect(c, s->as.expr_stmt.value);
+            break;
+        case STMT_RETURN: {
+            const expr *v = s->as.ret.value;
+            int f = tail_call_target(c, v);
+            if(f >= 0){
+                int argc = (int)v->as.call.args.count;
+                for(int i=0;i<argc;i++) compile_expr(c, v->as.call.args.items[i]);
+                emit_op2(c, BC_TAILCALL, -argc, f, argc);
+                break;
+            }
+            if(v) compile_expr(c, v);
+            else emit_op(c, BC_VOID, +1);
+            emit_op(c, BC_RETURN, -1);
+            break;
+        }
+        case STMT_BREAK:
+            if(!c->loops_count){ fail(c, "break fuera de un bucle"); return; }
+            patch_push(&c->loops[c->loops_count-1].breaks, emit_jump(c, BC_JUMP, 0));
+            break;
+        case STMT_CONTINUE: {
+            if(!c->loops_count){ fail(c, "continue fuera de un bucle"); return; }
+            loop_ctx *l = &c->loops[c->loops_count-1];
+            if(l->cont_is_forward) patch_push(&l->conts, emit_jump(c, BC_JUMP, 0));
+            else emit_loop(c, l->loop_start);
+            break;
+        }
+        case STMT_BLOCK: compile_block(c, s); break;
+        case STMT_IF: {
+            patch_list jf = { NULL, 0, 0 };
+            compile_branch(c, s->as.if_stmt.cond, false, &jf);
+            compile_stmt(c, s->as.if_stmt.then_branch);
+            if(s->as.if_stmt.else_branch){
+                size_t jend = emit_jump(c, BC_JUMP, 0);
+                patch_all(c, &jf);
+                compile_stmt(c, s->as.if_stmt.else_branch);
+                patch_jump(c, jend);
+            } else {
+                patch_all(c, &jf);
+            }
+            break;
+        }
+        case STMT_FOR_WHILELIKE: {
+            size_t start = c->fn->chunk.count;
+            loop_ctx *l = push_loop(c);
+            l->loop_start = start;
+            patch_list jexit = { NULL, 0, 0 };
+            compile_branch(c, s->as.for_while.cond, false, &jexit);
+            compile_stmt(c, s->as.for_while.body);
+            emit_loop(c, start);
+            patch_all(c, &jexit);
+            pop_loop(c);
+            break;
+        }
+        case STMT_FOR_CLIKE: {
+            compile_stmt(c, s->as.for_clike.init);
+            size_t start = c->fn->chunk.count;
+            patch_list jexit = { NULL, 0, 0 };
+            if(s->as.for_clike.cond) compile_branch(c, s->as.for_clike.cond, false, &jexit);
+            loop_ctx *l = push_loop(c);
+            l->cont_is_forward = true;
+            compile_stmt(c, s->as.for_clike.body);
+            l = &c->loops[c->loops_count-1]; // push_loop pudo reubicar
+            for(size_t i=0;i<l->conts.count;i++) patch_jump(c, l->conts.items[i]);
+            if(s->as.for_clike.post) compile_effect(c, s->as.for_clike.post);
+            emit_loop(c, start);
+            patch_all(c, &jexit);
+            pop_loop(c);
+            break;
+        }
+    }
+}
+
+// ---------------- funciones / programa ----------------
+static void compile_function(compiler_t *c, bc_function *bf, const func_decl *fn){
+    memset(bf, 0, sizeof(*bf));
+    bf->name = fn->name;
+    bf->decl = (func_decl*)fn;
+    bf->arity = (int)fn->params.count;
+    c->fn = bf;
+    c->depth = 0;
+    c->line = fn->line;
+    c->scopes_count = 0;
+    push_scope(c, bf->arity);
+    compile_stmt(c, fn->body);
+    // retorno implícito
+    emit_op(c, BC_VOID, +1);
+    emit_op(c, BC_RETURN, -1);
+    pop_scope(c);
+}
+
+bool bc_compile_program(const program_ast *P, env_t *global, bc_program *out, char *err, size_t errlen){
+    memset(out, 0, sizeof(*out));
+    compiler_t c; memset(&c, 0, sizeof(c));
+    c.prog = out; c.P = P; c.global = global;
+    c.err = err; c.errlen = errlen;
+    if(err && errlen) err[0] = '\0';
+
+    size_t nf = 0;
+    for(size_t i=0;i<P->decls.count;i++) if(P->decls.items[i]->kind==DECL_FUNC) nf++;
+    out->funcs = (bc_function*)calloc(nf ? nf : 1u, sizeof(bc_function));
+    out->funcs_cap = nf;
+
+    for(size_t i=0;i<P->decls.count && !c.failed;i++){
+        const decl *d = P->decls.items[i];
+        if(d->kind != DECL_FUNC) continue;
+        compile_function(&c, &out->funcs[out->funcs_count++], &d->as.func);
+    }
+
+    // script: globales en orden y luego main()
+    c.fn = &out->script;
+    out->script.name = "<script>";
+    c.depth = 0; c.scopes_count = 0;
+    for(size_t i=0;i<P->decls.count && !c.failed;i++){
+        const decl *d = P->decls.items[i];
+        if(d->kind != DECL_VAR) continue;
+        c.line = d->as.var.line;
+        if(d->as.var.init) compile_expr(&c, d->as.var.init);
+        else emit_op(&c, BC_VOID, +1);
+        emit_op1(&c, d->as.var.is_const ? BC_DEFINE_CONST : BC_DEFINE_GLOBAL, -1, name_const(&c, d->as.var.name));
+    }
+    int main_idx = func_index(&c, "main");
+    if(main_idx >= 0){
+        emit_op2(&c, BC_CALL, +1, main_idx, 0);
+        emit_op(&c, BC_POP, -1);
+    }
+    emit_op(&c, BC_HALT, 0);
+
+    free(c.scopes);
+    free(c.loops);
+    if(c.failed){ bc_program_free(out); return false; }
+    return true;
+}
+
+static void chunk_free(bc_chunk *ch){
+    free(ch->code); free(ch->lines);
+    ch->code = NULL; ch->lines = NULL; ch->count = ch->cap = 0;
+}
+
+void bc_program_free(bc_program *prog){
+    if(!prog) return;
+    for(size_t i=0;i<prog->funcs_count;i++) chunk_free(&prog->funcs[i].chunk);
+    free(prog->funcs);
+    chunk_free(&prog->script.chunk);
+    for(size_t i=0;i<prog->consts_count;i++) value_free(&prog->consts[i]);
+    free(prog->consts);
+    free(prog->builtins);
+    memset(prog, 0, sizeof(*prog));
+}
+
+const char *bc_op_name(bc_op op){
+    switch(op){
+#define BC_NAME(o) case o: return #o;
+        BC_OPCODES(BC_NAME)
+#undef BC_NAME
+        default: return "?";
+    }
+}
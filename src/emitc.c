@@ -0,0 +1,1190 @@
+#include "../include/emitc.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+
+// Runtime que acompaña a cada programa generado. Replica value.c sobre un
+// valor por copia (sin refcount: los strings y los arrays viven hasta el final).
+static const char *k_prelude[] = {
+    "#include <stdio.h>",
+    "#include <stdlib.h>",
+    "#include <string.h>",
+    "#include <math.h>",
+    "",
+    "typedef enum { CEL_VOID, CEL_INT, CEL_BOOL, CEL_FLOAT, CEL_STRING, CEL_ARRAY } cel_kind;",
+    "typedef struct { size_t n; char p[]; } cel_str;",
+    "/* int[], float[] y bool[]: elementos contiguos sin etiqueta; elem es CEL_VOID en un [] sin tipo */",
+    "typedef struct { cel_kind elem; size_t len, cap; union { long long *i; double *f; unsigned char *b; } d; } cel_arr;",
+    "typedef struct {",
+    "    cel_kind k;",
+    "    union { long long i; double f; int b; const cel_str *s; cel_arr *a; } as;",
+    "} cel_v;",
+    "",
+    "static inline cel_v cel_void(void){ cel_v v; v.k = CEL_VOID; v.as.i = 0; return v; }",
+    "static inline cel_v cel_int(long long x){ cel_v v; v.k = CEL_INT; v.as.i = x; return v; }",
+    "static inline cel_v cel_float(double x){ cel_v v; v.k = CEL_FLOAT; v.as.f = x; return v; }",
+    "static inline cel_v cel_bool(int x){ cel_v v; v.k = CEL_BOOL; v.as.i = 0; v.as.b = x != 0; return v; }",
+    "static inline cel_v cel_string(const cel_str *s){ cel_v v; v.k = CEL_STRING; v.as.s = s; return v; }",
+    "static inline cel_v cel_get(const cel_arr *a, size_t i){",
+    "    switch(a->elem){",
+    "        case CEL_INT:   return cel_int(a->d.i[i]);",
+    "        case CEL_FLOAT: return cel_float(a->d.f[i]);",
+    "        default:        return cel_bool(a->d.b[i]);",
+    "    }",
+    "}",
+    "",
+    "static inline cel_str *cel_newstr(size_t n){",
+    "    cel_str *s = (cel_str*)malloc(sizeof(cel_str) + n + 1);",
+    "    if(!s){ fputs(\"sin memoria\\n\", stderr); exit(1); }",
+    "    s->n = n; s->p[n] = '\\0';",
+    "    return s;",
+    "}",
+    "static inline cel_str *cel_mkstr(const char *p, size_t n){",
+    "    cel_str *s = cel_newstr(n);",
+    "    if(n) memcpy(s->p, p, n);",
+    "    return s;",
+    "}",
+    "",
+    "/* aritmética entera con desborde en complemento a dos, como el intérprete */",
+    "static inline long long cel_addi(long long a, long long b){ return (long long)((unsigned long long)a + (unsigned long long)b); }",
+    "static inline long long cel_subi(long long a, long long b){ return (long long)((unsigned long long)a - (unsigned long long)b); }",
+    "static inline long long cel_muli(long long a, long long b){ return (long long)((unsigned long long)a * (unsigned long long)b); }",
+    "static inline long long cel_negi(long long a){ return cel_subi(0, a); }",
+    "static inline long long cel_divi(long long a, long long b){ return b == 0 ? 0 : a / b; }",
+    "static inline long long cel_modi(long long a, long long b){ return b == 0 ? 0 : a % b; }",
+    "static inline int cel_eqf(double a, double b){ return fabs(a - b) < 1e-12; }",
+    "static inline int cel_lef(double a, double b){ return a < b || fabs(a - b) < 1e-12; }",
+    "static inline int cel_truef(double x){ return fabs(x) > 1e-12; }",
+    "",
+    "static inline int cel_truthy(cel_v v){",
+    "    switch(v.k){",
+    "        case CEL_BOOL:   return v.as.b;",
+    "        case CEL_INT:    return v.as.i != 0;",
+    "        case CEL_FLOAT:  return cel_truef(v.as.f);",
+    "        case CEL_STRING: return v.as.s->n != 0;",
+    "        case CEL_ARRAY:  return v.as.a->len != 0;",
+    "        default:         return 0;",
+    "    }",
+    "}",
+    "static inline int cel_floaty(cel_v a, cel_v b){ return a.k == CEL_FLOAT || b.k == CEL_FLOAT; }",
+    "static inline double cel_num(cel_v a){ return a.k == CEL_FLOAT ? a.as.f : (double)a.as.i; }",
+    "",
+    "static inline cel_v cel_add(cel_v a, cel_v b){",
+    "    if(a.k == CEL_STRING && b.k == CEL_STRING){",
+    "        cel_str *s;",
+    "        if(b.as.s->n == 0) return a;",
+    "        if(a.as.s->n == 0) return b;",
+    "        s = cel_newstr(a.as.s->n + b.as.s->n);",
+    "        memcpy(s->p, a.as.s->p, a.as.s->n); memcpy(s->p + a.as.s->n, b.as.s->p, b.as.s->n);",
+    "        return cel_string(s);",
+    "    }",
+    "    if(cel_floaty(a, b)) return cel_float(cel_num(a) + cel_num(b));",
+    "    if(a.k == CEL_INT && b.k == CEL_INT) return cel_int(cel_addi(a.as.i, b.as.i));",
+    "    return cel_void();",
+    "}",
+    "static inline cel_v cel_sub(cel_v a, cel_v b){",
+    "    if(cel_floaty(a, b)) return cel_float(cel_num(a) - cel_num(b));",
+    "    if(a.k == CEL_INT && b.k == CEL_INT) return cel_int(cel_subi(a.as.i, b.as.i));",
+    "    return cel_void();",
+    "}",
+    "static inline cel_v cel_mul(cel_v a, cel_v b){",
+    "    if(cel_floaty(a, b)) return cel_float(cel_num(a) * cel_num(b));",
+    "    if(a.k == CEL_INT && b.k == CEL_INT) return cel_int(cel_muli(a.as.i, b.as.i));",
+    "    return cel_void();",
+    "}",
+    "static inline cel_v cel_div(cel_v a, cel_v b){",
+    "    if(cel_floaty(a, b)) return cel_float(cel_num(a) / cel_num(b));",
+    "    if(a.k == CEL_INT && b.k == CEL_INT) return cel_int(cel_divi(a.as.i, b.as.i));",
+    "    return cel_void();",
+    "}",
+    "static inline cel_v cel_mod(cel_v a, cel_v b){",
+    "    if(a.k == CEL_INT && b.k == CEL_INT) return cel_int(cel_modi(a.as.i, b.as.i));",
+    "    return cel_void();",
+    "}",
+    "static inline cel_v cel_neg(cel_v a){ return cel_sub(cel_int(0), a); }",
+    "static inline cel_v cel_eq(cel_v a, cel_v b){",
+    "    if(a.k != b.k) return cel_bool(cel_floaty(a, b) && cel_eqf(cel_num(a), cel_num(b)));",
+    "    switch(a.k){",
+    "        case CEL_VOID:   return cel_bool(1);",
+    "        case CEL_BOOL:   return cel_bool(a.as.b == b.as.b);",
+    "        case CEL_INT:    return cel_bool(a.as.i == b.as.i);",
+    "        case CEL_FLOAT:  return cel_bool(cel_eqf(a.as.f, b.as.f));",
+    "        case CEL_STRING: return cel_bool(a.as.s == b.as.s || (a.as.s->n == b.as.s->n && memcmp(a.as.s->p, b.as.s->p, a.as.s->n) == 0));",
+    "        case CEL_ARRAY: {",
+    "            size_t i;",
+    "            if(a.as.a == b.as.a) return cel_bool(1);",
+    "            if(a.as.a->len != b.as.a->len) return cel_bool(0);",
+    "            for(i = 0; i < a.as.a->len; i++)",
+    "                if(!cel_eq(cel_get(a.as.a, i), cel_get(b.as.a, i)).as.b) return cel_bool(0);",
+    "            return cel_bool(1);",
+    "        }",
+    "        default:         return cel_bool(0);",
+    "    }",
+    "}",
+    "static inline cel_v cel_neq(cel_v a, cel_v b){ return cel_bool(!cel_eq(a, b).as.b); }",
+    "static inline cel_v cel_lt(cel_v a, cel_v b){",
+    "    if(cel_floaty(a, b)) return cel_bool(cel_num(a) < cel_num(b));",
+    "    if(a.k == CEL_INT && b.k == CEL_INT) return cel_bool(a.as.i < b.as.i);",
+    "    return cel_void();",
+    "}",
+    "static inline cel_v cel_lte(cel_v a, cel_v b){",
+    "    if(a.k == CEL_INT && b.k == CEL_INT) return cel_bool(a.as.i <= b.as.i);",
+    "    if(cel_floaty(a, b)) return cel_bool(cel_lef(cel_num(a), cel_num(b)));",
+    "    return cel_eq(a, b);",
+    "}",
+    "static inline cel_v cel_gt(cel_v a, cel_v b){ return cel_bool(!cel_lte(a, b).as.b); }",
+    "static inline cel_v cel_gte(cel_v a, cel_v b){",
+    "    cel_v lt;",
+    "    if(a.k == CEL_INT && b.k == CEL_INT) return cel_bool(a.as.i >= b.as.i);",
+    "    lt = cel_lt(a, b);",
+    "    return lt.k == CEL_BOOL ? cel_bool(!lt.as.b) : lt;",
+    "}",
+    "",
+    "/* x op= v: genérico y con tipo garantizado (el slot queda int/float) */",
+    "static inline cel_v cel_asg(cel_v *s, int op, cel_v v){",
+    "    switch(op){",
+    "        case '+': *s = cel_add(*s, v); break;",
+    "        case '-': *s = cel_sub(*s, v); break;",
+    "        case '*': *s = cel_mul(*s, v); break;",
+    "        case '/': *s = cel_div(*s, v); break;",
+    "        case '%': *s = cel_mod(*s, v); break;",
+    "    }",
+    "    return *s;",
+    "}",
+    "static inline long long cel_asgi(cel_v *s, int op, long long v){",
+    "    long long x = s->as.i;",
+    "    switch(op){",
+    "        case '+': x = cel_addi(x, v); break;",
+    "        case '-': x = cel_subi(x, v); break;",
+    "        case '*': x = cel_muli(x, v); break;",
+    "        case '/': x = cel_divi(x, v); break;",
+    "        case '%': x = cel_modi(x, v); break;",
+    "    }",
+    "    s->k = CEL_INT; s->as.i = x;",
+    "    return x;",
+    "}",
+    "static inline double cel_asgf(cel_v *s, int op, double v){",
+    "    double x = s->as.f;",
+    "    switch(op){",
+    "        case '+': x += v; break;",
+    "        case '-': x -= v; break;",
+    "        case '*': x *= v; break;",
+    "        case '/': x /= v; break;",
+    "    }",
+    "    s->k = CEL_FLOAT; s->as.f = x;",
+    "    return x;",
+    "}",
+    "",
+    "static inline cel_v cel_print(int n, const cel_v *a){",
+    "    int i;",
+    "    for(i = 0; i < n; i++){",
+    "        switch(a[i].k){",
+    "            case CEL_VOID:   fputs(\"void\", stdout); break;",
+    "            case CEL_BOOL:   fputs(a[i].as.b ? \"true\" : \"false\", stdout); break;",
+    "            case CEL_INT:    printf(\"%lld\", a[i].as.i); break;",
+    "            case CEL_FLOAT:  printf(\"%g\", a[i].as.f); break;",
+    "            case CEL_STRING: fputs(a[i].as.s->p, stdout); break;",
+    "            case CEL_ARRAY: {",
+    "                size_t j;",
+    "                fputc('[', stdout);",
+    "                for(j = 0; j < a[i].as.a->len; j++){",
+    "                    cel_v x = cel_get(a[i].as.a, j);",
+    "                    if(j) fputs(\", \", stdout);",
+    "                    if(x.k == CEL_INT) printf(\"%lld\", x.as.i);",
+    "                    else if(x.k == CEL_FLOAT) printf(\"%g\", x.as.f);",
+    "                    else fputs(x.as.b ? \"true\" : \"false\", stdout);",
+    "                }",
+    "                fputc(']', stdout);",
+    "                break;",
+    "            }",
+    "        }",
+    "        if(i + 1 < n) fputc(' ', stdout);",
+    "    }",
+    "    fputc('\\n', stdout);",
+    "    return cel_void();",
+    "}",
+    "",
+    "static inline void cel_overflow(int line, const char *fn){",
+    "    fflush(stdout);",
+    "    fprintf(stderr, \"Error de ejecución @%d en %s: desbordamiento de la pila de llamadas (profundidad %lu)\\n\",",
+    "            line, fn, (unsigned long)CEL_MAX_DEPTH);",
+    "    exit(3);",
+    "}",
+    "#define CEL_ENTER(line, fn) do{ if(cel_depth >= CEL_MAX_DEPTH) cel_overflow(line, fn); cel_depth++; }while(0)",
+    "#define CEL_RETURN(x) do{ cel_v cel_r_ = (x); cel_depth--; return cel_r_; }while(0)",
+    "",
+    "/* arrays: los mismos chequeos y mensajes que value.c */",
+    "static inline void cel_fail(int line, const char *fn, const char *msg){",
+    "    fflush(stdout);",
+    "    fprintf(stderr, \"Error de ejecución @%d en %s: %s\\n\", line, fn, msg);",
+    "    exit(3);",
+    "}",
+    "#define CEL_BAD_ELEM \"tipo de elemento incompatible con el array\"",
+    "#define CEL_ONLY_SCALARS \"los arrays sólo admiten int, float o bool\"",
+    "static inline void cel_reserve(cel_arr *a, size_t n){",
+    "    size_t nc = a->cap ? a->cap : 4u;",
+    "    if(n <= a->cap) return;",
+    "    while(nc < n) nc *= 2u;",
+    "    a->d.i = (long long*)realloc(a->d.i, nc * (a->elem == CEL_BOOL ? 1u : 8u));",
+    "    if(!a->d.i){ fputs(\"sin memoria\\n\", stderr); exit(1); }",
+    "    a->cap = nc;",
+    "}",
+    "/* d[i] = v; int se promueve en un float[]. 0 si el tipo no corresponde */",
+    "static inline int cel_put(cel_arr *a, size_t i, cel_v v){",
+    "    switch(a->elem){",
+    "        case CEL_INT:   if(v.k != CEL_INT) return 0; a->d.i[i] = v.as.i; return 1;",
+    "        case CEL_FLOAT: if(v.k != CEL_FLOAT && v.k != CEL_INT) return 0; a->d.f[i] = cel_num(v); return 1;",
+    "        case CEL_BOOL:  if(v.k != CEL_BOOL) return 0; a->d.b[i] = (unsigned char)(v.as.b != 0); return 1;",
+    "        default:        return 0;",
+    "    }",
+    "}",
+    "static inline cel_v cel_array(int line, const char *fn, cel_kind elem, int n, const cel_v *items){",
+    "    cel_arr *a = (cel_arr*)calloc(1, sizeof(cel_arr));",
+    "    cel_v v;",
+    "    int i;",
+    "    if(!a){ fputs(\"sin memoria\\n\", stderr); exit(1); }",
+    "    for(i = 0; elem == CEL_VOID && i < n; i++){",
+    "        cel_kind k = items[i].k;",
+    "        if(k != CEL_INT && k != CEL_FLOAT && k != CEL_BOOL) cel_fail(line, fn, CEL_ONLY_SCALARS);",
+    "        if(i == 0) a->elem = k;",
+    "        else if(k != a->elem){",
+    "            if((k == CEL_BOOL) != (a->elem == CEL_BOOL)) cel_fail(line, fn, CEL_BAD_ELEM);",
+    "            a->elem = CEL_FLOAT; /* int y float mezclados */",
+    "        }",
+    "    }",
+    "    if(elem != CEL_VOID) a->elem = elem;",
+    "    if(n > 0) cel_reserve(a, (size_t)n);",
+    "    for(i = 0; i < n; i++) if(!cel_put(a, (size_t)i, items[i])) cel_fail(line, fn, CEL_BAD_ELEM);",
+    "    a->len = (size_t)n;",
+    "    v.k = CEL_ARRAY; v.as.a = a;",
+    "    return v;",
+    "}",
+    "static inline size_t cel_at(int line, const char *fn, cel_v a, cel_v i){",
+    "    if(a.k != CEL_ARRAY) cel_fail(line, fn, \"sólo se pueden indexar arrays\");",
+    "    if(i.k != CEL_INT) cel_fail(line, fn, \"el índice de un array debe ser int\");",
+    "    if(i.as.i < 0 || (unsigned long long)i.as.i >= a.as.a->len) cel_fail(line, fn, \"índice fuera de rango\");",
+    "    return (size_t)i.as.i;",
+    "}",
+    "static inline cel_v cel_index(int line, const char *fn, cel_v a, cel_v i){ return cel_get(a.as.a, cel_at(line, fn, a, i)); }",
+    "/* a[i] op= v */",
+    "static inline cel_v cel_setindex(int line, const char *fn, int op, cel_v a, cel_v i, cel_v v){",
+    "    size_t at = cel_at(line, fn, a, i);",
+    "    if(op != '='){ cel_v cur = cel_get(a.as.a, at); v = cel_asg(&cur, op, v); }",
+    "    if(!cel_put(a.as.a, at, v)) cel_fail(line, fn, CEL_BAD_ELEM);",
+    "    return cel_get(a.as.a, at);",
+    "}",
+    "static inline cel_v cel_len(int line, const char *fn, int n, const cel_v *a){",
+    "    if(n == 1 && a[0].k == CEL_ARRAY) return cel_int((long long)a[0].as.a->len);",
+    "    if(n == 1 && a[0].k == CEL_STRING) return cel_int((long long)a[0].as.s->n);",
+    "    cel_fail(line, fn, \"len() espera un array o un string\");",
+    "    return cel_void();",
+    "}",
+    "static inline cel_v cel_push(int line, const char *fn, int n, const cel_v *a){",
+    "    cel_arr *arr;",
+    "    if(n != 2) cel_fail(line, fn, \"push() espera un array y un valor\");",
+    "    if(a[0].k != CEL_ARRAY) cel_fail(line, fn, \"push() espera un array\");",
+    "    arr = a[0].as.a;",
+    "    if(arr->elem == CEL_VOID){",
+    "        if(a[1].k != CEL_INT && a[1].k != CEL_FLOAT && a[1].k != CEL_BOOL) cel_fail(line, fn, CEL_ONLY_SCALARS);",
+    "        arr->elem = a[1].k;",
+    "    }",
+    "    cel_reserve(arr, arr->len + 1u);",
+    "    if(!cel_put(arr, arr->len, a[1])) cel_fail(line, fn, CEL_BAD_ELEM);",
+    "    arr->len++;",
+    "    return cel_void();",
+    "}",
+    NULL
+};
+
+// Texto creciente: el cuerpo de una función se genera antes que su cabecera
+// (los temporales se conocen al final).
+typedef struct { char *data; size_t len, cap; } sbuf;
+
+static void sb_reserve(sbuf *b, size_t n){
+    if(b->len + n + 1 <= b->cap) return;
+    size_t nc = b->cap ? b->cap : 256u;
+    while(nc < b->len + n + 1) nc *= 2u;
+    b->data = (char*)realloc(b->data, nc); b->cap = nc;
+}
+static void sb_puts(sbuf *b, const char *s){
+    size_t n = strlen(s);
+    sb_reserve(b, n);
+    memcpy(b->data + b->len, s, n + 1);
+    b->len += n;
+}
+static void sb_printf(sbuf *b, const char *fmt, ...){
+    char tmp[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if(n < 0) return;
+    if((size_t)n < sizeof(tmp)){ sb_puts(b, tmp); return; }
+    sb_reserve(b, (size_t)n);
+    va_start(ap, fmt);
+    vsnprintf(b->data + b->len, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    b->len += (size_t)n;
+}
+// prefijo + nombre de Celer llevado a identificador de C
+static void sb_name(sbuf *b, const char *prefix, const char *name){
+    sb_puts(b, prefix);
+    sb_reserve(b, strlen(name));
+    for(const char *p = name; *p; p++)
+        b->data[b->len++] = (isalnum((unsigned char)*p) || *p == '_') ? *p : '_';
+    b->data[b->len] = '\0';
+}
+// literal de string de C con los bytes [p, p+n)
+static void sb_cstr(sbuf *b, const char *p, size_t n){
+    sb_puts(b, "\"");
+    for(size_t i = 0; i < n; i++){
+        unsigned char c = (unsigned char)p[i];
+        if(c == '"' || c == '\\' || c == '?') sb_printf(b, "\\%c", c);
+        else if(c >= 0x20 && c < 0x7f) sb_printf(b, "%c", c);
+        else sb_printf(b, "\\%03o", c);
+    }
+    sb_puts(b, "\"");
+}
+
+typedef struct {
+    const program_ast *P;
+    char **fnames;                    // nombre C por declaración (NULL en variables)
+    bool *called;                     // alcanzable desde el script (ver mark_called)
+    int cur;                          // declaración en curso; -1 en el script
+    int *edges; size_t edges_count, edges_cap; // llamadas: pares (desde, hacia)
+    const char **globals; size_t globals_count, globals_cap;
+    const value_t **strs; size_t strs_count, strs_cap; // literales (cel_sN)
+    size_t limit;                     // funciones visibles: decls[0..limit)
+    const func_decl *fn;              // función en curso; NULL en el script
+    int *scopes; size_t scopes_count, scopes_cap; // primera variable C de cada frame
+    int nvars, ntemps;
+    bool self_tail;                   // la función salta a cel_entry
+    sbuf *b;
+    int ind;
+} emitter_t;
+
+// ----- nombres -----
+
+static void note_call(emitter_t *em, int fi){
+    if(em->edges_count + 2 > em->edges_cap){
+        em->edges_cap = em->edges_cap ? em->edges_cap * 2u : 32u;
+        em->edges = (int*)realloc(em->edges, em->edges_cap * sizeof(*em->edges));
+    }
+    em->edges[em->edges_count++] = em->cur;
+    em->edges[em->edges_count++] = fi;
+}
+
+static void add_global(emitter_t *em, const char *name){
+    for(size_t i = 0; i < em->globals_count; i++)
+        if(strcmp(em->globals[i], name) == 0) return;
+    if(em->globals_count == em->globals_cap){
+        em->globals_cap = em->globals_cap ? em->globals_cap * 2u : 16u;
+        em->globals = (const char**)realloc(em->globals, em->globals_cap * sizeof(*em->globals));
+    }
+    em->globals[em->globals_count++] = name;
+}
+
+static void collect_expr(emitter_t *em, const expr *e){
+    if(!e) return;
+    switch(e->kind){
+        case EXPR_IDENT: if(e->as.ident.depth < 0) add_global(em, e->as.ident.name); break;
+        case EXPR_UNARY: collect_expr(em, e->as.unary.right); break;
+        case EXPR_BINARY: collect_expr(em, e->as.binary.left); collect_expr(em, e->as.binary.right); break;
+        case EXPR_ASSIGN:
+            if(e->as.assign.depth < 0) add_global(em, e->as.assign.name);
+            collect_expr(em, e->as.assign.value);
+            break;
+        case EXPR_GROUPING: collect_expr(em, e->as.grouping.inner); break;
+        case EXPR_TERNARY:
+            collect_expr(em, e->as.ternary.cond);
+            collect_expr(em, e->as.ternary.when_true);
+            collect_expr(em, e->as.ternary.when_false);
+            break;
+        case EXPR_CALL:
+            for(size_t i = 0; i < e->as.call.args.count; i++) collect_expr(em, e->as.call.args.items[i]);
+            break;
+        case EXPR_ARRAY:
+            for(size_t i = 0; i < e->as.array.items.count; i++) collect_expr(em, e->as.array.items.items[i]);
+            break;
+        case EXPR_INDEX: collect_expr(em, e->as.index.target); collect_expr(em, e->as.index.index); break;
+        case EXPR_INDEX_ASSIGN:
+            collect_expr(em, e->as.index_assign.target);
+            collect_expr(em, e->as.index_assign.index);
+            collect_expr(em, e->as.index_assign.value);
+            break;
+        default: break;
+    }
+}
+
+static void collect_stmt(emitter_t *em, const stmt *s){
+    if(!s) return;
+    switch(s->kind){
+        case STMT_EXPR: collect_expr(em, s->as.expr_stmt.value); break;
+        case STMT_RETURN: collect_expr(em, s->as.ret.value); break;
+        case STMT_BLOCK:
+            for(size_t i = 0; i < s->as.block.stmts.count; i++) collect_stmt(em, s->as.block.stmts.items[i]);
+            break;
+        case STMT_IF:
+            collect_expr(em, s->as.if_stmt.cond);
+            collect_stmt(em, s->as.if_stmt.then_branch);
+            collect_stmt(em, s->as.if_stmt.else_branch);
+            break;
+        case STMT_FOR_WHILELIKE: collect_expr(em, s->as.for_while.cond); collect_stmt(em, s->as.for_while.body); break;
+        case STMT_FOR_CLIKE:
+            collect_stmt(em, s->as.for_clike.init);
+            collect_expr(em, s->as.for_clike.cond);
+            collect_expr(em, s->as.for_clike.post);
+            collect_stmt(em, s->as.for_clike.body);
+            break;
+        default: break;
+    }
+}
+
+static size_t add_string(emitter_t *em, const value_t *v){
+    for(size_t i = 0; i < em->strs_count; i++){
+        const value_t *o = em->strs[i];
+        if(value_strlen(o) == value_strlen(v) && memcmp(value_str(o), value_str(v), value_strlen(v)) == 0) return i;
+    }
+    if(em->strs_count == em->strs_cap){
+        em->strs_cap = em->strs_cap ? em->strs_cap * 2u : 16u;
+        em->strs = (const value_t**)realloc(em->strs, em->strs_cap * sizeof(*em->strs));
+    }
+    em->strs[em->strs_count] = v;
+    return em->strs_count++;
+}
+
+// Función que resuelve `name` en ese punto: la última declarada (como
+// env_get_func), y en un inicializador global sólo las anteriores.
+// stats() no tiene contadores en el programa generado: da void, aunque el
+// programa defina una función con ese nombre (los builtins tienen prioridad);
+// len() y push() van al runtime
+static bool builtin_name(const char *name){
+    return strcmp(name, "stats") == 0 || strcmp(name, "len") == 0 || strcmp(name, "push") == 0;
+}
+
+static int find_func(const emitter_t *em, const char *name){
+    if(builtin_name(name)) return -1;
+    for(size_t i = em->limit; i > 0; i--){
+        const decl *d = em->P->decls.items[i - 1];
+        if(d->kind == DECL_FUNC && strcmp(d->as.func.name, name) == 0) return (int)(i - 1);
+    }
+    return -1;
+}
+
+static void ex_var(emitter_t *em, const char *name, int depth, int slot){
+    if(depth < 0 || (size_t)depth >= em->scopes_count){ sb_name(em->b, "g_", name); return; }
+    sb_printf(em->b, "v%d", em->scopes[em->scopes_count - 1 - (size_t)depth] + slot);
+}
+
+// `línea, "función"` para los errores de ejecución del runtime
+static void ex_where(emitter_t *em, int line){
+    const char *fn = em->fn ? em->fn->name : "<script>";
+    sb_printf(em->b, "%d, ", line);
+    sb_cstr(em->b, fn, strlen(fn));
+}
+
+static void push_scope(emitter_t *em, int base){
+    if(em->scopes_count == em->scopes_cap){
+        em->scopes_cap = em->scopes_cap ? em->scopes_cap * 2u : 16u;
+        em->scopes = (int*)realloc(em->scopes, em->scopes_cap * sizeof(int));
+    }
+    em->scopes[em->scopes_count++] = base;
+}
+
+// ----- expresiones -----
+// Tres formas: ex_box da un cel_v, ex_raw el escalar de C del tipo estático
+// (long long, double o int 0/1) y ex_cond la veracidad como int de C.
+
+static bool scalar(type_kind t){ return t == TYPE_INT || t == TYPE_FLOAT || t == TYPE_BOOL; }
+static const char *field(type_kind t){ return t == TYPE_INT ? "i" : t == TYPE_FLOAT ? "f" : "b"; }
+static const char *boxer(type_kind t){ return t == TYPE_INT ? "cel_int" : t == TYPE_FLOAT ? "cel_float" : "cel_bool"; }
+
+static bool is_literal(const expr *e){
+    return e->kind == EXPR_INT_LIT || e->kind == EXPR_FLOAT_LIT || e->kind == EXPR_BOOL_LIT || e->kind == EXPR_STRING_LIT;
+}
+
+// Tiene efectos (llamadas o asignaciones, también a un elemento).
+static bool impure(const expr *e){
+    if(!e) return false;
+    switch(e->kind){
+        case EXPR_CALL: case EXPR_ASSIGN: case EXPR_INDEX_ASSIGN: return true;
+        case EXPR_INDEX: return impure(e->as.index.target) || impure(e->as.index.index);
+        case EXPR_ARRAY:
+            for(size_t i = 0; i < e->as.array.items.count; i++)
+                if(impure(e->as.array.items.items[i])) return true;
+            return false;
+        case EXPR_UNARY: return impure(e->as.unary.right);
+        case EXPR_BINARY: return impure(e->as.binary.left) || impure(e->as.binary.right);
+        case EXPR_GROUPING: return impure(e->as.grouping.inner);
+        case EXPR_TERNARY:
+            return impure(e->as.ternary.cond) || impure(e->as.ternary.when_true) || impure(e->as.ternary.when_false);
+        default: return false;
+    }
+}
+
+// C no fija el orden de los operandos ni de los argumentos: si uno tiene
+// efectos y otro no es literal se evalúan en orden a temporales.
+static bool needs_order(expr *const *items, size_t n){
+    size_t nonlit = 0; bool eff = false;
+    for(size_t i = 0; i < n; i++){
+        if(!is_literal(items[i])) nonlit++;
+        if(impure(items[i])) eff = true;
+    }
+    return eff && nonlit >= 2;
+}
+
+static char assign_char(op_kind op){
+    switch(op){
+        case OP_PLUS_ASSIGN:    return '+';
+        case OP_MINUS_ASSIGN:   return '-';
+        case OP_STAR_ASSIGN:    return '*';
+        case OP_SLASH_ASSIGN:   return '/';
+        case OP_PERCENT_ASSIGN: return '%';
+        default:                return '=';
+    }
+}
+
+// Hay forma escalar directa (sin pasar por cel_v); misma elección que los
+// kernels monomórficos de eval.c.
+static bool has_raw(const expr *e){
+    if(!scalar(e->type)) return false;
+    switch(e->kind){
+        case EXPR_INT_LIT: case EXPR_FLOAT_LIT: case EXPR_BOOL_LIT: case EXPR_IDENT:
+        case EXPR_GROUPING: case EXPR_TERNARY:
+            return true;
+        case EXPR_UNARY: {
+            type_kind rt = e->as.unary.right->type;
+            if(e->as.unary.op == OP_NOT) return true;
+            return e->as.unary.op == OP_SUB && rt == e->type && (rt == TYPE_INT || rt == TYPE_FLOAT);
+        }
+        case EXPR_BINARY: {
+            op_kind op = e->as.binary.op;
+            type_kind lt = e->as.binary.left->type;
+            if(op == OP_AND || op == OP_OR) return true;
+            if(lt != e->as.binary.right->type) return false;
+            if(lt == TYPE_INT) return true;
+            if(lt == TYPE_FLOAT) return op != OP_MOD;
+            if(lt == TYPE_BOOL) return op == OP_EQ || op == OP_NEQ;
+            return false;
+        }
+        case EXPR_ASSIGN: {
+            op_kind op = e->as.assign.op;
+            if(op == OP_ASSIGN || !e->as.assign.value || e->as.assign.value->type != e->type) return false;
+            return e->type == TYPE_INT || (e->type == TYPE_FLOAT && op != OP_PERCENT_ASSIGN);
+        }
+        default:
+            return false;
+    }
+}
+
+static void ex_box(emitter_t *em, const expr *e);
+static void ex_raw(emitter_t *em, const expr *e);
+static void ex_cond(emitter_t *em, const expr *e);
+
+// e como escalar del tipo t
+static void ex_as(emitter_t *em, const expr *e, type_kind t){
+    if(e->type == t){ ex_raw(em, e); return; }
+    sb_puts(em->b, "("); ex_box(em, e); sb_printf(em->b, ").as.%s", field(t));
+}
+
+static void ex_int(sbuf *b, long long v){
+    if(v == -9223372036854775807LL - 1) sb_puts(b, "(-9223372036854775807LL - 1)");
+    else if(v < 0) sb_printf(b, "(%lldLL)", v);
+    else sb_printf(b, "%lldLL", v);
+}
+
+static void ex_float(sbuf *b, double v){
+    if(v != v){ sb_puts(b, "NAN"); return; }
+    if(isinf(v)){ sb_puts(b, v < 0 ? "(-HUGE_VAL)" : "HUGE_VAL"); return; }
+    char tmp[64];
+    snprintf(tmp, sizeof(tmp), "%.17g", v);
+    if(!strpbrk(tmp, ".e")) strcat(tmp, ".0");
+    if(tmp[0] == '-') sb_printf(b, "(%s)", tmp); else sb_puts(b, tmp);
+}
+
+// operando de una operación escalar: temporal ya evaluado o expresión directa
+static void ex_operand(emitter_t *em, const expr *e, int temp, type_kind t){
+    if(temp >= 0) sb_printf(em->b, "t%d.as.%s", temp, field(t));
+    else ex_as(em, e, t);
+}
+
+static void ex_binary_raw(emitter_t *em, const expr *e){
+    sbuf *b = em->b;
+    const expr *L = e->as.binary.left, *R = e->as.binary.right;
+    op_kind op = e->as.binary.op;
+    type_kind t = L->type;
+    if(op == OP_AND || op == OP_OR){
+        sb_puts(b, "("); ex_cond(em, L);
+        sb_puts(b, op == OP_AND ? " && " : " || ");
+        ex_cond(em, R); sb_puts(b, ")");
+        return;
+    }
+    const char *pre = "(", *mid = " + ", *post = ")";
+    if(t == TYPE_INT){
+        switch(op){
+            case OP_ADD: pre = "cel_addi("; mid = ", "; break;
+            case OP_SUB: pre = "cel_subi("; mid = ", "; break;
+            case OP_MUL: pre = "cel_muli("; mid = ", "; break;
+            case OP_DIV: pre = "cel_divi("; mid = ", "; break;
+            case OP_MOD: pre = "cel_modi("; mid = ", "; break;
+            case OP_EQ:  mid = " == "; break;
+            case OP_NEQ: mid = " != "; break;
+            case OP_LT:  mid = " < "; break;
+            case OP_LTE: mid = " <= "; break;
+            case OP_GT:  mid = " > "; break;
+            case OP_GTE: mid = " >= "; break;
+            default: break;
+        }
+    } else if(t == TYPE_FLOAT){
+        switch(op){
+            case OP_ADD: mid = " + "; break;
+            case OP_SUB: mid = " - "; break;
+            case OP_MUL: mid = " * "; break;
+            case OP_DIV: mid = " / "; break;
+            case OP_EQ:  pre = "cel_eqf("; mid = ", "; break;
+            case OP_NEQ: pre = "!cel_eqf("; mid = ", "; break;
+            case OP_LT:  mid = " < "; break;
+            case OP_LTE: pre = "cel_lef("; mid = ", "; break;
+            case OP_GT:  pre = "!cel_lef("; mid = ", "; break;
+            case OP_GTE: pre = "!("; mid = " < "; break;
+            default: break;
+        }
+    } else {
+        mid = op == OP_EQ ? " == " : " != ";
+    }
+    int tl = -1, tr = -1;
+    expr *pair[2] = { e->as.binary.left, e->as.binary.right };
+    if(needs_order(pair, 2)){
+        tl = em->ntemps++; tr = em->ntemps++;
+        sb_printf(b, "(t%d = ", tl); ex_box(em, L);
+        sb_printf(b, ", t%d = ", tr); ex_box(em, R);
+        sb_puts(b, ", ");
+    }
+    sb_puts(b, pre); ex_operand(em, L, tl, t);
+    sb_puts(b, mid); ex_operand(em, R, tr, t);
+    sb_puts(b, post);
+    if(tl >= 0) sb_puts(b, ")");
+}
+
+static void ex_raw(emitter_t *em, const expr *e){
+    sbuf *b = em->b;
+    if(!has_raw(e)){
+        sb_puts(b, "("); ex_box(em, e); sb_printf(b, ").as.%s", field(e->type));
+        return;
+    }
+    switch(e->kind){
+        case EXPR_INT_LIT:   ex_int(b, e->as.int_lit.value); break;
+        case EXPR_FLOAT_LIT: ex_float(b, e->as.float_lit.value); break;
+        case EXPR_BOOL_LIT:  sb_puts(b, e->as.bool_lit.value ? "1" : "0"); break;
+        case EXPR_IDENT:
+            ex_var(em, e->as.ident.name, e->as.ident.depth, e->as.ident.slot);
+            sb_printf(b, ".as.%s", field(e->type));
+            break;
+        case EXPR_GROUPING: ex_as(em, e->as.grouping.inner, e->type); break;
+        case EXPR_UNARY:
+            if(e->as.unary.op == OP_NOT){ sb_puts(b, "(!"); ex_cond(em, e->as.unary.right); sb_puts(b, ")"); }
+            else if(e->type == TYPE_INT){ sb_puts(b, "cel_negi("); ex_raw(em, e->as.unary.right); sb_puts(b, ")"); }
+            else { sb_puts(b, "(0.0 - "); ex_raw(em, e->as.unary.right); sb_puts(b, ")"); }
+            break;
+        case EXPR_BINARY: ex_binary_raw(em, e); break;
+        case EXPR_ASSIGN:
+            sb_printf(b, "cel_asg%s(&", e->type == TYPE_INT ? "i" : "f");
+            ex_var(em, e->as.assign.name, e->as.assign.depth, e->as.assign.slot);
+            sb_printf(b, ", '%c', ", assign_char(e->as.assign.op));
+            ex_raw(em, e->as.assign.value);
+            sb_puts(b, ")");
+            break;
+        case EXPR_TERNARY:
+            sb_puts(b, "("); ex_cond(em, e->as.ternary.cond);
+            sb_puts(b, " ? "); ex_as(em, e->as.ternary.when_true, e->type);
+            sb_puts(b, " : "); ex_as(em, e->as.ternary.when_false, e->type);
+            sb_puts(b, ")");
+            break;
+        default: break;
+    }
+}
+
+static void ex_cond(emitter_t *em, const expr *e){
+    sbuf *b = em->b;
+    switch(e->kind){
+        case EXPR_GROUPING: ex_cond(em, e->as.grouping.inner); return;
+        case EXPR_UNARY:
+            if(e->as.unary.op == OP_NOT){ sb_puts(b, "(!"); ex_cond(em, e->as.unary.right); sb_puts(b, ")"); return; }
+            break;
+        case EXPR_BINARY:
+            if(e->as.binary.op == OP_AND || e->as.binary.op == OP_OR){ ex_binary_raw(em, e); return; }
+            break;
+        default: break;
+    }
+    if(!has_raw(e)){ sb_puts(b, "cel_truthy("); ex_box(em, e); sb_puts(b, ")"); return; }
+    switch(e->type){
+        case TYPE_BOOL: ex_raw(em, e); break;
+        case TYPE_INT:  sb_puts(b, "("); ex_raw(em, e); sb_puts(b, " != 0)"); break;
+        default:        sb_puts(b, "cel_truef("); ex_raw(em, e); sb_puts(b, ")"); break;
+    }
+}
+
+static void ex_call(emitter_t *em, const expr *e){
+    sbuf *b = em->b;
+    const expr_vec *args = &e->as.call.args;
+    // llamada sobre una expresión: el intérprete no evalúa nada y da void
+    if(e->as.call.callee->kind != EXPR_IDENT){ sb_puts(b, "cel_void()"); return; }
+    const char *name = e->as.call.callee->as.ident.name;
+    // los builtins tienen prioridad; print, len y push reciben (n, args)
+    bool rt = strcmp(name, "len") == 0 || strcmp(name, "push") == 0;
+    bool builtin = rt || strcmp(name, "print") == 0;
+    int fi = builtin ? -1 : find_func(em, name);
+    if(!builtin && fi < 0){
+        sb_puts(b, "(");
+        for(size_t i = 0; i < args->count; i++){ sb_puts(b, "(void)"); ex_box(em, args->items[i]); sb_puts(b, ", "); }
+        sb_puts(b, "cel_void())");
+        return;
+    }
+    size_t np = builtin ? args->count : em->P->decls.items[fi]->as.func.params.count;
+    bool spill = args->count > np || needs_order(args->items, args->count);
+    int t0 = em->ntemps;
+    if(spill){
+        em->ntemps += (int)args->count;
+        sb_puts(b, "(");
+        for(size_t i = 0; i < args->count; i++){
+            sb_printf(b, "t%d = ", t0 + (int)i); ex_box(em, args->items[i]); sb_puts(b, ", ");
+        }
+    }
+    if(builtin){
+        sb_printf(b, "cel_%s(", name);
+        if(rt){ ex_where(em, e->line); sb_puts(b, ", "); }
+    } else {
+        sb_printf(b, "%s(", em->fnames[fi]); note_call(em, fi);
+    }
+    if(builtin && np == 0) sb_puts(b, "0, NULL");
+    else {
+        if(builtin) sb_printf(b, "%zu, (cel_v[]){", np);
+        for(size_t i = 0; i < np; i++){
+            if(i) sb_puts(b, ", ");
+            if(i >= args->count) sb_puts(b, "cel_void()");
+            else if(spill) sb_printf(b, "t%d", t0 + (int)i);
+            else ex_box(em, args->items[i]);
+        }
+        if(builtin) sb_puts(b, "}");
+    }
+    sb_puts(b, ")");
+    if(spill) sb_puts(b, ")");
+}
+
+// Operandos de una llamada al runtime: si el orden importa se evalúan antes
+// a temporales; devuelve el primero (o -1) y el llamador cierra el `(` extra.
+static int ex_spill(emitter_t *em, expr *const *items, size_t n){
+    if(!needs_order(items, n)) return -1;
+    int t0 = em->ntemps;
+    em->ntemps += (int)n;
+    sb_puts(em->b, "(");
+    for(size_t i = 0; i < n; i++){
+        sb_printf(em->b, "t%d = ", t0 + (int)i); ex_box(em, items[i]); sb_puts(em->b, ", ");
+    }
+    return t0;
+}
+
+static void ex_operands(emitter_t *em, expr *const *items, size_t n, int t0){
+    for(size_t i = 0; i < n; i++){
+        if(i) sb_puts(em->b, ", ");
+        if(t0 >= 0) sb_printf(em->b, "t%d", t0 + (int)i); else ex_box(em, items[i]);
+    }
+}
+
+static const char *elem_kind(type_kind t){
+    switch(type_elem_of(t)){
+        case TYPE_INT:   return "CEL_INT";
+        case TYPE_FLOAT: return "CEL_FLOAT";
+        case TYPE_BOOL:  return "CEL_BOOL";
+        default:         return "CEL_VOID";
+    }
+}
+
+static void ex_box(emitter_t *em, const expr *e){
+    sbuf *b = em->b;
+    if(e->kind == EXPR_IDENT){ ex_var(em, e->as.ident.name, e->as.ident.depth, e->as.ident.slot); return; }
+    if(has_raw(e)){ sb_printf(b, "%s(", boxer(e->type)); ex_raw(em, e); sb_puts(b, ")"); return; }
+    switch(e->kind){
+        case EXPR_INT_LIT:   sb_puts(b, "cel_int("); ex_int(b, e->as.int_lit.value); sb_puts(b, ")"); break;
+        case EXPR_FLOAT_LIT: sb_puts(b, "cel_float("); ex_float(b, e->as.float_lit.value); sb_puts(b, ")"); break;
+        case EXPR_BOOL_LIT:  sb_puts(b, e->as.bool_lit.value ? "cel_bool(1)" : "cel_bool(0)"); break;
+        case EXPR_STRING_LIT:
+            sb_printf(b, "cel_string(cel_s%zu)", add_string(em, &e->as.string_lit.value));
+            break;
+        case EXPR_GROUPING: ex_box(em, e->as.grouping.inner); break;
+        case EXPR_UNARY:
+            if(e->as.unary.op == OP_NOT){ sb_puts(b, "cel_bool(!"); ex_cond(em, e->as.unary.right); sb_puts(b, ")"); }
+            else { sb_puts(b, "cel_neg("); ex_box(em, e->as.unary.right); sb_puts(b, ")"); }
+            break;
+        case EXPR_BINARY: {
+            static const char *names[] = {
+                [OP_ADD] = "add", [OP_SUB] = "sub", [OP_MUL] = "mul", [OP_DIV] = "div", [OP_MOD] = "mod",
+                [OP_EQ] = "eq", [OP_NEQ] = "neq", [OP_LT] = "lt", [OP_LTE] = "lte", [OP_GT] = "gt", [OP_GTE] = "gte",
+            };
+            op_kind op = e->as.binary.op;
+            if(op == OP_AND || op == OP_OR){ sb_puts(b, "cel_bool("); ex_binary_raw(em, e); sb_puts(b, ")"); break; }
+            if(op < OP_ADD || op > OP_GTE){ sb_puts(b, "cel_void()"); break; }
+            expr *pair[2] = { e->as.binary.left, e->as.binary.right };
+            if(needs_order(pair, 2)){
+                int tl = em->ntemps++, tr = em->ntemps++;
+                sb_printf(b, "(t%d = ", tl); ex_box(em, pair[0]);
+                sb_printf(b, ", t%d = ", tr); ex_box(em, pair[1]);
+                sb_printf(b, ", cel_%s(t%d, t%d))", names[op], tl, tr);
+            } else {
+                sb_printf(b, "cel_%s(", names[op]); ex_box(em, pair[0]);
+                sb_puts(b, ", "); ex_box(em, pair[1]); sb_puts(b, ")");
+            }
+            break;
+        }
+        case EXPR_ASSIGN:
+            if(e->as.assign.op == OP_ASSIGN){
+                sb_puts(b, "(");
+                ex_var(em, e->as.assign.name, e->as.assign.depth, e->as.assign.slot);
+                sb_puts(b, " = ");
+                if(e->as.assign.value) ex_box(em, e->as.assign.value); else sb_puts(b, "cel_void()");
+                sb_puts(b, ")");
+            } else {
+                sb_puts(b, "cel_asg(&");
+                ex_var(em, e->as.assign.name, e->as.assign.depth, e->as.assign.slot);
+                sb_printf(b, ", '%c', ", assign_char(e->as.assign.op));
+                if(e->as.assign.value) ex_box(em, e->as.assign.value); else sb_puts(b, "cel_void()");
+                sb_puts(b, ")");
+            }
+            break;
+        case EXPR_TERNARY:
+            sb_puts(b, "("); ex_cond(em, e->as.ternary.cond);
+            sb_puts(b, " ? "); ex_box(em, e->as.ternary.when_true);
+            sb_puts(b, " : "); ex_box(em, e->as.ternary.when_false);
+            sb_puts(b, ")");
+            break;
+        case EXPR_CALL: ex_call(em, e); break;
+        case EXPR_ARRAY: {
+            size_t n = e->as.array.items.count;
+            int t0 = ex_spill(em, e->as.array.items.items, n);
+            sb_puts(b, "cel_array("); ex_where(em, e->line);
+            sb_printf(b, ", %s, %zu, ", elem_kind(e->type), n);
+            if(n == 0) sb_puts(b, "NULL");
+            else { sb_puts(b, "(cel_v[]){"); ex_operands(em, e->as.array.items.items, n, t0); sb_puts(b, "}"); }
+            sb_puts(b, t0 >= 0 ? "))" : ")");
+            break;
+        }
+        case EXPR_INDEX: {
+            expr *ops[2] = { e->as.index.target, e->as.index.index };
+            int t0 = ex_spill(em, ops, 2);
+            sb_puts(b, "cel_index("); ex_where(em, e->line); sb_puts(b, ", ");
+            ex_operands(em, ops, 2, t0);
+            sb_puts(b, t0 >= 0 ? "))" : ")");
+            break;
+        }
+        case EXPR_INDEX_ASSIGN: {
+            expr *ops[3] = { e->as.index_assign.target, e->as.index_assign.index, e->as.index_assign.value };
+            int t0 = ex_spill(em, ops, 3);
+            sb_puts(b, "cel_setindex("); ex_where(em, e->line);
+            sb_printf(b, ", '%c', ", assign_char(e->as.index_assign.op));
+            ex_operands(em, ops, 3, t0);
+            sb_puts(b, t0 >= 0 ? "))" : ")");
+            break;
+        }
+        default: sb_puts(b, "cel_void()"); break;
+    }
+}
+
+// e evaluada sólo por sus efectos (sentencia o post de un for)
+static void ex_effect(emitter_t *em, const expr *e){
+    if(e->kind == EXPR_ASSIGN && e->as.assign.op == OP_ASSIGN){
+        ex_var(em, e->as.assign.name, e->as.assign.depth, e->as.assign.slot);
+        sb_puts(em->b, " = ");
+        if(e->as.assign.value) ex_box(em, e->as.assign.value); else sb_puts(em->b, "cel_void()");
+    } else if(e->kind == EXPR_ASSIGN && has_raw(e)) ex_raw(em, e);
+    else if(e->kind == EXPR_CALL || e->kind == EXPR_ASSIGN) ex_box(em, e);
+    else { sb_puts(em->b, "(void)"); if(has_raw(e)) ex_raw(em, e); else ex_box(em, e); }
+}
+
+// ----- sentencias -----
+
+static void indent(emitter_t *em){
+    for(int i = 0; i < em->ind; i++) sb_puts(em->b, "    ");
+}
+
+static void emit_stmt(emitter_t *em, const stmt *s);
+
+// `{ ... }` sin sangría inicial ni salto final; las variables del frame se
+// declaran al entrar (en void, como env_push_frame)
+static void emit_block(emitter_t *em, const stmt *s){
+    int n = s->as.block.nslots, base = em->nvars;
+    sb_puts(em->b, "{\n");
+    em->ind++;
+    em->nvars += n;
+    if(n > 0){
+        indent(em); sb_puts(em->b, "cel_v ");
+        for(int i = 0; i < n; i++) sb_printf(em->b, "%sv%d = cel_void()", i ? ", " : "", base + i);
+        sb_puts(em->b, ";");
+        // una variable del fuente que nunca se lee no debe dar warnings en C
+        for(int i = 0; i < n; i++) sb_printf(em->b, " (void)v%d;", base + i);
+        sb_puts(em->b, "\n");
+    }
+    push_scope(em, base);
+    for(size_t i = 0; i < s->as.block.stmts.count; i++) emit_stmt(em, s->as.block.stmts.items[i]);
+    em->scopes_count--;
+    em->ind--;
+    indent(em); sb_puts(em->b, "}");
+}
+
+// cuerpo de if/for, siempre entre llaves
+static void emit_body(emitter_t *em, const stmt *s){
+    sb_puts(em->b, " ");
+    if(s->kind == STMT_BLOCK){ emit_block(em, s); return; }
+    sb_puts(em->b, "{\n");
+    em->ind++; emit_stmt(em, s); em->ind--;
+    indent(em); sb_puts(em->b, "}");
+}
+
+// return f(...) a una función del programa: los args se evalúan en este
+// frame y la llamada no suma profundidad (como el trampolín de eval.c); si
+// f es la función en curso se reasignan los parámetros y se salta al inicio.
+static bool emit_tail_call(emitter_t *em, const expr *e){
+    if(!e || e->kind != EXPR_CALL || e->as.call.callee->kind != EXPR_IDENT) return false;
+    if(strcmp(e->as.call.callee->as.ident.name, "print") == 0) return false;
+    int fi = find_func(em, e->as.call.callee->as.ident.name);
+    if(fi < 0) return false;
+    const func_decl *target = &em->P->decls.items[fi]->as.func;
+    note_call(em, fi);
+    const expr_vec *args = &e->as.call.args;
+    size_t np = target->params.count;
+    int t0 = em->ntemps;
+    em->ntemps += (int)args->count;
+    indent(em); sb_puts(em->b, "{\n");
+    em->ind++;
+    for(size_t i = 0; i < args->count; i++){
+        indent(em); sb_printf(em->b, "t%d = ", t0 + (int)i);
+        ex_box(em, args->items[i]); sb_puts(em->b, ";\n");
+    }
+    if(target == em->fn){
+        for(size_t i = 0; i < np; i++){
+            indent(em);
+            if(i < args->count) sb_printf(em->b, "v%zu = t%d;\n", i, t0 + (int)i);
+            else sb_printf(em->b, "v%zu = cel_void();\n", i);
+        }
+        indent(em); sb_puts(em->b, "goto cel_entry;\n");
+        em->self_tail = true;
+    } else {
+        indent(em); sb_puts(em->b, "cel_depth--;\n");
+        indent(em); sb_printf(em->b, "return %s(", em->fnames[fi]);
+        for(size_t i = 0; i < np; i++){
+            if(i) sb_puts(em->b, ", ");
+            if(i < args->count) sb_printf(em->b, "t%d", t0 + (int)i);
+            else sb_puts(em->b, "cel_void()");
+        }
+        sb_puts(em->b, ");\n");
+    }
+    em->ind--;
+    indent(em); sb_puts(em->b, "}\n");
+    return true;
+}
+
+static void emit_stmt(emitter_t *em, const stmt *s){
+    sbuf *b = em->b;
+    switch(s->kind){
+        case STMT_EXPR:
+            indent(em); ex_effect(em, s->as.expr_stmt.value); sb_puts(b, ";\n");
+            break;
+        case STMT_RETURN:
+            if(emit_tail_call(em, s->as.ret.value)) break;
+            indent(em); sb_puts(b, "CEL_RETURN(");
+            if(s->as.ret.value) ex_box(em, s->as.ret.value); else sb_puts(b, "cel_void()");
+            sb_puts(b, ");\n");
+            break;
+        case STMT_BREAK:    indent(em); sb_puts(b, "break;\n"); break;
+        case STMT_CONTINUE: indent(em); sb_puts(b, "continue;\n"); break;
+        case STMT_BLOCK:    indent(em); emit_block(em, s); sb_puts(b, "\n"); break;
+        case STMT_IF:
+            indent(em); sb_puts(b, "if("); ex_cond(em, s->as.if_stmt.cond); sb_puts(b, ")");
+            emit_body(em, s->as.if_stmt.then_branch);
+            if(s->as.if_stmt.else_branch){ sb_puts(b, " else"); emit_body(em, s->as.if_stmt.else_branch); }
+            sb_puts(b, "\n");
+            break;
+        case STMT_FOR_WHILELIKE:
+            indent(em); sb_puts(b, "while("); ex_cond(em, s->as.for_while.cond); sb_puts(b, ")");
+            emit_body(em, s->as.for_while.body);
+            sb_puts(b, "\n");
+            break;
+        case STMT_FOR_CLIKE:
+            // init, cond y post viven en el bloque que contiene al for
+            if(s->as.for_clike.init) emit_stmt(em, s->as.for_clike.init);
+            indent(em); sb_puts(b, "for(; ");
+            if(s->as.for_clike.cond) ex_cond(em, s->as.for_clike.cond);
+            sb_puts(b, "; ");
+            if(s->as.for_clike.post) ex_effect(em, s->as.for_clike.post);
+            sb_puts(b, ")");
+            emit_body(em, s->as.for_clike.body);
+            sb_puts(b, "\n");
+            break;
+    }
+}
+
+// ----- programa -----
+
+static void emit_temps(sbuf *out, int n){
+    if(n <= 0) return;
+    sb_puts(out, "    cel_v ");
+    for(int i = 0; i < n; i++) sb_printf(out, "%st%d", i ? ", " : "", i);
+    sb_puts(out, ";\n");
+}
+
+static void emit_signature(emitter_t *em, sbuf *out, size_t di){
+    const func_decl *f = &em->P->decls.items[di]->as.func;
+    sb_printf(out, "static cel_v %s(", em->fnames[di]);
+    if(f->params.count == 0) sb_puts(out, "void");
+    for(size_t i = 0; i < f->params.count; i++) sb_printf(out, "%scel_v v%zu", i ? ", " : "", i);
+    sb_puts(out, ")");
+}
+
+static void emit_function(emitter_t *em, sbuf *out, size_t di){
+    const func_decl *f = &em->P->decls.items[di]->as.func;
+    sbuf body = { NULL, 0, 0 };
+    em->fn = f; em->cur = (int)di; em->limit = em->P->decls.count;
+    em->scopes_count = 0;
+    push_scope(em, 0);
+    em->nvars = (int)f->params.count;
+    em->ntemps = 0; em->self_tail = false;
+    em->b = &body; em->ind = 1;
+    indent(em); emit_block(em, f->body); sb_puts(&body, "\n");
+    em->scopes_count = 0;
+
+    emit_signature(em, out, di);
+    sb_puts(out, "{\n");
+    emit_temps(out, em->ntemps);
+    sb_printf(out, "    CEL_ENTER(%d, ", f->line);
+    sb_cstr(out, f->name, strlen(f->name));
+    sb_puts(out, ");\n");
+    if(f->params.count){
+        sb_puts(out, "   ");
+        for(size_t i = 0; i < f->params.count; i++) sb_printf(out, " (void)v%zu;", i);
+        sb_puts(out, "\n");
+    }
+    if(em->self_tail) sb_puts(out, "cel_entry:\n");
+    if(body.data) sb_puts(out, body.data);
+    sb_puts(out, "    CEL_RETURN(cel_void());\n}\n\n");
+    free(body.data);
+}
+
+// Marca en em->called las funciones que el script alcanza, directa o
+// transitivamente. Una función expandida en todos sus sitios puede seguir
+// llamando a otras desde su cuerpo: si nadie la llama, ésas tampoco se escriben.
+static void mark_called(emitter_t *em, size_t nd){
+    size_t ne = em->edges_count / 2u;
+    size_t *first = (size_t*)calloc(nd + 3u, sizeof(size_t)); // aristas por origen (CSR)
+    int *to = (int*)malloc((ne ? ne : 1u) * sizeof(int));
+    int *stack = (int*)malloc((nd ? nd : 1u) * sizeof(int));
+    size_t sp = 0;
+    for(size_t i = 0; i < ne; i++) first[em->edges[2*i] + 3]++;
+    for(size_t i = 3; i < nd + 3u; i++) first[i] += first[i - 1];
+    for(size_t i = 0; i < ne; i++) to[first[em->edges[2*i] + 2]++] = em->edges[2*i + 1];
+    // ahora las aristas de k están en to[first[k + 1] .. first[k + 2]) (k = -1 es el script)
+    for(int k = -1; ; k = stack[--sp]){
+        for(size_t j = first[k + 1]; j < first[k + 2]; j++)
+            if(!em->called[to[j]]){ em->called[to[j]] = true; stack[sp++] = to[j]; }
+        if(sp == 0) break;
+    }
+    free(first); free(to); free(stack);
+}
+
+bool emit_c_program(const program_ast *P, size_t max_depth, FILE *out){
+    emitter_t em;
+    memset(&em, 0, sizeof(em));
+    em.P = P;
+    size_t nd = P->decls.count;
+    em.fnames = (char**)calloc(nd ? nd : 1u, sizeof(char*));
+    em.called = (bool*)calloc(nd ? nd : 1u, sizeof(bool));
+
+    // nombres C de las funciones (un nombre repetido lleva el índice)
+    for(size_t i = 0; i < nd; i++){
+        const decl *d = P->decls.items[i];
+        if(d->kind == DECL_VAR){
+            add_global(&em, d->as.var.name);
+            collect_expr(&em, d->as.var.init);
+            continue;
+        }
+        bool dup = false;
+        for(size_t j = 0; j < nd && !dup; j++){
+            const decl *o = P->decls.items[j];
+            dup = j != i && o->kind == DECL_FUNC && strcmp(o->as.func.name, d->as.func.name) == 0;
+        }
+        sbuf nm = { NULL, 0, 0 };
+        sb_name(&nm, "f_", d->as.func.name);
+        if(dup) sb_printf(&nm, "_%zu", i);
+        em.fnames[i] = nm.data;
+        collect_stmt(&em, d->as.func.body);
+    }
+
+    // funciones; las que nadie llama (p. ej. ya expandidas) no se escriben
+    sbuf *funcs = (sbuf*)calloc(nd ? nd : 1u, sizeof(sbuf));
+    for(size_t i = 0; i < nd; i++)
+        if(P->decls.items[i]->kind == DECL_FUNC) emit_function(&em, &funcs[i], i);
+
+    // script: globales en orden y la última `main`
+    sbuf script = { NULL, 0, 0 };
+    em.fn = NULL; em.cur = -1; em.scopes_count = 0; em.ntemps = 0;
+    em.b = &script; em.ind = 1;
+    int main_fn = -1;
+    for(size_t i = 0; i < nd; i++){
+        const decl *d = P->decls.items[i];
+        if(d->kind == DECL_FUNC){
+            if(strcmp(d->as.func.name, "main") == 0) main_fn = (int)i;
+            continue;
+        }
+        em.limit = i;
+        indent(&em); sb_name(&script, "g_", d->as.var.name); sb_puts(&script, " = ");
+        if(d->as.var.init) ex_box(&em, d->as.var.init); else sb_puts(&script, "cel_void()");
+        sb_puts(&script, ";\n");
+    }
+    if(main_fn >= 0){
+        note_call(&em, main_fn);
+        size_t np = P->decls.items[main_fn]->as.func.params.count;
+        sb_printf(&script, "    (void)%s(", em.fnames[main_fn]);
+        for(size_t i = 0; i < np; i++) sb_puts(&script, i ? ", cel_void()" : "cel_void()");
+        sb_puts(&script, ");\n");
+    }
+
+    mark_called(&em, nd);
+
+    // salida
+    fprintf(out, "/* Generado por celer --emit-c. Compilar con: cc -std=c99 -O2 prog.c -lm */\n");
+    fprintf(out, "#ifndef CEL_MAX_DEPTH\n#define CEL_MAX_DEPTH %zuu\n#endif\n", max_depth);
+    for(size_t i = 0; k_prelude[i]; i++) fprintf(out, "%s\n", k_prelude[i]);
+    fputc('\n', out);
+    sbuf decls = { NULL, 0, 0 };
+    // la profundidad sólo existe si hay funciones (CEL_ENTER/CEL_RETURN)
+    for(size_t i = 0; i < nd; i++)
+        if(em.called[i]){ sb_puts(&decls, "static size_t cel_depth;\n"); break; }
+    for(size_t i = 0; i < em.strs_count; i++) sb_printf(&decls, "static cel_str *cel_s%zu;\n", i);
+    for(size_t i = 0; i < em.globals_count; i++){
+        sb_puts(&decls, "static cel_v "); sb_name(&decls, "g_", em.globals[i]); sb_puts(&decls, ";\n");
+    }
+    for(size_t i = 0; i < nd; i++){
+        if(P->decls.items[i]->kind != DECL_FUNC || !em.called[i]) continue;
+        emit_signature(&em, &decls, i); sb_puts(&decls, ";\n");
+    }
+    if(decls.data) fprintf(out, "%s\n", decls.data);
+    for(size_t i = 0; i < nd; i++)
+        if(em.called[i] && funcs[i].data) fputs(funcs[i].data, out);
+    fputs("int main(void){\n", out);
+    sbuf head = { NULL, 0, 0 };
+    emit_temps(&head, em.ntemps);
+    for(size_t i = 0; i < em.strs_count; i++){
+        sb_printf(&head, "    cel_s%zu = cel_mkstr(", i);
+        sb_cstr(&head, value_str(em.strs[i]), value_strlen(em.strs[i]));
+        sb_printf(&head, ", %zu);\n", value_strlen(em.strs[i]));
+    }
+    if(head.data) fputs(head.data, out);
+    if(script.data) fputs(script.data, out);
+    fputs("    return 0;\n}\n", out);
+
+    for(size_t i = 0; i < nd; i++){ free(em.fnames[i]); free(funcs[i].data); }
+    free(em.fnames); free(em.called); free(em.edges); free(em.globals); free(em.strs); free(em.scopes);
+    free(funcs); free(script.data); free(decls.data); free(head.data);
+    fflush(out);
+    return !ferror(out);
+}
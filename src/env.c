@@ -1,10 +1,11 @@
 #include "../include/env.h"
+#include "../include/stats.h"
 #include <stdlib.h>
 #include <string.h>
 
 static char *dup_cstr(const char *s){
-    if(!s){ char *z=(char*)malloc(1); if(z) z[0]='\0'; return z; }
-    size_t n=strlen(s); char *p=(char*)malloc(n+1); if(!p) return NULL; memcpy(p,s,n+1); return p;
+    if(!s){ char *z=(char*)stats_malloc(1); if(z) z[0]='\0'; return z; }
+    size_t n=strlen(s); char *p=(char*)stats_malloc(n+1); if(!p) return NULL; memcpy(p,s,n+1); return p;
 }
 
 typedef struct builtin_entry {
@@ -17,23 +18,35 @@ typedef struct env_priv {
 } env_priv;
 
 env_t *env_new(env_t *parent){
-    env_t *e=(env_t*)calloc(1,sizeof(env_t));
+    env_t *e=(env_t*)stats_calloc(1,sizeof(env_t));
+    g_stats.frames++;
     e->parent=parent;
     return e;
 }
+env_t *env_root(env_t *e){
+    while(e && e->parent) e=e->parent;
+    return e;
+}
+static void clear_slots(env_t *e){
+    for(size_t i=0;i<e->slots_count;i++) value_free(&e->slots[i]);
+}
 static void free_vars(env_t *e){
     for(size_t i=0;i<e->vars_count;i++){
-        free(e->vars[i].name);
+        stats_free(e->vars[i].name, strlen(e->vars[i].name)+1);
         value_free(&e->vars[i].val);
     }
-    free(e->vars);
+    stats_free(e->vars, e->vars_cap*sizeof(var_entry));
 }
+static unsigned g_bind_epoch=1; // 0 = nodo nunca enlazado
+unsigned env_bind_epoch(void){ return g_bind_epoch; }
+
 static void free_funcs(env_t *e){
+    if(e->funcs_count) g_bind_epoch++;
     for(size_t i=0;i<e->funcs_count;i++){
-        free(e->funcs[i].name);
+        stats_free(e->funcs[i].name, strlen(e->funcs[i].name)+1);
         // no liberamos e->funcs[i].fn (vive en AST)
     }
-    free(e->funcs);
+    stats_free(e->funcs, e->funcs_cap*sizeof(func_entry));
 }
 void env_free(env_t *e){
     if(!e) return;
@@ -41,20 +54,78 @@ void env_free(env_t *e){
     free_funcs(e);
     // builtin table está colgando de e->funcs? No; hacemos un “priv” escondido opcional:
     // Para minimizar, no mantenemos estado extra aquí (simplificado).
-    free(e);
+    stats_free(e, sizeof(env_t));
+}
+
+// --- pila de frames: chunks enlazados que se reutilizan entre llamadas ---
+#define FRAME_CHUNK_BYTES (64u * 1024u)
+#define FRAME_ALIGN 16u
+
+typedef struct frame_chunk {
+    struct frame_chunk *prev, *next;
+    size_t cap, used;
+    unsigned char *data;
+} frame_chunk;
+static frame_chunk *g_fcur=NULL;
+
+static frame_chunk *frame_chunk_new(size_t cap){
+    frame_chunk *c=(frame_chunk*)stats_calloc(1,sizeof(frame_chunk));
+    c->data=(unsigned char*)stats_malloc(cap);
+    c->cap=cap;
+    return c;
+}
+
+env_t *env_push_frame(env_t *parent, size_t nslots){
+    size_t need=sizeof(env_t)+nslots*sizeof(value_t);
+    need=(need+FRAME_ALIGN-1u)&~(size_t)(FRAME_ALIGN-1u);
+    if(!g_fcur) g_fcur=frame_chunk_new(need>FRAME_CHUNK_BYTES?need:FRAME_CHUNK_BYTES);
+    if(g_fcur->used+need>g_fcur->cap){
+        frame_chunk *n=g_fcur->next;
+        if(!n || n->cap<need){
+            // inserta uno nuevo (suficientemente grande) tras el actual
+            frame_chunk *c=frame_chunk_new(need>FRAME_CHUNK_BYTES?need:FRAME_CHUNK_BYTES);
+            c->prev=g_fcur; c->next=n;
+            if(n) n->prev=c;
+            g_fcur->next=c;
+            n=c;
+        }
+        g_fcur=n;
+    }
+    env_t *e=(env_t*)(g_fcur->data+g_fcur->used);
+    g_fcur->used+=need;
+    memset(e,0,sizeof(*e));
+    g_stats.frames++;
+    e->parent=parent;
+    if(nslots){
+        e->slots=(value_t*)(e+1);
+        memset(e->slots,0,nslots*sizeof(value_t)); // VAL_VOID == 0
+        e->slots_count=nslots;
+    }
+    return e;
+}
+
+void env_pop_frame(env_t *e){
+    if(!e) return;
+    clear_slots(e);
+    free_vars(e);   // sólo si se definió algo por nombre (caso raro)
+    free_funcs(e);
+    // LIFO: e es siempre el último frame del chunk actual
+    g_fcur->used=(size_t)((unsigned char*)e-g_fcur->data);
+    if(g_fcur->used==0 && g_fcur->prev) g_fcur=g_fcur->prev;
 }
 
 static int find_var(env_t *e, const char *name, env_t **out_env, size_t *out_idx){
-    for(env_t *cur=e; cur; cur=cur->parent){
+    int hops=0;
+    for(env_t *cur=e; cur; cur=cur->parent, hops++){
         for(size_t i=0;i<cur->vars_count;i++){
-            if(strcmp(cur->vars[i].name, name)==0){ if(out_env) *out_env=cur; if(out_idx) *out_idx=i; return 1; }
+            if(strcmp(cur->vars[i].name, name)==0){ stats_lookup(hops); if(out_env) *out_env=cur; if(out_idx) *out_idx=i; return 1; }
         }
     }
     return 0;
 }
 bool env_define_var(env_t *e, const char *name, bool is_const, value_t v){
     // sombreado permitido
-    if(e->vars_count==e->vars_cap){ size_t nc=e->vars_cap?e->vars_cap*2u:8u; e->vars=(var_entry*)realloc(e->vars, nc*sizeof(var_entry)); e->vars_cap=nc; }
+    if(e->vars_count==e->vars_cap){ size_t nc=e->vars_cap?e->vars_cap*2u:8u; e->vars=(var_entry*)stats_realloc(e->vars, e->vars_cap*sizeof(var_entry), nc*sizeof(var_entry)); e->vars_cap=nc; }
     e->vars[e->vars_count].name=dup_cstr(name);
     e->vars[e->vars_count].is_const=is_const;
     e->vars[e->vars_count].val=value_copy(&v);
@@ -76,11 +147,19 @@ bool env_get_var(env_t *e, const char *name, value_t *out){
     return true;
 }
 
+bool env_has_var(env_t *e, const char *name, bool *is_const){
+    env_t *where=NULL; size_t idx=0;
+    if(!find_var(e,name,&where,&idx)) return false;
+    if(is_const) *is_const = where->vars[idx].is_const;
+    return true;
+}
+
 bool env_define_func(env_t *e, const char *name, func_decl *fn){
-    if(e->funcs_count==e->funcs_cap){ size_t nc=e->funcs_cap?e->funcs_cap*2u:8u; e->funcs=(func_entry*)realloc(e->funcs, nc*sizeof(func_entry)); e->funcs_cap=nc; }
+    if(e->funcs_count==e->funcs_cap){ size_t nc=e->funcs_cap?e->funcs_cap*2u:8u; e->funcs=(func_entry*)stats_realloc(e->funcs, e->funcs_cap*sizeof(func_entry), nc*sizeof(func_entry)); e->funcs_cap=nc; }
     e->funcs[e->funcs_count].name=dup_cstr(name);
     e->funcs[e->funcs_count].fn=fn;
     e->funcs_count++;
+    g_bind_epoch++;
     return true;
 }
 func_decl *env_get_func(env_t *e, const char *name){
@@ -112,10 +191,11 @@ static builtin_store *g_bstore=NULL; static size_t g_bc=0,g_bp=0;
 
 bool env_define_builtin(env_t *e, const char *name, builtin_fn fn){
     (void)e; // global estático simple
-    if(g_bc==g_bp){ size_t nc=g_bp?g_bp*2u:8u; g_bstore=(builtin_store*)realloc(g_bstore, nc*sizeof(builtin_store)); g_bp=nc; }
+    if(g_bc==g_bp){ size_t nc=g_bp?g_bp*2u:8u; g_bstore=(builtin_store*)stats_realloc(g_bstore, g_bp*sizeof(builtin_store), nc*sizeof(builtin_store)); g_bp=nc; }
     g_bstore[g_bc].name=dup_cstr(name);
     g_bstore[g_bc].fn=fn;
     g_bc++;
+    g_bind_epoch++;
     return true;
 }
 builtin_fn env_get_builtin(env_t *e, const char *name){
@@ -1,63 +1,147 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L   // getrlimit
+#endif
 #include "../include/eval.h"
+#include "../include/jit.h"
+#include "../include/profile.h"
+#include "../include/stats.h"
 #include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>   // <-- necesario para malloc/free/calloc
+#include <stdint.h>
+#include <math.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 
-// --- unescape de string literal de Celer ("...") ---
-static char *unescape_celer_string(const char *lex) {
-    // asume que lex viene como: "contenido con \n \t \\ \" "
-    if(!lex) return NULL;
-    size_t n = strlen(lex);
-    size_t start = 0, end = n;
-    if(n >= 2 && lex[0] == '\"' && lex[n-1] == '\"') { start = 1; end = n-1; }
-
-    // tamaño máximo igual al contenido (escapes reducen o igualan)
-    char *out = (char*)malloc((end - start) + 1);
-    if(!out) return NULL;
-
-    size_t oi = 0;
-    for(size_t i = start; i < end; ++i) {
-        char c = lex[i];
-        if(c == '\\' && i + 1 < end) {
-            char e = lex[i+1];
-            switch(e) {
-                case 'n':  out[oi++] = '\n'; break;
-                case 't':  out[oi++] = '\t'; break;
-                case '\\': out[oi++] = '\\'; break;
-                case '\"': out[oi++] = '\"'; break;
-                default:   out[oi++] = e;    break; // pasa tal cual el escape desconocido
-            }
-            i++; // saltar el char escapado
-        } else {
-            out[oi++] = c;
-        }
+static eval_result sig(eval_signal s){ eval_result r; r.sig=s; r.value=v_void(); return r; }
+
+static value_t eval_expr(env_t *env, expr *e, eval_result *status);
+static eval_signal eval_stmt (env_t *env, stmt *s);
+static eval_signal eval_block(env_t *env, stmt *block);
+
+static value_t call_user_function(env_t *env, func_decl *fn, int argc, value_t *argv, int line);
+static void bind_call(env_t *env, expr *e);
+
+// Pila de argumentos reutilizada entre llamadas (crece, no se encoge).
+static struct { value_t *items; size_t count, cap; } g_args;
+
+static size_t args_reserve(size_t n){
+    size_t base = g_args.count;
+    if(base + n > g_args.cap){
+        size_t nc = g_args.cap ? g_args.cap : 64u;
+        while(nc < base + n) nc *= 2u;
+        g_args.items = (value_t*)stats_realloc(g_args.items, g_args.cap * sizeof(value_t), nc * sizeof(value_t));
+        g_args.cap = nc;
     }
-    out[oi] = '\0';
-    return out;
+    g_args.count = base + n;
+    return base;
 }
 
-static eval_result ok(value_t v){ eval_result r; r.sig=SIG_NONE; r.value=v; return r; }
-static eval_result rt_err(void){ eval_result r; r.sig=SIG_RUNTIME_ERROR; r.value=v_void(); return r; }
-static eval_result sig(eval_signal s){ eval_result r; r.sig=s; r.value=v_void(); return r; }
-static eval_result sig_ret(value_t v){ eval_result r; r.sig=SIG_RETURN; r.value=v; return r; }
+// ----- pila de llamadas -----
+// Cada llamada del usuario recursa en C (call -> stmt -> block -> expr), así que
+// además del límite de profundidad se vigila cuánta pila nativa se ha usado.
+static size_t g_max_depth = CELER_MAX_DEPTH_DEFAULT;
+static size_t g_depth;
+static uintptr_t g_stack_base;
+static size_t g_stack_budget;
+
+// Llamada en posición de cola pendiente: el trampolín de call_user_function
+// la ejecuta en el mismo nivel de C. Sus args esperan en g_args desde `base`.
+static struct { func_decl *fn; size_t base; int argc; } g_tail;
+
+// Error de ejecución en curso; las sentencias lo convierten en SIG_RUNTIME_ERROR.
+static struct { bool failed; int line; const char *where; char msg[96]; } g_rt;
+static const char *g_cur_fn; // función en ejecución (NULL en el script)
+static value_t *g_ret_slot;  // slot de retorno de la llamada en curso
+
+void eval_set_max_depth(size_t n){ g_max_depth = n ? n : 1; }
+
+static void rt_fail(int line, const char *fmt, ...){
+    if(g_rt.failed) return;
+    g_rt.failed = true;
+    g_rt.line = line;
+    g_rt.where = g_cur_fn ? g_cur_fn : "<script>";
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(g_rt.msg, sizeof(g_rt.msg), fmt, ap);
+    va_end(ap);
+}
 
-static value_t eval_expr(env_t *env, expr *e, eval_result *status);
-static eval_result eval_stmt (env_t *env, stmt *s);
-static eval_result eval_block(env_t *env, stmt *block);
+// Pila nativa utilizable; se deja un margen (hasta 1 MB) para la recursión que
+// no pasa por llamadas (expresiones muy anidadas). Se puede fijar al compilar.
+static size_t native_stack_budget(void){
+#if defined(CELER_NATIVE_STACK_BUDGET)
+    return CELER_NATIVE_STACK_BUDGET;
+#elif defined(_WIN32)
+    return 768u << 10;   // 1 MB por defecto en Windows
+#else
+    struct rlimit rl;
+    if(getrlimit(RLIMIT_STACK, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY){
+        size_t lim = (size_t)rl.rlim_cur, margin = lim / 4u < (1u << 20) ? lim / 4u : (1u << 20);
+        return lim - margin;
+    }
+    return 7u << 20;
+#endif
+}
 
-static value_t call_function(env_t *env, const char *name, int argc, value_t *argv, eval_result *status);
+static bool native_stack_exhausted(void){
+    char here;
+    uintptr_t at = (uintptr_t)&here;
+    size_t used = g_stack_base > at ? (size_t)(g_stack_base - at) : (size_t)(at - g_stack_base);
+    return used > g_stack_budget;
+}
 
 // ----- builtin print -----
 static value_t builtin_print(int argc, value_t *argv){
     for(int i=0;i<argc;i++){
         char *s=value_to_cstr(&argv[i]);
-        if(s){ fputs(s, stdout); free(s); }
+        if(s){ fputs(s, stdout); stats_free(s, strlen(s)+1); }
         if(i+1<argc) fputc(' ', stdout);
     }
     fputc('\n', stdout);
     return v_void();
 }
 
+// ----- builtin stats -----
+// stats() da el resumen como string; stats("allocs") un contador (ver stats.h).
+static value_t builtin_stats(int argc, value_t *argv){
+    if(argc == 0){
+        char buf[256];
+        stats_summary(buf, sizeof(buf));
+        return v_string(buf);
+    }
+    double d;
+    if(argv[0].kind != VAL_STRING || !stats_get(value_str(&argv[0]), &d)) return v_void();
+    if(strcmp(value_str(&argv[0]), "avg_depth") == 0) return v_float(d);
+    return v_int((long long)d);
+}
+
+// ----- builtins de arrays -----
+static const char *g_builtin_err; // ver eval_builtin_error
+
+const char *eval_builtin_error(void){
+    const char *m = g_builtin_err;
+    g_builtin_err = NULL;
+    return m;
+}
+
+// len(a) elementos de un array; len(s) bytes de un string.
+static value_t builtin_len(int argc, value_t *argv){
+    if(argc == 1 && argv[0].kind == VAL_ARRAY)  return v_int((long long)argv[0].as.a->len);
+    if(argc == 1 && argv[0].kind == VAL_STRING) return v_int((long long)value_strlen(&argv[0]));
+    g_builtin_err = "len() espera un array o un string";
+    return v_void();
+}
+
+// push(a, v) agrega al final (capacidad al doble cuando se llena).
+static value_t builtin_push(int argc, value_t *argv){
+    const char *err = argc == 2 ? value_array_push(&argv[0], &argv[1]) : "push() espera un array y un valor";
+    if(err) g_builtin_err = err;
+    return v_void();
+}
+
 // ----- helpers binarios -----
 static value_t eval_binary_op(const value_t *L, op_kind op, const value_t *R){
     switch(op){
@@ -78,11 +162,200 @@ static value_t eval_binary_op(const value_t *L, op_kind op, const value_t *R){
     }
 }
 
+// cur op= v
+static value_t compound_value(op_kind op, const value_t *cur, const value_t *v){
+    switch(op){
+        case OP_PLUS_ASSIGN:    return value_add(cur, v);
+        case OP_MINUS_ASSIGN:   return value_sub(cur, v);
+        case OP_STAR_ASSIGN:    return value_mul(cur, v);
+        case OP_SLASH_ASSIGN:   return value_div(cur, v);
+        case OP_PERCENT_ASSIGN: return value_mod(cur, v);
+        default:                return value_copy(v);
+    }
+}
+
+// ----- kernels monomórficos -----
+// El checker (typecheck.h) garantiza el tipo de ambos operandos, así que no se
+// mira value_kind. Replican exactamente la semántica de value.c.
+static value_t int_binary(op_kind op, long long a, long long b){
+    switch(op){
+        case OP_ADD: case OP_PLUS_ASSIGN:    return v_int(a + b);
+        case OP_SUB: case OP_MINUS_ASSIGN:   return v_int(a - b);
+        case OP_MUL: case OP_STAR_ASSIGN:    return v_int(a * b);
+        case OP_DIV: case OP_SLASH_ASSIGN:   return v_int(b == 0 ? 0 : a / b);
+        case OP_MOD: case OP_PERCENT_ASSIGN: return v_int(b == 0 ? 0 : a % b);
+        case OP_EQ:  return v_bool(a == b);
+        case OP_NEQ: return v_bool(a != b);
+        case OP_LT:  return v_bool(a <  b);
+        case OP_LTE: return v_bool(a <= b);
+        case OP_GT:  return v_bool(a >  b);
+        case OP_GTE: return v_bool(a >= b);
+        default:     return v_void();
+    }
+}
+static value_t float_binary(op_kind op, double a, double b){
+    switch(op){
+        case OP_ADD: case OP_PLUS_ASSIGN:  return v_float(a + b);
+        case OP_SUB: case OP_MINUS_ASSIGN: return v_float(a - b);
+        case OP_MUL: case OP_STAR_ASSIGN:  return v_float(a * b);
+        case OP_DIV: case OP_SLASH_ASSIGN: return v_float(a / b);
+        case OP_EQ:  return v_bool(fabs(a - b) < 1e-12);
+        case OP_NEQ: return v_bool(!(fabs(a - b) < 1e-12));
+        case OP_LT:  return v_bool(a < b);
+        case OP_LTE: return v_bool(a < b || fabs(a - b) < 1e-12);
+        case OP_GT:  return v_bool(!(a < b || fabs(a - b) < 1e-12));
+        case OP_GTE: return v_bool(!(a < b));
+        default:     return v_void();
+    }
+}
+static bool has_float_kernel(op_kind op){
+    return op != OP_MOD && op != OP_PERCENT_ASSIGN;
+}
+
 // ----- expresiones -----
+// Evalúa los args de una llamada (o los elementos de un literal de array) en
+// la pila compartida; devuelve su base. Se indexa por base porque una llamada
+// anidada puede reubicar la pila.
+static size_t eval_args(env_t *env, const expr_vec *args, eval_result *status){
+    size_t argc = args->count;
+    size_t base = args_reserve(argc);
+    for(size_t i=0;i<argc;i++){
+        value_t v = eval_expr(env, args->items[i], status);
+        g_args.items[base + i] = v;
+    }
+    return base;
+}
+
+// Comparaciones como bool de C (misma semántica que value.c).
+static bool int_cmp(op_kind op, long long a, long long b, bool *out){
+    switch(op){
+        case OP_EQ:  *out = a == b; return true;
+        case OP_NEQ: *out = a != b; return true;
+        case OP_LT:  *out = a <  b; return true;
+        case OP_LTE: *out = a <= b; return true;
+        case OP_GT:  *out = a >  b; return true;
+        case OP_GTE: *out = a >= b; return true;
+        default:     return false;
+    }
+}
+static bool float_cmp(op_kind op, double a, double b, bool *out){
+    bool eq = fabs(a - b) < 1e-12;
+    switch(op){
+        case OP_EQ:  *out = eq; return true;
+        case OP_NEQ: *out = !eq; return true;
+        case OP_LT:  *out = a < b; return true;
+        case OP_LTE: *out = a < b || eq; return true;
+        case OP_GT:  *out = !(a < b || eq); return true;
+        case OP_GTE: *out = !(a < b); return true;
+        default:     return false;
+    }
+}
+
+// Condición como bool de C. && / || / ! se resuelven en cortocircuito y las
+// comparaciones con tipo conocido y los locales bool se leen sin crear un
+// value_t bool; el resto pasa por value_truthy.
+static bool eval_cond(env_t *env, expr *e){
+    switch(e->kind){
+        case EXPR_GROUPING: return eval_cond(env, e->as.grouping.inner);
+        case EXPR_BOOL_LIT: return e->as.bool_lit.value;
+        case EXPR_IDENT:
+            if(e->type == TYPE_BOOL && e->as.ident.depth >= 0)
+                return env_slot(env, e->as.ident.depth, e->as.ident.slot)->as.b;
+            break;
+        case EXPR_UNARY:
+            if(e->as.unary.op == OP_NOT) return !eval_cond(env, e->as.unary.right);
+            break;
+        case EXPR_BINARY: {
+            op_kind op = e->as.binary.op;
+            if(op == OP_AND) return eval_cond(env, e->as.binary.left) && eval_cond(env, e->as.binary.right);
+            if(op == OP_OR)  return eval_cond(env, e->as.binary.left) || eval_cond(env, e->as.binary.right);
+            type_kind lt = e->as.binary.left->type;
+            if(lt != e->as.binary.right->type || (lt != TYPE_INT && lt != TYPE_FLOAT)) break;
+            value_t L = eval_expr(env, e->as.binary.left, NULL);
+            value_t R = eval_expr(env, e->as.binary.right, NULL);
+            bool out = false;
+            if(lt == TYPE_INT ? int_cmp(op, L.as.i, R.as.i, &out) : float_cmp(op, L.as.f, R.as.f, &out)) return out;
+            // aritmética usada como condición (`if (n % 2)`)
+            value_t O = lt == TYPE_INT ? int_binary(op, L.as.i, R.as.i) : float_binary(op, L.as.f, R.as.f);
+            return value_truthy(&O);
+        }
+        default: break;
+    }
+    value_t v = eval_expr(env, e, NULL);
+    bool b = value_truthy(&v);
+    value_free(&v);
+    return b;
+}
+
+// Los casos poco frecuentes van fuera de línea para no agrandar el frame de
+// eval_expr, que pagan todas las expresiones.
+#if defined(__GNUC__)
+#define EVAL_NOINLINE __attribute__((noinline))
+#else
+#define EVAL_NOINLINE
+#endif
+
+// Llama al builtin con los args de la pila y libera los args; sus errores
+// (g_builtin_err) pasan a ser errores de ejecución en la línea de la llamada.
+static EVAL_NOINLINE value_t call_builtin(expr *e, int argc, size_t base){
+    value_t ret = e->as.call.bind.builtin(argc, g_args.items + base);
+    for(int i=0;i<argc;i++) value_free(&g_args.items[base + (size_t)i]);
+    if(g_builtin_err) rt_fail(e->line, "%s", eval_builtin_error());
+    return ret;
+}
+
+// Literales, lecturas y escrituras de arrays.
+static EVAL_NOINLINE value_t eval_array_expr(env_t *env, expr *e, eval_result *status){
+    value_t out = v_void();
+    const char *err = NULL;
+    switch(e->kind){
+        case EXPR_ARRAY: {
+            // los elementos se evalúan en la pila de args y se copian sin caja
+            size_t n = e->as.array.items.count;
+            size_t base = eval_args(env, &e->as.array.items, status);
+            if(!g_rt.failed) err = value_array_from(type_elem_value(e->type), g_args.items + base, n, &out);
+            for(size_t i=0;i<n;i++) value_free(&g_args.items[base + i]);
+            g_args.count = base;
+            break;
+        }
+        case EXPR_INDEX: {
+            value_t A = eval_expr(env, e->as.index.target, status);
+            value_t I = eval_expr(env, e->as.index.index, status);
+            if(!g_rt.failed) err = value_index(&A, &I, &out); // escalar: no hace falta liberarlo
+            value_free(&A); value_free(&I);
+            break;
+        }
+        case EXPR_INDEX_ASSIGN: {
+            value_t A = eval_expr(env, e->as.index_assign.target, status);
+            value_t I = eval_expr(env, e->as.index_assign.index, status);
+            value_t V = eval_expr(env, e->as.index_assign.value, status);
+            if(!g_rt.failed){
+                if(e->as.index_assign.op == OP_ASSIGN){
+                    err = value_index_set(&A, &I, &V, &out);
+                } else {
+                    value_t cur;
+                    err = value_index(&A, &I, &cur);
+                    if(!err){
+                        value_t nv = compound_value(e->as.index_assign.op, &cur, &V);
+                        err = value_index_set(&A, &I, &nv, &out);
+                    }
+                }
+            }
+            value_free(&A); value_free(&I); value_free(&V);
+            break;
+        }
+        default: break;
+    }
+    if(err) rt_fail(e->line, "%s", err);
+    return out;
+}
+
 static value_t eval_expr(env_t *env, expr *e, eval_result *status){
     (void)status;
     switch(e->kind){
         case EXPR_IDENT: {
+            if(e->as.ident.depth >= 0)
+                return value_copy(env_slot(env, e->as.ident.depth, e->as.ident.slot));
             value_t v;
             if(!env_get_var(env, e->as.ident.name, &v)) return v_void();
             return v;
@@ -90,18 +363,19 @@ static value_t eval_expr(env_t *env, expr *e, eval_result *status){
         case EXPR_INT_LIT:   return v_int(e->as.int_lit.value);
         case EXPR_FLOAT_LIT: return v_float(e->as.float_lit.value);
         case EXPR_BOOL_LIT:  return v_bool(e->as.bool_lit.value);
-        case EXPR_STRING_LIT: {
-            char *s = unescape_celer_string(e->as.string_lit.text);
-            value_t v = v_string(s ? s : "");
-            free(s);
-            return v;
-        }
+        case EXPR_STRING_LIT: return value_copy(&e->as.string_lit.value);
 
         case EXPR_GROUPING:
             return eval_expr(env, e->as.grouping.inner, status);
 
         case EXPR_UNARY: {
             value_t R = eval_expr(env, e->as.unary.right, status);
+            switch(e->as.unary.right->type){
+                case TYPE_INT:   if(e->as.unary.op == OP_SUB) return v_int(0 - R.as.i); break;
+                case TYPE_FLOAT: if(e->as.unary.op == OP_SUB) return v_float(0.0 - R.as.f); break;
+                case TYPE_BOOL:  if(e->as.unary.op == OP_NOT) return v_bool(!R.as.b); break;
+                default: break;
+            }
             value_t out = v_void();
             if(e->as.unary.op == OP_NOT){
                 out = value_not(&R);
@@ -115,15 +389,52 @@ static value_t eval_expr(env_t *env, expr *e, eval_result *status){
         }
 
         case EXPR_BINARY: {
+            if(e->as.binary.op == OP_AND || e->as.binary.op == OP_OR) return v_bool(eval_cond(env, e));
             value_t L = eval_expr(env, e->as.binary.left, status);
             value_t R = eval_expr(env, e->as.binary.right, status);
-            value_t O = eval_binary_op(&L, e->as.binary.op, &R);
+            op_kind op = e->as.binary.op;
+            type_kind lt = e->as.binary.left->type, rt = e->as.binary.right->type;
+            if(lt == rt){
+                switch(lt){
+                    case TYPE_INT: return int_binary(op, L.as.i, R.as.i);
+                    case TYPE_FLOAT: if(has_float_kernel(op)) return float_binary(op, L.as.f, R.as.f); break;
+                    case TYPE_BOOL:
+                        if(op == OP_EQ)  return v_bool(L.as.b == R.as.b);
+                        if(op == OP_NEQ) return v_bool(L.as.b != R.as.b);
+                        break;
+                    default: break;
+                }
+            }
+            value_t O = eval_binary_op(&L, op, &R);
             value_free(&L); value_free(&R);
             return O;
         }
 
         case EXPR_ASSIGN: {
             value_t V = eval_expr(env, e->as.assign.value, status);
+            if(e->as.assign.depth >= 0){
+                value_t *slot = env_slot(env, e->as.assign.depth, e->as.assign.slot);
+                // x op= v con x y v del mismo tipo numérico: se opera en el slot
+                if(e->as.assign.op != OP_ASSIGN && e->type == e->as.assign.value->type){
+                    if(e->type == TYPE_INT){ *slot = int_binary(e->as.assign.op, slot->as.i, V.as.i); return *slot; }
+                    if(e->type == TYPE_FLOAT && has_float_kernel(e->as.assign.op)){
+                        *slot = float_binary(e->as.assign.op, slot->as.f, V.as.f); return *slot;
+                    }
+                }
+                value_t tmp = V; // OP_ASSIGN: V pasa al slot
+                switch(e->as.assign.op){
+                    case OP_PLUS_ASSIGN:    tmp = value_add(slot, &V); break;
+                    case OP_MINUS_ASSIGN:   tmp = value_sub(slot, &V); break;
+                    case OP_STAR_ASSIGN:    tmp = value_mul(slot, &V); break;
+                    case OP_SLASH_ASSIGN:   tmp = value_div(slot, &V); break;
+                    case OP_PERCENT_ASSIGN: tmp = value_mod(slot, &V); break;
+                    default: break;
+                }
+                if(e->as.assign.op != OP_ASSIGN) value_free(&V);
+                value_free(slot);
+                *slot = tmp;
+                return value_copy(slot);
+            }
             if(e->as.assign.op == OP_ASSIGN){
                 if(!env_set_var(env, e->as.assign.name, V)){
                     // si no existe, define mutable por defecto
@@ -150,137 +461,222 @@ static value_t eval_expr(env_t *env, expr *e, eval_result *status){
         }
 
         case EXPR_TERNARY: {
-            value_t C = eval_expr(env, e->as.ternary.cond, status);
-            value_t Cb = value_to_bool(&C);
-            bool takeTrue = Cb.as.b;
-            value_free(&C); value_free(&Cb);
+            bool takeTrue = eval_cond(env, e->as.ternary.cond);
             value_t out = takeTrue ? eval_expr(env, e->as.ternary.when_true, status)
                                    : eval_expr(env, e->as.ternary.when_false, status);
             return out;
         }
 
         case EXPR_CALL: {
-            if(e->as.call.callee->kind != EXPR_IDENT) return v_void();
-            const char *fname = e->as.call.callee->as.ident.name;
+            if(e->as.call.callee->kind != EXPR_IDENT || g_rt.failed) return v_void();
+            if(e->as.call.bind.epoch != env_bind_epoch()) bind_call(env, e);
             int argc = (int)e->as.call.args.count;
-            value_t *argv = (value_t*)calloc((size_t)argc, sizeof(value_t));
-            for(int i=0;i<argc;i++) argv[i] = eval_expr(env, e->as.call.args.items[i], status);
-            value_t ret = call_function(env, fname, argc, argv, status);
-            for(int i=0;i<argc;i++) value_free(&argv[i]);
-            free(argv);
+            size_t base = eval_args(env, &e->as.call.args, status);
+            value_t ret;
+            if(g_rt.failed){
+                for(int i=0;i<argc;i++) value_free(&g_args.items[base + (size_t)i]);
+                ret = v_void();
+            } else if(e->as.call.bind.builtin){
+                ret = call_builtin(e, argc, base);
+            } else if(e->as.call.bind.fn){
+                ret = call_user_function(env, e->as.call.bind.fn, argc, g_args.items + base, e->line);
+            } else {
+                for(int i=0;i<argc;i++) value_free(&g_args.items[base + (size_t)i]);
+                ret = v_void();
+            }
+            g_args.count = base;
             return ret;
         }
+
+        case EXPR_ARRAY: case EXPR_INDEX: case EXPR_INDEX_ASSIGN:
+            return eval_array_expr(env, e, status);
     }
     return v_void();
 }
 
 // ----- sentencias -----
-static eval_result eval_stmt(env_t *env, stmt *s){
+// Las sentencias sólo devuelven la señal de control; el valor de `return` se
+// escribe directamente en el slot de retorno de la llamada en curso.
+
+// punto de control del muestreo (--sample): tras el trabajo de `line`
+#define SAMPLE_POINT(line) do { if(g_prof_sample) prof_sample_hit(line); } while(0)
+
+static eval_signal eval_stmt(env_t *env, stmt *s){
     switch(s->kind){
         case STMT_EXPR: {
             value_t v = eval_expr(env, s->as.expr_stmt.value, NULL);
             value_free(&v);
-            return ok(v_void());
+            SAMPLE_POINT(s->line);
+            return g_rt.failed ? SIG_RUNTIME_ERROR : SIG_NONE;
         }
         case STMT_RETURN: {
-            value_t v = s->as.ret.value ? eval_expr(env, s->as.ret.value, NULL) : v_void();
-            return sig_ret(v);
+            expr *e = s->as.ret.value;
+            // return f(...) con f del usuario: la llamada la hace el trampolín
+            // de call_user_function en lugar de anidar otro nivel de C
+            if(e && e->kind == EXPR_CALL && e->as.call.callee->kind == EXPR_IDENT){
+                if(e->as.call.bind.epoch != env_bind_epoch()) bind_call(env, e);
+                if(e->as.call.bind.fn){
+                    // los args pueden hacer su propia llamada de cola y pisar
+                    // g_tail: se llena recién después de evaluarlos
+                    size_t base = eval_args(env, &e->as.call.args, NULL);
+                    g_tail.fn = e->as.call.bind.fn;
+                    g_tail.argc = (int)e->as.call.args.count;
+                    g_tail.base = base;
+                    SAMPLE_POINT(s->line);
+                    if(!g_rt.failed) return SIG_TAILCALL;
+                    for(int i=0;i<g_tail.argc;i++) value_free(&g_args.items[g_tail.base + (size_t)i]);
+                    g_args.count = g_tail.base;
+                    return SIG_RUNTIME_ERROR;
+                }
+            }
+            if(!e) return SIG_RETURN; // el slot ya vale void
+            value_t v = eval_expr(env, e, NULL);
+            SAMPLE_POINT(s->line);
+            if(g_rt.failed){ value_free(&v); return SIG_RUNTIME_ERROR; }
+            *g_ret_slot = v;
+            return SIG_RETURN;
         }
-        case STMT_BREAK: return sig(SIG_BREAK);
-        case STMT_CONTINUE: return sig(SIG_CONTINUE);
+        case STMT_BREAK: return SIG_BREAK;
+        case STMT_CONTINUE: return SIG_CONTINUE;
         case STMT_BLOCK: return eval_block(env, s);
         case STMT_IF: {
-            value_t c = eval_expr(env, s->as.if_stmt.cond, NULL);
-            value_t cb = value_to_bool(&c); bool take = cb.as.b; value_free(&c); value_free(&cb);
+            bool take = eval_cond(env, s->as.if_stmt.cond);
+            SAMPLE_POINT(s->line);
+            if(g_rt.failed) return SIG_RUNTIME_ERROR;
             if(take) return eval_stmt(env, s->as.if_stmt.then_branch);
             if(s->as.if_stmt.else_branch) return eval_stmt(env, s->as.if_stmt.else_branch);
-            return ok(v_void());
+            return SIG_NONE;
         }
         case STMT_FOR_WHILELIKE: {
             for(;;){
-                value_t c = eval_expr(env, s->as.for_while.cond, NULL);
-                value_t cb = value_to_bool(&c); bool cont = cb.as.b; value_free(&c); value_free(&cb);
+                bool cont = eval_cond(env, s->as.for_while.cond);
+                SAMPLE_POINT(s->line);
+                if(g_rt.failed) return SIG_RUNTIME_ERROR;
                 if(!cont) break;
-                eval_result r = eval_stmt(env, s->as.for_while.body);
-                if(r.sig==SIG_BREAK) { value_free(&r.value); break; }
-                if(r.sig==SIG_RETURN || r.sig==SIG_RUNTIME_ERROR) return r;
-                // SIG_CONTINUE cae aquí
+                eval_signal r = eval_stmt(env, s->as.for_while.body);
+                if(r==SIG_BREAK) break;
+                if(r!=SIG_NONE && r!=SIG_CONTINUE) return r;
             }
-            return ok(v_void());
+            return SIG_NONE;
         }
         case STMT_FOR_CLIKE: {
             if(s->as.for_clike.init){
-                eval_result r = eval_stmt(env, s->as.for_clike.init);
-                if(r.sig!=SIG_NONE) return r;
+                eval_signal r = eval_stmt(env, s->as.for_clike.init);
+                if(r!=SIG_NONE) return r;
             }
             for(;;){
                 if(s->as.for_clike.cond){
-                    value_t c = eval_expr(env, s->as.for_clike.cond, NULL);
-                    value_t cb = value_to_bool(&c); bool cont = cb.as.b; value_free(&c); value_free(&cb);
+                    bool cont = eval_cond(env, s->as.for_clike.cond);
+                    SAMPLE_POINT(s->line);
+                    if(g_rt.failed) return SIG_RUNTIME_ERROR;
                     if(!cont) break;
                 }
-                eval_result rbody = eval_stmt(env, s->as.for_clike.body);
-                if(rbody.sig==SIG_BREAK) { value_free(&rbody.value); break; }
-                if(rbody.sig==SIG_RETURN || rbody.sig==SIG_RUNTIME_ERROR) return rbody;
+                eval_signal r = eval_stmt(env, s->as.for_clike.body);
+                if(r==SIG_BREAK) break;
+                if(r!=SIG_NONE && r!=SIG_CONTINUE) return r;
                 if(s->as.for_clike.post){
                     value_t v = eval_expr(env, s->as.for_clike.post, NULL);
                     value_free(&v);
+                    if(g_rt.failed) return SIG_RUNTIME_ERROR;
                 }
             }
-            return ok(v_void());
+            return SIG_NONE;
         }
     }
-    return rt_err();
+    return SIG_RUNTIME_ERROR;
 }
 
-static eval_result eval_block(env_t *env, stmt *block){
-    env_t *local = env_new(env); // nuevo scope
-    for(size_t i=0;i<block->as.block.stmts.count;i++){
-        eval_result r = eval_stmt(local, block->as.block.stmts.items[i]);
-        if(r.sig!=SIG_NONE){ env_free(local); return r; }
+static eval_signal eval_block(env_t *env, stmt *block){
+    env_t *local = env_push_frame(env, (size_t)block->as.block.nslots); // nuevo scope
+    eval_signal r = SIG_NONE;
+    for(size_t i=0;i<block->as.block.stmts.count && r==SIG_NONE;i++){
+        r = eval_stmt(local, block->as.block.stmts.items[i]);
     }
-    env_free(local);
-    return ok(v_void());
+    env_pop_frame(local);
+    return r;
 }
 
 // ----- funciones -----
-static value_t call_user_function(env_t *env, func_decl *fn, int argc, value_t *argv, eval_result *status){
-    (void)status; // no lo usamos por ahora
-    env_t *local = env_new(env);
-
-    size_t pc = fn->params.count;
-    for(size_t i=0;i<pc;i++){
-        const char *pname = fn->params.items[i].name;
-        value_t arg = (i<(size_t)argc) ? argv[i] : v_void();
-        env_define_var(local, pname, false, arg);
+// Toma posesión de argv[0..argc): los args pasan a los slots sin copiarse.
+// `line` es la del sitio de llamada (para el error de desbordamiento).
+static value_t call_user_function(env_t *env, func_decl *fn, int argc, value_t *argv, int line){
+    if(g_depth >= g_max_depth || native_stack_exhausted()){
+        for(int i=0;i<argc;i++) value_free(&argv[i]);
+        rt_fail(line, g_depth >= g_max_depth ? "desbordamiento de la pila de llamadas (profundidad %zu)"
+                                             : "pila nativa agotada (profundidad %zu; ver --max-depth)", g_depth);
+        return v_void();
     }
-
-    eval_result r = eval_stmt(local, fn->body);
-    env_free(local);
-
-    if(r.sig==SIG_RETURN){
-        return r.value; // ownership al caller
+    // alcance léxico: el frame de parámetros cuelga del global, no del llamador
+    env_t *root = env_root(env);
+    const char *caller = g_cur_fn;
+    value_t *caller_ret = g_ret_slot;
+    value_t ret = v_void();
+    g_ret_slot = &ret;
+    g_depth++;
+    if(g_prof_enabled) prof_enter(fn);
+    for(;;){
+        size_t pc = fn->params.count;
+        if(jit_call(fn, argv, argc, g_depth - 1, g_max_depth, &ret)){
+            for(int i=0;i<argc;i++) value_free(&argv[i]);
+            break;
+        }
+        env_t *local = env_push_frame(root, pc);
+        for(size_t i=0;i<(size_t)argc;i++){
+            if(i < pc) local->slots[i] = argv[i];
+            else value_free(&argv[i]);
+        }
+        g_cur_fn = fn->name;
+        eval_signal r = eval_stmt(local, fn->body);
+        env_pop_frame(local);
+        if(r != SIG_TAILCALL) break;
+        // llamada de cola: mismo nivel, el frame nuevo reemplaza al anterior
+        fn = g_tail.fn;
+        if(g_prof_enabled) prof_tail(fn);
+        argc = g_tail.argc;
+        argv = g_args.items + g_tail.base;
+        g_args.count = g_tail.base; // los args se mueven antes de cualquier reserva
     }
-    value_free(&r.value);
-    return v_void();
+    if(g_prof_enabled) prof_leave();
+    g_depth--;
+    g_cur_fn = caller;
+    g_ret_slot = caller_ret;
+    return ret; // void salvo que un return lo haya escrito
 }
 
-static value_t call_function(env_t *env, const char *name, int argc, value_t *argv, eval_result *status){
-    (void)status;
-    // builtin?
-    builtin_fn b = env_get_builtin(env, name);
-    if(b) return b(argc, argv);
-    // user?
-    func_decl *fn = env_get_func(env, name);
-    if(!fn) return v_void();
-    return call_user_function(env, fn, argc, argv, status);
+// Resuelve el destino de la llamada una sola vez por época (ver env_bind_epoch).
+// Los builtins tienen prioridad sobre las funciones del usuario.
+static void bind_call(env_t *env, expr *e){
+    const char *name = e->as.call.callee->as.ident.name;
+    e->as.call.bind.builtin = env_get_builtin(env, name);
+    e->as.call.bind.fn = e->as.call.bind.builtin ? NULL : env_get_func(env, name);
+    e->as.call.bind.epoch = env_bind_epoch();
 }
 
 // ----- programa -----
 
+void eval_register_builtins(env_t *global){
+    if(!env_get_builtin(global, "print")) env_define_builtin(global, "print", builtin_print);
+    if(!env_get_builtin(global, "stats")) env_define_builtin(global, "stats", builtin_stats);
+    if(!env_get_builtin(global, "len"))   env_define_builtin(global, "len", builtin_len);
+    if(!env_get_builtin(global, "push"))  env_define_builtin(global, "push", builtin_push);
+}
+
+// Reporta el error de ejecución pendiente (si lo hay) y lo limpia.
+static bool report_rt_error(void){
+    if(!g_rt.failed) return false;
+    fprintf(stderr, "Error de ejecución @%d en %s: %s\n", g_rt.line, g_rt.where, g_rt.msg);
+    g_rt.failed = false;
+    return true;
+}
+
 eval_result eval_program(env_t *global, const program_ast *P){
-    // define builtins (idempotente simple)
-    env_define_builtin(global, "print", builtin_print);
+    // define builtins (idempotente)
+    eval_register_builtins(global);
+    char base_marker;
+    g_stack_base = (uintptr_t)&base_marker;
+    if(!g_stack_budget) g_stack_budget = native_stack_budget();
+    g_depth = 0;
+    g_cur_fn = NULL;
 
     // Cargar vars y funcs globales (top-level)
     func_decl *main_local = NULL; // <-- main de ESTE chunk
@@ -290,6 +686,7 @@ eval_result eval_program(env_t *global, const program_ast *P){
             value_t v = d->as.var.init ? eval_expr(global, d->as.var.init, NULL) : v_void();
             env_define_var(global, d->as.var.name, d->as.var.is_const, v);
             value_free(&v);
+            if(report_rt_error()) return sig(SIG_RUNTIME_ERROR);
         } else if(d->kind==DECL_FUNC){
             env_define_func(global, d->as.func.name, &d->as.func);
             if(strcmp(d->as.func.name, "main") == 0) {
@@ -300,11 +697,12 @@ eval_result eval_program(env_t *global, const program_ast *P){
 
     // Ejecutar la main del chunk si existe
     if(main_local){
-        value_t r = call_user_function(global, main_local, 0, NULL, NULL);
+        value_t r = call_user_function(global, main_local, 0, NULL, main_local->line);
         value_free(&r);
+        if(report_rt_error()) return sig(SIG_RUNTIME_ERROR);
     }
 
-    return ok(v_void());
+    return sig(SIG_NONE);
 }
 
 /*eval_result eval_program(env_t *global, const program_ast *P){
@@ -0,0 +1,768 @@
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE           // MAP_ANONYMOUS
+#endif
+#include "../include/jit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(__linux__) && !defined(CELER_NO_JIT)
+#define CELER_JIT_X64 1
+#include <sys/mman.h>
+#endif
+
+#ifdef CELER_JIT_X64
+
+#define JIT_MAX_ARGS 8
+#define JIT_STACK_BYTES (128u * 1024u) // pila nativa que puede usar una llamada
+
+// Estado que el código nativo lee a través de rbx (los offsets están en el código).
+typedef struct {
+    uint64_t depth;       // +0
+    uint64_t max_depth;   // +8
+    uintptr_t floor;      // +16 rsp mínimo
+    uint8_t bail;         // +24 abandonar y repetir en el intérprete
+} jit_rt;
+
+// JIT_BAILED: tiene código, pero ya abandonó una vez; el intérprete no vuelve a
+// entrar (en una recursión profunda cada nivel repetiría el trabajo de abajo).
+// El código sigue mapeado porque otras funciones nativas pueden llamarlo.
+typedef enum { JIT_NEW, JIT_BUSY, JIT_READY, JIT_FAILED, JIT_BAILED } jit_state;
+
+struct jit_fn {
+    func_decl *fn;
+    jit_state state;
+    void *code;                                   // cuerpo (convención interna)
+    int64_t (*entry)(const int64_t *args, jit_rt *rt); // stub con ABI de C
+    void *mem; size_t mem_len;
+    struct jit_fn *next;
+};
+
+static struct {
+    bool enabled, log;
+    env_t *global;
+    struct jit_fn *all;
+} g_jit;
+
+// ---------------- emisión ----------------
+typedef struct { uint8_t *code; size_t count, cap; } jit_buf;
+typedef struct { size_t *items; size_t count, cap; } jit_patches; // posiciones de rel32
+
+typedef struct {
+    jit_patches breaks, conts;
+} jit_loop;
+
+typedef struct jit_group jit_group;
+
+typedef struct {
+    jit_buf b;
+    struct jit_fn *self;
+    jit_group *group;
+    int bases[64], counts[64]; int nscopes; // slots planos por scope
+    int max_slots;
+    size_t frame_patch;      // imm32 de `sub rsp`
+    size_t body_start;       // destino de las llamadas de cola a sí misma
+    jit_patches to_epilogue, to_bail;
+    jit_loop *loops; size_t loops_count, loops_cap;
+    bool ok;
+} jit_cg;
+
+struct jit_group {
+    struct jit_fn **items; size_t count, cap; // funciones en compilación
+};
+
+static void emit(jit_cg *c, const uint8_t *bytes, size_t n){
+    if(c->b.count + n > c->b.cap){
+        size_t nc = c->b.cap ? c->b.cap : 256u;
+        while(nc < c->b.count + n) nc *= 2u;
+        c->b.code = (uint8_t*)realloc(c->b.code, nc);
+        c->b.cap = nc;
+    }
+    memcpy(c->b.code + c->b.count, bytes, n);
+    c->b.count += n;
+}
+#define EMIT(c, ...) do{ static const uint8_t bytes_[] = { __VA_ARGS__ }; emit((c), bytes_, sizeof(bytes_)); }while(0)
+
+static void emit_u32(jit_cg *c, uint32_t v){
+    uint8_t b[4] = { (uint8_t)v, (uint8_t)(v>>8), (uint8_t)(v>>16), (uint8_t)(v>>24) };
+    emit(c, b, 4);
+}
+static void emit_u64(jit_cg *c, uint64_t v){
+    emit_u32(c, (uint32_t)v); emit_u32(c, (uint32_t)(v >> 32));
+}
+static void put_u32(jit_cg *c, size_t at, uint32_t v){
+    c->b.code[at] = (uint8_t)v; c->b.code[at+1] = (uint8_t)(v>>8);
+    c->b.code[at+2] = (uint8_t)(v>>16); c->b.code[at+3] = (uint8_t)(v>>24);
+}
+
+static void patches_push(jit_patches *p, size_t at){
+    if(p->count == p->cap){
+        size_t nc = p->cap ? p->cap*2u : 8u;
+        p->items = (size_t*)realloc(p->items, nc*sizeof(size_t)); p->cap = nc;
+    }
+    p->items[p->count++] = at;
+}
+// rel32 en `at` -> posición actual
+static void patch_here(jit_cg *c, size_t at){ put_u32(c, at, (uint32_t)(int32_t)(c->b.count - (at + 4))); }
+static void patch_all_here(jit_cg *c, jit_patches *p){
+    for(size_t i=0;i<p->count;i++) patch_here(c, p->items[i]);
+    p->count = 0;
+}
+
+// jmp/jcc hacia adelante; devuelve la posición del rel32
+static size_t jmp_fwd(jit_cg *c){ EMIT(c, 0xe9); size_t at = c->b.count; emit_u32(c, 0); return at; }
+static size_t jcc_fwd(jit_cg *c, uint8_t cc){
+    uint8_t op[2] = { 0x0f, (uint8_t)(0x80 | cc) };
+    emit(c, op, 2);
+    size_t at = c->b.count; emit_u32(c, 0); return at;
+}
+static void jmp_back(jit_cg *c, size_t target){
+    EMIT(c, 0xe9); emit_u32(c, (uint32_t)(int32_t)(target - (c->b.count + 4)));
+}
+
+// códigos de condición x86 (el bit bajo los niega)
+enum { CC_E = 0x4, CC_NE = 0x5, CC_L = 0xc, CC_GE = 0xd, CC_LE = 0xe, CC_G = 0xf };
+
+static int32_t slot_disp(int s){ return -8 * (s + 1); }
+
+static void load_slot(jit_cg *c, int s){   // mov rax, [rbp+d]
+    EMIT(c, 0x48, 0x8b, 0x85); emit_u32(c, (uint32_t)slot_disp(s));
+}
+static void load_slot_rcx(jit_cg *c, int s){ // mov rcx, [rbp+d]
+    EMIT(c, 0x48, 0x8b, 0x8d); emit_u32(c, (uint32_t)slot_disp(s));
+}
+static void store_slot(jit_cg *c, int s){  // mov [rbp+d], rax
+    EMIT(c, 0x48, 0x89, 0x85); emit_u32(c, (uint32_t)slot_disp(s));
+}
+static void load_imm(jit_cg *c, bool rcx, uint64_t v){
+    if((int64_t)v >= INT32_MIN && (int64_t)v <= INT32_MAX){
+        if(rcx) EMIT(c, 0x48, 0xc7, 0xc1); else EMIT(c, 0x48, 0xc7, 0xc0); // mov r, simm32
+        emit_u32(c, (uint32_t)v);
+    } else {
+        if(rcx) EMIT(c, 0x48, 0xb9); else EMIT(c, 0x48, 0xb8);             // mov r, imm64
+        emit_u64(c, v);
+    }
+}
+static void setcc_rax(jit_cg *c, uint8_t cc){ // setcc al; movzx eax, al
+    uint8_t op[6] = { 0x0f, (uint8_t)(0x90 | cc), 0xc0, 0x0f, 0xb6, 0xc0 };
+    emit(c, op, 6);
+}
+
+static uint64_t float_bits(double d){ uint64_t u; memcpy(&u, &d, sizeof(u)); return u; }
+
+// ---------------- verificación de tipos ----------------
+static bool scalar(type_kind t){ return t == TYPE_INT || t == TYPE_BOOL || t == TYPE_FLOAT; }
+
+static int flat_slot(jit_cg *c, int depth, int slot){
+    if(depth < 0 || depth >= c->nscopes){ c->ok = false; return 0; }
+    int s = c->bases[c->nscopes - 1 - depth] + slot;
+    if(s + 1 > c->max_slots) c->max_slots = s + 1;
+    return s;
+}
+
+static const expr *strip(const expr *e){
+    while(e && e->kind == EXPR_GROUPING) e = e->as.grouping.inner;
+    return e;
+}
+
+static struct jit_fn *jit_get(func_decl *fn);
+static bool compile_fn(struct jit_fn *j, jit_group *g);
+
+// ---------------- expresiones ----------------
+static void gen_expr(jit_cg *c, const expr *e);
+static void gen_branch(jit_cg *c, const expr *e, bool when, jit_patches *out);
+
+// Operando que se carga en rcx sin pasar por la pila.
+static bool simple_operand(jit_cg *c, const expr *e){
+    e = strip(e);
+    switch(e->kind){
+        case EXPR_INT_LIT: case EXPR_BOOL_LIT: case EXPR_FLOAT_LIT: return true;
+        case EXPR_IDENT: return e->as.ident.depth >= 0 && e->as.ident.depth < c->nscopes && scalar(e->type);
+        default: return false;
+    }
+}
+static void load_rcx(jit_cg *c, const expr *e){
+    e = strip(e);
+    switch(e->kind){
+        case EXPR_INT_LIT:   load_imm(c, true, (uint64_t)e->as.int_lit.value); break;
+        case EXPR_BOOL_LIT:  load_imm(c, true, e->as.bool_lit.value ? 1u : 0u); break;
+        case EXPR_FLOAT_LIT: load_imm(c, true, float_bits(e->as.float_lit.value)); break;
+        default: load_slot_rcx(c, flat_slot(c, e->as.ident.depth, e->as.ident.slot)); break;
+    }
+}
+// rax = l, rcx = r
+static void gen_operands(jit_cg *c, const expr *l, const expr *r){
+    gen_expr(c, l);
+    if(simple_operand(c, r)){ load_rcx(c, r); return; }
+    EMIT(c, 0x50);                 // push rax
+    gen_expr(c, r);
+    EMIT(c, 0x48, 0x89, 0xc1);     // mov rcx, rax
+    EMIT(c, 0x58);                 // pop rax
+}
+
+// rax = rax op rcx; t es el tipo de los operandos
+static void gen_arith(jit_cg *c, op_kind op, type_kind t){
+    if(t == TYPE_FLOAT){
+        EMIT(c, 0x66, 0x48, 0x0f, 0x6e, 0xc0, 0x66, 0x48, 0x0f, 0x6e, 0xc9); // movq xmm0, rax; movq xmm1, rcx
+        switch(op){
+            case OP_ADD: case OP_PLUS_ASSIGN:  EMIT(c, 0xf2, 0x0f, 0x58, 0xc1); break;
+            case OP_SUB: case OP_MINUS_ASSIGN: EMIT(c, 0xf2, 0x0f, 0x5c, 0xc1); break;
+            case OP_MUL: case OP_STAR_ASSIGN:  EMIT(c, 0xf2, 0x0f, 0x59, 0xc1); break;
+            case OP_DIV: case OP_SLASH_ASSIGN: EMIT(c, 0xf2, 0x0f, 0x5e, 0xc1); break;
+            default: c->ok = false; return;
+        }
+        EMIT(c, 0x66, 0x48, 0x0f, 0x7e, 0xc0); // movq rax, xmm0
+        return;
+    }
+    if(t != TYPE_INT){ c->ok = false; return; }
+    switch(op){
+        case OP_ADD: case OP_PLUS_ASSIGN:  EMIT(c, 0x48, 0x01, 0xc8); break;       // add rax, rcx
+        case OP_SUB: case OP_MINUS_ASSIGN: EMIT(c, 0x48, 0x29, 0xc8); break;       // sub rax, rcx
+        case OP_MUL: case OP_STAR_ASSIGN:  EMIT(c, 0x48, 0x0f, 0xaf, 0xc1); break; // imul rax, rcx
+        case OP_DIV: case OP_SLASH_ASSIGN:
+        case OP_MOD: case OP_PERCENT_ASSIGN: {
+            // x/0 y x%0 dan 0 (como value.c); x/-1 sin idiv (INT64_MIN/-1 atrapa)
+            bool mod = op == OP_MOD || op == OP_PERCENT_ASSIGN;
+            EMIT(c, 0x48, 0x85, 0xc9);                 // test rcx, rcx
+            size_t jz = jcc_fwd(c, CC_E);
+            EMIT(c, 0x48, 0x83, 0xf9, 0xff);           // cmp rcx, -1
+            size_t jm1 = jcc_fwd(c, CC_E);
+            EMIT(c, 0x48, 0x99, 0x48, 0xf7, 0xf9);     // cqo; idiv rcx
+            if(mod) EMIT(c, 0x48, 0x89, 0xd0);         // mov rax, rdx
+            size_t jdone = jmp_fwd(c);
+            patch_here(c, jm1);
+            if(mod) EMIT(c, 0x31, 0xc0); else EMIT(c, 0x48, 0xf7, 0xd8); // xor eax,eax | neg rax
+            size_t jdone2 = jmp_fwd(c);
+            patch_here(c, jz);
+            EMIT(c, 0x31, 0xc0);                       // xor eax, eax
+            patch_here(c, jdone); patch_here(c, jdone2);
+            break;
+        }
+        default: c->ok = false; break;
+    }
+}
+
+static bool is_cmp(op_kind op){
+    return op == OP_EQ || op == OP_NEQ || op == OP_LT || op == OP_LTE || op == OP_GT || op == OP_GTE;
+}
+static uint8_t int_cc(op_kind op){
+    switch(op){
+        case OP_EQ: return CC_E;  case OP_NEQ: return CC_NE;
+        case OP_LT: return CC_L;  case OP_LTE: return CC_LE;
+        case OP_GT: return CC_G;  default:     return CC_GE;
+    }
+}
+
+// Comparación de floats como eval.c: igualdad con tolerancia 1e-12.
+// rax = bool(rax op rcx)
+static void gen_float_cmp(jit_cg *c, op_kind op){
+    EMIT(c, 0x66, 0x48, 0x0f, 0x6e, 0xc0, 0x66, 0x48, 0x0f, 0x6e, 0xc9); // movq xmm0, rax; movq xmm1, rcx
+    EMIT(c, 0x66, 0x0f, 0x2e, 0xc8, 0x0f, 0x97, 0xc2);                  // ucomisd xmm1, xmm0; seta dl  (a < b)
+    EMIT(c, 0xf2, 0x0f, 0x5c, 0xc1, 0x66, 0x48, 0x0f, 0x7e, 0xc0);      // subsd xmm0, xmm1; movq rax, xmm0
+    EMIT(c, 0x48, 0x0f, 0xba, 0xf0, 0x3f, 0x66, 0x48, 0x0f, 0x6e, 0xc0);// btr rax, 63; movq xmm0, rax
+    load_imm(c, true, float_bits(1e-12));
+    EMIT(c, 0x66, 0x48, 0x0f, 0x6e, 0xc9, 0x66, 0x0f, 0x2e, 0xc8, 0x0f, 0x97, 0xc0); // movq xmm1, rcx; ucomisd xmm1, xmm0; seta al (eq)
+    switch(op){
+        case OP_EQ:  break;
+        case OP_NEQ: EMIT(c, 0x34, 0x01); break;                      // xor al, 1
+        case OP_LT:  EMIT(c, 0x88, 0xd0); break;                      // mov al, dl
+        case OP_LTE: EMIT(c, 0x08, 0xd0); break;                      // or al, dl
+        case OP_GT:  EMIT(c, 0x08, 0xd0, 0x34, 0x01); break;
+        default:     EMIT(c, 0x88, 0xd0, 0x34, 0x01); break;          // GTE: !(a < b)
+    }
+    EMIT(c, 0x0f, 0xb6, 0xc0);                                        // movzx eax, al
+}
+
+static void gen_call(jit_cg *c, const expr *e){
+    const expr *callee = e->as.call.callee;
+    if(callee->kind != EXPR_IDENT || !g_jit.global || env_get_builtin(g_jit.global, callee->as.ident.name)){
+        c->ok = false; return;
+    }
+    func_decl *fn = env_get_func(g_jit.global, callee->as.ident.name);
+    size_t argc = e->as.call.args.count;
+    if(!fn || fn->params.count != argc || argc > JIT_MAX_ARGS || fn->ret_type.kind != e->type){ c->ok = false; return; }
+    struct jit_fn *target = jit_get(fn);
+    if(target->state == JIT_FAILED || target->state == JIT_BAILED
+       || (target->state == JIT_NEW && !compile_fn(target, c->group))){ c->ok = false; return; }
+    for(size_t i=0;i<argc;i++){
+        const expr *a = e->as.call.args.items[i];
+        if(a->type != fn->params.items[i].type.kind){ c->ok = false; return; }
+        gen_expr(c, a);
+        EMIT(c, 0x50);                                   // push rax
+    }
+    EMIT(c, 0x48, 0xb8); emit_u64(c, (uint64_t)(uintptr_t)&target->code); // mov rax, &code
+    EMIT(c, 0xff, 0x10);                                 // call [rax]
+    if(argc){ EMIT(c, 0x48, 0x81, 0xc4); emit_u32(c, (uint32_t)(8u * argc)); } // add rsp, 8n
+    EMIT(c, 0x80, 0x7b, 0x18, 0x00);                     // cmp byte [rbx+24], 0
+    patches_push(&c->to_epilogue, jcc_fwd(c, CC_NE));
+}
+
+static void gen_expr(jit_cg *c, const expr *e){
+    if(!c->ok || !e) { c->ok = false; return; }
+    if(!scalar(e->type)){ c->ok = false; return; }
+    switch(e->kind){
+        case EXPR_INT_LIT:   load_imm(c, false, (uint64_t)e->as.int_lit.value); return;
+        case EXPR_BOOL_LIT:  load_imm(c, false, e->as.bool_lit.value ? 1u : 0u); return;
+        case EXPR_FLOAT_LIT: load_imm(c, false, float_bits(e->as.float_lit.value)); return;
+        case EXPR_IDENT:
+            if(e->as.ident.depth < 0){ c->ok = false; return; }
+            load_slot(c, flat_slot(c, e->as.ident.depth, e->as.ident.slot));
+            return;
+        case EXPR_GROUPING: gen_expr(c, e->as.grouping.inner); return;
+
+        case EXPR_UNARY: {
+            const expr *r = e->as.unary.right;
+            if(e->as.unary.op == OP_SUB && r->type == e->type && e->type != TYPE_BOOL){
+                gen_expr(c, r);
+                if(e->type == TYPE_INT) EMIT(c, 0x48, 0xf7, 0xd8);   // neg rax
+                else EMIT(c, 0x66, 0x48, 0x0f, 0x6e, 0xc8,            // movq xmm1, rax
+                          0x66, 0x0f, 0xef, 0xc0, 0xf2, 0x0f, 0x5c, 0xc1, // pxor xmm0,xmm0; subsd xmm0,xmm1
+                          0x66, 0x48, 0x0f, 0x7e, 0xc0);              // movq rax, xmm0
+                return;
+            }
+            if(e->as.unary.op == OP_NOT && e->type == TYPE_BOOL){
+                jit_patches f = {0};
+                gen_branch(c, e, false, &f);      // !x como condición
+                load_imm(c, false, 1);
+                size_t j = jmp_fwd(c);
+                patch_all_here(c, &f);
+                EMIT(c, 0x31, 0xc0);
+                patch_here(c, j);
+                free(f.items);
+                return;
+            }
+            c->ok = false;
+            return;
+        }
+
+        case EXPR_BINARY: {
+            op_kind op = e->as.binary.op;
+            const expr *l = e->as.binary.left, *r = e->as.binary.right;
+            if(op == OP_AND || op == OP_OR || is_cmp(op)){
+                if(e->type != TYPE_BOOL){ c->ok = false; return; }
+                if(is_cmp(op) && l->type == TYPE_FLOAT && r->type == TYPE_FLOAT){
+                    gen_operands(c, l, r);
+                    gen_float_cmp(c, op);
+                    return;
+                }
+                if(is_cmp(op) && l->type == r->type && l->type != TYPE_FLOAT){
+                    if(l->type == TYPE_BOOL && op != OP_EQ && op != OP_NEQ){ c->ok = false; return; }
+                    gen_operands(c, l, r);
+                    EMIT(c, 0x48, 0x39, 0xc8);                    // cmp rax, rcx
+                    setcc_rax(c, int_cc(op));
+                    return;
+                }
+                if(is_cmp(op)){ c->ok = false; return; }
+                jit_patches f = {0};
+                gen_branch(c, e, false, &f);
+                load_imm(c, false, 1);
+                size_t j = jmp_fwd(c);
+                patch_all_here(c, &f);
+                EMIT(c, 0x31, 0xc0);
+                patch_here(c, j);
+                free(f.items);
+                return;
+            }
+            if(l->type != e->type || r->type != e->type){ c->ok = false; return; }
+            gen_operands(c, l, r);
+            gen_arith(c, op, e->type);
+            return;
+        }
+
+        case EXPR_TERNARY: {
+            const expr *t = e->as.ternary.when_true, *f = e->as.ternary.when_false;
+            if(t->type != e->type || f->type != e->type){ c->ok = false; return; }
+            jit_patches jf = {0};
+            gen_branch(c, e->as.ternary.cond, false, &jf);
+            gen_expr(c, t);
+            size_t j = jmp_fwd(c);
+            patch_all_here(c, &jf);
+            gen_expr(c, f);
+            patch_here(c, j);
+            free(jf.items);
+            return;
+        }
+
+        case EXPR_ASSIGN: {
+            const expr *v = e->as.assign.value;
+            if(e->as.assign.depth < 0 || !v || v->type != e->type){ c->ok = false; return; }
+            int s = flat_slot(c, e->as.assign.depth, e->as.assign.slot);
+            if(e->as.assign.op == OP_ASSIGN){
+                gen_expr(c, v);
+            } else {
+                gen_expr(c, v);
+                EMIT(c, 0x48, 0x89, 0xc1);                        // mov rcx, rax
+                load_slot(c, s);
+                gen_arith(c, e->as.assign.op, e->type);
+            }
+            store_slot(c, s);
+            return;
+        }
+
+        case EXPR_CALL: gen_call(c, e); return;
+        default: c->ok = false; return;
+    }
+}
+
+// Salta a `out` si la condición vale `when`; si no, sigue.
+static void gen_branch(jit_cg *c, const expr *e, bool when, jit_patches *out){
+    if(!c->ok) return;
+    e = strip(e);
+    switch(e->kind){
+        case EXPR_BOOL_LIT:
+            if(e->as.bool_lit.value == when) patches_push(out, jmp_fwd(c));
+            return;
+        case EXPR_UNARY:
+            if(e->as.unary.op == OP_NOT){ gen_branch(c, e->as.unary.right, !when, out); return; }
+            break;
+        case EXPR_BINARY: {
+            op_kind op = e->as.binary.op;
+            const expr *l = e->as.binary.left, *r = e->as.binary.right;
+            if(op == OP_AND || op == OP_OR){
+                if((op == OP_AND) != when){          // AND→false / OR→true: cualquiera decide
+                    gen_branch(c, l, when, out);
+                    gen_branch(c, r, when, out);
+                } else {
+                    jit_patches skip = {0};
+                    gen_branch(c, l, !when, &skip);
+                    gen_branch(c, r, when, out);
+                    patch_all_here(c, &skip);
+                    free(skip.items);
+                }
+                return;
+            }
+            if(is_cmp(op) && l->type == r->type && (l->type == TYPE_INT || l->type == TYPE_BOOL)
+               && (l->type == TYPE_INT || op == OP_EQ || op == OP_NEQ)){
+                gen_operands(c, l, r);
+                EMIT(c, 0x48, 0x39, 0xc8);                        // cmp rax, rcx
+                uint8_t cc = int_cc(op);
+                patches_push(out, jcc_fwd(c, when ? cc : (uint8_t)(cc ^ 1u)));
+                return;
+            }
+            break;
+        }
+        default: break;
+    }
+    if(e->type != TYPE_BOOL && e->type != TYPE_INT){ c->ok = false; return; }
+    gen_expr(c, e);
+    EMIT(c, 0x48, 0x85, 0xc0);                                    // test rax, rax
+    patches_push(out, jcc_fwd(c, when ? CC_NE : CC_E));
+}
+
+// ---------------- sentencias ----------------
+static void push_scope(jit_cg *c, int n){
+    if(c->nscopes == 64){ c->ok = false; return; }
+    int base = c->nscopes ? c->bases[c->nscopes-1] + c->counts[c->nscopes-1] : 0;
+    c->bases[c->nscopes] = base; c->counts[c->nscopes] = n; c->nscopes++;
+    if(base + n > c->max_slots) c->max_slots = base + n;
+}
+
+static jit_loop *push_loop(jit_cg *c){
+    if(c->loops_count == c->loops_cap){
+        size_t nc = c->loops_cap ? c->loops_cap*2u : 4u;
+        c->loops = (jit_loop*)realloc(c->loops, nc*sizeof(jit_loop)); c->loops_cap = nc;
+    }
+    jit_loop *l = &c->loops[c->loops_count++];
+    memset(l, 0, sizeof(*l));
+    return l;
+}
+static void pop_loop(jit_cg *c){
+    jit_loop *l = &c->loops[--c->loops_count];
+    free(l->breaks.items); free(l->conts.items);
+}
+
+static bool self_call(const jit_cg *c, const expr *e){
+    e = strip(e);
+    return e && e->kind == EXPR_CALL && e->as.call.callee->kind == EXPR_IDENT
+        && strcmp(e->as.call.callee->as.ident.name, c->self->fn->name) == 0
+        && g_jit.global && !env_get_builtin(g_jit.global, c->self->fn->name)
+        && env_get_func(g_jit.global, c->self->fn->name) == c->self->fn;
+}
+
+static void gen_stmt(jit_cg *c, const stmt *s){
+    if(!c->ok || !s) return;
+    switch(s->kind){
+        case STMT_EXPR: gen_expr(c, s->as.expr_stmt.value); break;
+        case STMT_RETURN: {
+            const expr *v = s->as.ret.value;
+            if(!v || v->type != c->self->fn->ret_type.kind){ c->ok = false; return; }
+            if(self_call(c, v)){
+                // llamada de cola a sí misma: nuevos args en los parámetros y salto
+                const expr *call = strip(v);
+                size_t argc = call->as.call.args.count;
+                const func_decl *fn = c->self->fn;
+                if(argc != fn->params.count){ c->ok = false; return; }
+                for(size_t i=0;i<argc;i++){
+                    if(call->as.call.args.items[i]->type != fn->params.items[i].type.kind){ c->ok = false; return; }
+                    gen_expr(c, call->as.call.args.items[i]);
+                    EMIT(c, 0x50);
+                }
+                for(size_t i=argc;i>0;i--){ EMIT(c, 0x58); store_slot(c, (int)i - 1); }
+                jmp_back(c, c->body_start);
+                return;
+            }
+            gen_expr(c, v);
+            patches_push(&c->to_epilogue, jmp_fwd(c));
+            break;
+        }
+        case STMT_BREAK:
+            if(!c->loops_count){ c->ok = false; return; }
+            patches_push(&c->loops[c->loops_count-1].breaks, jmp_fwd(c));
+            break;
+        case STMT_CONTINUE:
+            if(!c->loops_count){ c->ok = false; return; }
+            patches_push(&c->loops[c->loops_count-1].conts, jmp_fwd(c));
+            break;
+        case STMT_BLOCK:
+            push_scope(c, s->as.block.nslots);
+            for(size_t i=0;i<s->as.block.stmts.count;i++) gen_stmt(c, s->as.block.stmts.items[i]);
+            c->nscopes--;
+            break;
+        case STMT_IF: {
+            jit_patches jf = {0};
+            gen_branch(c, s->as.if_stmt.cond, false, &jf);
+            gen_stmt(c, s->as.if_stmt.then_branch);
+            if(s->as.if_stmt.else_branch){
+                size_t j = jmp_fwd(c);
+                patch_all_here(c, &jf);
+                gen_stmt(c, s->as.if_stmt.else_branch);
+                patch_here(c, j);
+            } else {
+                patch_all_here(c, &jf);
+            }
+            free(jf.items);
+            break;
+        }
+        case STMT_FOR_WHILELIKE: {
+            size_t top = c->b.count;
+            jit_patches jexit = {0};
+            gen_branch(c, s->as.for_while.cond, false, &jexit);
+            push_loop(c);
+            gen_stmt(c, s->as.for_while.body);
+            jit_loop *l = &c->loops[c->loops_count-1];
+            for(size_t i=0;i<l->conts.count;i++)
+                put_u32(c, l->conts.items[i], (uint32_t)(int32_t)(top - (l->conts.items[i] + 4)));
+            jmp_back(c, top);
+            patch_all_here(c, &l->breaks);
+            patch_all_here(c, &jexit);
+            pop_loop(c);
+            free(jexit.items);
+            break;
+        }
+        case STMT_FOR_CLIKE: {
+            gen_stmt(c, s->as.for_clike.init);
+            size_t top = c->b.count;
+            jit_patches jexit = {0};
+            if(s->as.for_clike.cond) gen_branch(c, s->as.for_clike.cond, false, &jexit);
+            push_loop(c);
+            gen_stmt(c, s->as.for_clike.body);
+            jit_loop *l = &c->loops[c->loops_count-1];
+            patch_all_here(c, &l->conts);
+            if(s->as.for_clike.post) gen_expr(c, s->as.for_clike.post);
+            jmp_back(c, top);
+            patch_all_here(c, &l->breaks);
+            patch_all_here(c, &jexit);
+            pop_loop(c);
+            free(jexit.items);
+            break;
+        }
+    }
+}
+
+// ---------------- funciones ----------------
+// Stub con ABI de C: entry(args /*rdi*/, rt /*rsi*/). Deja &rt en rbx y apila
+// los args como los apila una llamada interna.
+static void gen_entry(jit_cg *c, int argc, size_t *call_patch){
+    EMIT(c, 0x53, 0x55, 0x48, 0x89, 0xf3);               // push rbx; push rbp; mov rbx, rsi
+    for(int i=0;i<argc;i++){ EMIT(c, 0xff, 0xb7); emit_u32(c, (uint32_t)(8 * i)); } // push [rdi+8i]
+    EMIT(c, 0xe8); *call_patch = c->b.count; emit_u32(c, 0); // call cuerpo
+    if(argc){ EMIT(c, 0x48, 0x81, 0xc4); emit_u32(c, (uint32_t)(8 * argc)); }
+    EMIT(c, 0x5d, 0x5b, 0xc3);                           // pop rbp; pop rbx; ret
+}
+
+static void gen_function(jit_cg *c, size_t *entry_call){
+    func_decl *fn = c->self->fn;
+    int argc = (int)fn->params.count;
+    gen_entry(c, argc, entry_call);
+    size_t body = c->b.count;
+    patch_here(c, *entry_call);
+    *entry_call = body;
+
+    EMIT(c, 0x55, 0x48, 0x89, 0xe5, 0x48, 0x81, 0xec);   // push rbp; mov rbp, rsp; sub rsp, imm32
+    c->frame_patch = c->b.count; emit_u32(c, 0);
+    EMIT(c, 0x48, 0xff, 0x03);                           // inc qword [rbx]
+    EMIT(c, 0x48, 0x8b, 0x03, 0x48, 0x3b, 0x43, 0x08);   // mov rax, [rbx]; cmp rax, [rbx+8]
+    patches_push(&c->to_bail, jcc_fwd(c, 0x7));          // ja
+    EMIT(c, 0x48, 0x3b, 0x63, 0x10);                     // cmp rsp, [rbx+16]
+    patches_push(&c->to_bail, jcc_fwd(c, 0x2));          // jb
+    for(int i=0;i<argc;i++){
+        EMIT(c, 0x48, 0x8b, 0x85); emit_u32(c, (uint32_t)(16 + 8 * (argc - 1 - i))); // mov rax, [rbp+16+..]
+        store_slot(c, i);
+    }
+    c->body_start = c->b.count;
+    push_scope(c, argc);
+    gen_stmt(c, fn->body);
+
+    // caer al final devuelve void: eso lo hace el intérprete
+    patch_all_here(c, &c->to_bail);
+    EMIT(c, 0xc6, 0x43, 0x18, 0x01);                     // mov byte [rbx+24], 1
+    patch_all_here(c, &c->to_epilogue);
+    EMIT(c, 0x48, 0xff, 0x0b, 0x48, 0x89, 0xec, 0x5d, 0xc3); // dec qword [rbx]; mov rsp, rbp; pop rbp; ret
+    put_u32(c, c->frame_patch, (uint32_t)(((c->max_slots * 8) + 15) & ~15));
+}
+
+static struct jit_fn *jit_get(func_decl *fn){
+    if(fn->native) return fn->native;
+    struct jit_fn *j = (struct jit_fn*)calloc(1, sizeof(*j));
+    j->fn = fn;
+    j->state = JIT_NEW;
+    j->next = g_jit.all; g_jit.all = j;
+    fn->native = j;
+    return j;
+}
+
+static bool typed_signature(const func_decl *fn){
+    if(fn->params.count > JIT_MAX_ARGS || !scalar(fn->ret_type.kind)) return false;
+    for(size_t i=0;i<fn->params.count;i++)
+        if(!scalar(fn->params.items[i].type.kind)) return false;
+    return true;
+}
+
+// Compila j (y, de paso, las funciones a las que llama) en memoria propia.
+// Queda JIT_BUSY hasta que todo el grupo compila.
+static bool compile_fn(struct jit_fn *j, jit_group *g){
+    if(!typed_signature(j->fn)){ j->state = JIT_FAILED; return false; }
+    j->state = JIT_BUSY;
+    if(g->count == g->cap){
+        size_t nc = g->cap ? g->cap*2u : 4u;
+        g->items = (struct jit_fn**)realloc(g->items, nc*sizeof(*g->items)); g->cap = nc;
+    }
+    g->items[g->count++] = j;
+
+    jit_cg c;
+    memset(&c, 0, sizeof(c));
+    c.self = j; c.group = g; c.ok = true;
+    size_t body = 0;
+    gen_function(&c, &body);
+    bool ok = c.ok;
+    if(ok){
+        long page = 4096;
+        size_t len = (c.b.count + (size_t)page - 1) & ~((size_t)page - 1);
+        void *mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(mem == MAP_FAILED){
+            ok = false;
+        } else {
+            memcpy(mem, c.b.code, c.b.count);
+            j->mem = mem; j->mem_len = len;
+            j->code = (uint8_t*)mem + body;
+            memcpy(&j->entry, &mem, sizeof(j->entry)); // el stub va al principio
+        }
+    }
+    if(!ok) j->state = JIT_FAILED;
+    free(c.b.code); free(c.to_epilogue.items); free(c.to_bail.items);
+    for(size_t i=0;i<c.loops_count;i++){ free(c.loops[i].breaks.items); free(c.loops[i].conts.items); }
+    free(c.loops);
+    return ok;
+}
+
+static void unmap(struct jit_fn *j){
+    if(j->mem) munmap(j->mem, j->mem_len);
+    j->mem = NULL; j->code = NULL; j->entry = NULL;
+}
+
+// Intenta compilar fn con todo lo que alcanza. Si algo falla, fn queda en el
+// intérprete y las demás vuelven a contar desde cero.
+static void compile_root(struct jit_fn *root){
+    jit_group g = {0};
+    bool ok = compile_fn(root, &g);
+    for(size_t i=0;i<g.count;i++){
+        struct jit_fn *j = g.items[i];
+        if(ok){
+            if(mprotect(j->mem, j->mem_len, PROT_READ | PROT_EXEC) != 0) ok = false;
+        }
+    }
+    if(g_jit.log){
+        fflush(stdout);
+        if(ok) for(size_t i=0;i<g.count;i++) fprintf(stderr, "JIT: %s compilada\n", g.items[i]->fn->name);
+        else fprintf(stderr, "JIT: %s queda en el intérprete\n", root->fn->name);
+    }
+    for(size_t i=0;i<g.count;i++){
+        struct jit_fn *j = g.items[i];
+        if(ok){ j->state = JIT_READY; continue; }
+        unmap(j);
+        if(j == root || j->state == JIT_FAILED) j->state = JIT_FAILED;
+        else { j->state = JIT_NEW; j->fn->calls = 0; }
+    }
+    free(g.items);
+}
+
+void jit_enable(env_t *global){ g_jit.enabled = true; g_jit.global = global; }
+bool jit_available(void){ return true; }
+void jit_set_log(bool on){ g_jit.log = on; }
+
+bool jit_call(func_decl *fn, const value_t *argv, int argc, size_t depth, size_t max_depth, value_t *out){
+    if(!g_jit.enabled) return false;
+    struct jit_fn *j = fn->native;
+    if(!j || j->state == JIT_NEW){
+        if(++fn->calls < CELER_JIT_THRESHOLD) return false;
+        j = jit_get(fn);
+        compile_root(j);
+    }
+    if(j->state != JIT_READY || argc != (int)fn->params.count) return false;
+
+    int64_t args[JIT_MAX_ARGS];
+    for(int i=0;i<argc;i++){
+        const value_t *v = &argv[i];
+        switch(fn->params.items[i].type.kind){
+            case TYPE_INT:   if(v->kind != VAL_INT) return false; args[i] = v->as.i; break;
+            case TYPE_BOOL:  if(v->kind != VAL_BOOL) return false; args[i] = v->as.b ? 1 : 0; break;
+            case TYPE_FLOAT: if(v->kind != VAL_FLOAT) return false; memcpy(&args[i], &v->as.f, sizeof(double)); break;
+            default: return false;
+        }
+    }
+    char here;
+    jit_rt rt;
+    rt.depth = depth;
+    rt.max_depth = max_depth;
+    rt.floor = (uintptr_t)&here > JIT_STACK_BYTES ? (uintptr_t)&here - JIT_STACK_BYTES : 0;
+    rt.bail = 0;
+    int64_t r = j->entry(args, &rt);
+    if(rt.bail){
+        j->state = JIT_BAILED;
+        if(g_jit.log){ fflush(stdout); fprintf(stderr, "JIT: %s abandonó; sigue en el intérprete\n", fn->name); }
+        return false;
+    }
+    switch(fn->ret_type.kind){
+        case TYPE_INT:   *out = v_int(r); break;
+        case TYPE_BOOL:  *out = v_bool(r != 0); break;
+        default: { double d; memcpy(&d, &r, sizeof(d)); *out = v_float(d); break; }
+    }
+    return true;
+}
+
+void jit_release(void){
+    struct jit_fn *j = g_jit.all;
+    while(j){
+        struct jit_fn *next = j->next;
+        unmap(j);
+        j->fn->native = NULL;
+        free(j);
+        j = next;
+    }
+    g_jit.all = NULL;
+    g_jit.enabled = false;
+}
+
+#else /* sin JIT en esta plataforma */
+
+void jit_enable(env_t *global){ (void)global; }
+bool jit_available(void){ return false; }
+void jit_set_log(bool on){ (void)on; }
+bool jit_call(func_decl *fn, const value_t *argv, int argc, size_t depth, size_t max_depth, value_t *out){
+    (void)fn; (void)argv; (void)argc; (void)depth; (void)max_depth; (void)out;
+    return false;
+}
+void jit_release(void){}
+
+#endif
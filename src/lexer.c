@@ -1,15 +1,42 @@
 #include "../include/lexer.h"
 #include <string.h>
-#include <ctype.h>
 #include <stdlib.h>
 
-// Helpers de avance/peek
-static int is_ident_start(int c) {
-    return (c == '_' || isalpha((unsigned char)c));
-}
-static int is_ident_part(int c) {
-    return (c == '_' || isalnum((unsigned char)c));
-}
+#if defined(__SSE2__) && !defined(CELER_NO_SIMD)
+#include <emmintrin.h>
+#define LEXER_USE_SSE2 1
+#endif
+
+// Clases de byte (tabla de 256 entradas, sólo ASCII; el resto es ilegal).
+enum {
+    CC_SPACE = 1u << 0,   // ' ' \t \r \n
+    CC_ALPHA = 1u << 1,   // inicio de identificador: [A-Za-z_]
+    CC_DIGIT = 1u << 2,   // [0-9]
+};
+#define CC_IDENT (CC_ALPHA | CC_DIGIT)
+
+static const unsigned char CC[256] = {
+    ['\t'] = CC_SPACE, ['\n'] = CC_SPACE, ['\r'] = CC_SPACE, [' '] = CC_SPACE,
+    ['0'] = CC_DIGIT, ['1'] = CC_DIGIT, ['2'] = CC_DIGIT, ['3'] = CC_DIGIT, ['4'] = CC_DIGIT,
+    ['5'] = CC_DIGIT, ['6'] = CC_DIGIT, ['7'] = CC_DIGIT, ['8'] = CC_DIGIT, ['9'] = CC_DIGIT,
+    ['_'] = CC_ALPHA,
+    ['A'] = CC_ALPHA, ['B'] = CC_ALPHA, ['C'] = CC_ALPHA, ['D'] = CC_ALPHA, ['E'] = CC_ALPHA,
+    ['F'] = CC_ALPHA, ['G'] = CC_ALPHA, ['H'] = CC_ALPHA, ['I'] = CC_ALPHA, ['J'] = CC_ALPHA,
+    ['K'] = CC_ALPHA, ['L'] = CC_ALPHA, ['M'] = CC_ALPHA, ['N'] = CC_ALPHA, ['O'] = CC_ALPHA,
+    ['P'] = CC_ALPHA, ['Q'] = CC_ALPHA, ['R'] = CC_ALPHA, ['S'] = CC_ALPHA, ['T'] = CC_ALPHA,
+    ['U'] = CC_ALPHA, ['V'] = CC_ALPHA, ['W'] = CC_ALPHA, ['X'] = CC_ALPHA, ['Y'] = CC_ALPHA,
+    ['Z'] = CC_ALPHA,
+    ['a'] = CC_ALPHA, ['b'] = CC_ALPHA, ['c'] = CC_ALPHA, ['d'] = CC_ALPHA, ['e'] = CC_ALPHA,
+    ['f'] = CC_ALPHA, ['g'] = CC_ALPHA, ['h'] = CC_ALPHA, ['i'] = CC_ALPHA, ['j'] = CC_ALPHA,
+    ['k'] = CC_ALPHA, ['l'] = CC_ALPHA, ['m'] = CC_ALPHA, ['n'] = CC_ALPHA, ['o'] = CC_ALPHA,
+    ['p'] = CC_ALPHA, ['q'] = CC_ALPHA, ['r'] = CC_ALPHA, ['s'] = CC_ALPHA, ['t'] = CC_ALPHA,
+    ['u'] = CC_ALPHA, ['v'] = CC_ALPHA, ['w'] = CC_ALPHA, ['x'] = CC_ALPHA, ['y'] = CC_ALPHA,
+    ['z'] = CC_ALPHA,
+};
+#define CLASS(c) (CC[(unsigned char)(c)])
+
+// Posición: sólo se lleva la línea y el inicio de la línea actual; la columna
+// se calcula al emitir un token (no se actualiza por carácter).
 static int at_end(const lexer_t *lx) {
     return lx->pos >= lx->len;
 }
@@ -22,33 +49,48 @@ static char peek2(const lexer_t *lx) {
 static char peek3(const lexer_t *lx) {
     return (lx->pos + 2u < lx->len) ? lx->src[lx->pos + 2u] : '\0';
 }
-static char advance(lexer_t *lx) {
-    if (at_end(lx)) return '\0';
-    char c = lx->src[lx->pos++];
-    if (c == '\n') {
-        lx->line += 1;
-        lx->col = 1;
-    } else {
-        lx->col += 1;
-    }
-    return c;
+static int column(const lexer_t *lx) {
+    return (int)(lx->pos - lx->line_start) + 1;
+}
+static void newline_at(lexer_t *lx, size_t nl_pos) {
+    lx->line += 1;
+    lx->line_start = nl_pos + 1u;
 }
 static int match(lexer_t *lx, char expected) {
     if (at_end(lx)) return 0;
     if (lx->src[lx->pos] != expected) return 0;
-    advance(lx);
+    lx->pos++; // nunca es '\n'
     return 1;
 }
 
+// Primer byte en [p, end) igual a a, b o c (o end). Con SSE2 se comparan
+// 16 bytes por iteración.
+static const char *find_any3(const char *p, const char *end, char a, char b, char c) {
+#ifdef LEXER_USE_SSE2
+    const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c);
+    while ((size_t)(end - p) >= 16u) {
+        __m128i x = _mm_loadu_si128((const __m128i*)p);
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)),
+                                 _mm_cmpeq_epi8(x, vc));
+        int mask = _mm_movemask_epi8(m);
+        if (mask) return p + __builtin_ctz((unsigned)mask);
+        p += 16;
+    }
+#endif
+    for (; p < end; p++) {
+        if (*p == a || *p == b || *p == c) return p;
+    }
+    return end;
+}
+
 static void skip_spaces_and_linebreaks(lexer_t *lx) {
-    for (;;) {
-        char c = peek(lx);
-        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
-            advance(lx);
-            continue;
-        }
-        break;
+    const char *s = lx->src;
+    size_t pos = lx->pos, len = lx->len;
+    while (pos < len && (CLASS(s[pos]) & CC_SPACE)) {
+        if (s[pos] == '\n') newline_at(lx, pos);
+        pos++;
     }
+    lx->pos = pos;
 }
 
 // Consume comentario de línea (*--) o bloque (/* ... */). Devuelve 1 si consumió algo y continúa.
@@ -58,28 +100,34 @@ static int try_skip_comment(lexer_t *lx) {
     char c2 = peek2(lx);
     char c3 = peek3(lx);
 
-    // Comentario de línea: *--
+    // Comentario de línea: *-- hasta fin de línea (el '\n' lo consume el skip de espacios)
     if (c == '*' && c2 == '-' && c3 == '-') {
-        // consumir *--
-        advance(lx); advance(lx); advance(lx);
-        // hasta fin de línea o EOF
-        while (!at_end(lx) && peek(lx) != '\n') advance(lx);
+        const char *p = lx->src + lx->pos + 3u;
+        const char *nl = (const char*)memchr(p, '\n', lx->len - (lx->pos + 3u));
+        lx->pos = nl ? (size_t)(nl - lx->src) : lx->len;
         return 1;
     }
 
-    // Comentario de bloque: /* ... */
+    // Comentario de bloque: /* ... */ saltando hasta el siguiente '*' o '\n'
     if (c == '/' && c2 == '*') {
-        // consumir /*
-        advance(lx); advance(lx);
-        // avanzar hasta */
-        while (!at_end(lx)) {
-            char ch = advance(lx);
-            if (ch == '*' && peek(lx) == '/') {
-                advance(lx); // consumir '/'
+        const char *end = lx->src + lx->len;
+        const char *p = lx->src + lx->pos + 2u;
+        for (;;) {
+            p = find_any3(p, end, '*', '\n', '\n');
+            if (p == end) break;
+            if (*p == '\n') {
+                newline_at(lx, (size_t)(p - lx->src));
+                p++;
+                continue;
+            }
+            if (p + 1 < end && p[1] == '/') {
+                lx->pos = (size_t)(p + 2 - lx->src);
                 return 1;
             }
+            p++;
         }
         // EOF alcanzado sin cerrar
+        lx->pos = lx->len;
         return -1;
     }
 
@@ -99,57 +147,64 @@ static void skip_ignorable(lexer_t *lx, int *unterminated_block_comment) {
 
 // Escanea un identificador/keyword
 static token_t scan_ident_or_keyword(lexer_t *lx, int start_line, int start_col) {
-    size_t start = lx->pos;
-    while (is_ident_part(peek(lx))) advance(lx);
-    size_t end = lx->pos;
-    size_t len = end - start;
+    const char *s = lx->src;
+    size_t start = lx->pos, pos = start + 1u, len = lx->len;
+    while (pos < len && (CLASS(s[pos]) & CC_IDENT)) pos++;
+    lx->pos = pos;
     // keyword lookup (sensible a mayúsculas)
-    token_type t = token_keyword_lookup(&lx->src[start], len);
-    return token_make(t, &lx->src[start], len, start_line, start_col);
+    token_type t = token_keyword_lookup(&s[start], pos - start);
+    return token_make(t, &s[start], pos - start, start_line, start_col);
 }
 
 // Escanea números (int o float sin notación científica)
 static token_t scan_number(lexer_t *lx, int start_line, int start_col) {
-    size_t start = lx->pos;
+    const char *s = lx->src;
+    size_t start = lx->pos, pos = start, len = lx->len;
     // parte entera
-    while (isdigit((unsigned char)peek(lx))) advance(lx);
+    while (pos < len && (CLASS(s[pos]) & CC_DIGIT)) pos++;
 
     token_type t = TOK_INT_LIT;
 
     // parte decimal opcional: .<dígitos>
-    if (peek(lx) == '.' && isdigit((unsigned char)peek2(lx))) {
+    if (pos + 1u < len && s[pos] == '.' && (CLASS(s[pos + 1u]) & CC_DIGIT)) {
         t = TOK_FLOAT_LIT;
-        advance(lx); // consume '.'
-        while (isdigit((unsigned char)peek(lx))) advance(lx);
+        pos += 2u;
+        while (pos < len && (CLASS(s[pos]) & CC_DIGIT)) pos++;
     }
 
-    size_t end = lx->pos;
-    return token_make(t, &lx->src[start], end - start, start_line, start_col);
+    lx->pos = pos;
+    return token_make(t, &s[start], pos - start, start_line, start_col);
 }
 
 // Escanea string con escapes básicos. Conserva el lexema con comillas.
 // Si no cierra, emite TOK_ILLEGAL con mensaje.
 static token_t scan_string(lexer_t *lx, int start_line, int start_col) {
     size_t start = lx->pos - 1; // incluye la comilla inicial
-    int closed = 0;
+    const char *end = lx->src + lx->len;
+    const char *p = lx->src + lx->pos;
 
-    while (!at_end(lx)) {
-        char ch = advance(lx);
-        if (ch == '\"') { closed = 1; break; }
-        if (ch == '\\') {
+    // salta el cuerpo de a bloques hasta '"', '\\' o '\n' (este último sólo
+    // para llevar la cuenta de líneas; los saltos reales se permiten)
+    for (;;) {
+        p = find_any3(p, end, '\"', '\\', '\n');
+        if (p == end) break;
+        if (*p == '\"') {
+            lx->pos = (size_t)(p + 1 - lx->src);
+            return token_make(TOK_STRING_LIT, &lx->src[start], lx->pos - start, start_line, start_col);
+        }
+        if (*p == '\\') {
             // escape: consumir el siguiente si existe
-            if (!at_end(lx)) advance(lx);
+            if (p + 1 >= end) { p = end; break; }
+            p++;
+            if (*p != '\n') { p++; continue; }
         }
-        // las nuevas líneas dentro de string son válidas sólo si van escapadas,
-        // aquí permitimos \n (el real newline ya ha incrementado línea/col).
+        newline_at(lx, (size_t)(p - lx->src));
+        p++;
     }
 
-    if (!closed) {
-        // crear un token ILLEGAL con mensaje
-        return token_from_cstr(TOK_ILLEGAL, "Unterminated string literal", start_line, start_col);
-    }
-    size_t end = lx->pos;
-    return token_make(TOK_STRING_LIT, &lx->src[start], end - start, start_line, start_col);
+    // crear un token ILLEGAL con mensaje
+    lx->pos = lx->len;
+    return token_from_cstr(TOK_ILLEGAL, "Unterminated string literal", start_line, start_col);
 }
 
 void lexer_init(lexer_t *lx, const char *src, size_t len) {
@@ -157,12 +212,13 @@ void lexer_init(lexer_t *lx, const char *src, size_t len) {
     lx->len = src ? len : 0u;
     lx->pos = 0u;
     lx->line = 1;
-    lx->col = 1;
+    lx->line_start = 0u;
 }
 void lexer_from_cstr(lexer_t *lx, const char *src) {
     lexer_init(lx, src, src ? strlen(src) : 0u);
 }
 
+// Los lexemas de operadores apuntan a literales estáticos: no hay copia.
 static token_t make_single(token_type t, const char *lex, int line, int col) {
     return token_from_cstr(t, lex, line, col);
 }
@@ -172,35 +228,28 @@ token_t lexer_next_token(lexer_t *lx) {
         return token_from_cstr(TOK_ILLEGAL, "NULL lexer", 0, 0);
     }
 
-    for (;;) {
-        int unterminated = 0;
-        skip_ignorable(lx, &unterminated);
-        if (unterminated) {
-            return token_from_cstr(TOK_ILLEGAL, "Unterminated block comment", lx->line, lx->col);
-        }
-        break;
+    int unterminated = 0;
+    skip_ignorable(lx, &unterminated);
+    if (unterminated) {
+        return token_from_cstr(TOK_ILLEGAL, "Unterminated block comment", lx->line, column(lx));
     }
 
     if (at_end(lx)) {
-        return token_from_cstr(TOK_EOF, "", lx->line, lx->col);
+        return token_from_cstr(TOK_EOF, "", lx->line, column(lx));
     }
 
     int start_line = lx->line;
-    int start_col  = lx->col;
-    char c = advance(lx);
+    int start_col  = column(lx);
+    char c = lx->src[lx->pos];
+    unsigned cls = CLASS(c);
 
     // Identificadores / keywords
-    if (is_ident_start(c)) {
-        // retrocede 1 (porque advance ya lo consumió) y usa escáner
-        lx->pos--; lx->col--;
-        return scan_ident_or_keyword(lx, start_line, start_col);
-    }
+    if (cls & CC_ALPHA) return scan_ident_or_keyword(lx, start_line, start_col);
 
     // Números
-    if (isdigit((unsigned char)c)) {
-        lx->pos--; lx->col--;
-        return scan_number(lx, start_line, start_col);
-    }
+    if (cls & CC_DIGIT) return scan_number(lx, start_line, start_col);
+
+    lx->pos++;
 
     // Strings
     if (c == '\"') {
@@ -261,6 +310,5 @@ token_t lexer_next_token(lexer_t *lx) {
     }
 
     // Si nada matcheó, es ilegal
-    char buf[2] = { c, '\0' };
-    return token_from_cstr(TOK_ILLEGAL, buf, start_line, start_col);
+    return token_make(TOK_ILLEGAL, &lx->src[lx->pos - 1u], 1u, start_line, start_col);
 }
@@ -0,0 +1,1385 @@
+#include "../include/optimizer.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// const globales propagables: nombre -> literal
+typedef struct {
+    const char *name;
+    const expr *lit;
+    size_t decl_index; // visible en inicializadores posteriores
+    bool in_funcs;     // visible en cuerpos de función
+} const_entry;
+
+typedef struct {
+    ast_arena *arena;
+    const_entry *consts; size_t consts_count, consts_cap;
+    size_t decl_index;   // inicializador global en curso
+    bool in_func;        // plegando un cuerpo de función
+} folder_t;
+
+static bool is_literal(const expr *e){
+    switch(e->kind){
+        case EXPR_INT_LIT: case EXPR_FLOAT_LIT: case EXPR_BOOL_LIT: case EXPR_STRING_LIT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static value_t literal_value(const expr *e){
+    switch(e->kind){
+        case EXPR_INT_LIT:    return v_int(e->as.int_lit.value);
+        case EXPR_FLOAT_LIT:  return v_float(e->as.float_lit.value);
+        case EXPR_BOOL_LIT:   return v_bool(e->as.bool_lit.value);
+        case EXPR_STRING_LIT: return value_copy(&e->as.string_lit.value);
+        default:              return v_void();
+    }
+}
+
+// Nodo literal equivalente a v (consume v). NULL si v no es representable (void).
+static expr *literal_from_value(ast_arena *a, value_t *v, int line, int col){
+    expr *out = NULL;
+    switch(v->kind){
+        case VAL_INT:    out = expr_int(a, v->as.i, line, col); break;
+        case VAL_FLOAT:  out = expr_float(a, v->as.f, line, col); break;
+        case VAL_BOOL:   out = expr_bool(a, v->as.b, line, col); break;
+        case VAL_STRING: out = expr_string(a, value_str(v), line, col); break;
+        default: break;
+    }
+    value_free(v);
+    return out;
+}
+
+static value_t fold_binary_op(const value_t *L, op_kind op, const value_t *R){
+    // INT64_MIN / -1 atrapa (SIGFPE) en x86: se deja para el runtime, que sólo
+    // lo evalúa si el programa llega ahí
+    if((op == OP_DIV || op == OP_MOD) && L->kind == VAL_INT && R->kind == VAL_INT
+       && L->as.i == LLONG_MIN && R->as.i == -1) return v_void();
+    switch(op){
+        case OP_ADD: return value_add(L,R);
+        case OP_SUB: return value_sub(L,R);
+        case OP_MUL: return value_mul(L,R);
+        case OP_DIV: return value_div(L,R);
+        case OP_MOD: return value_mod(L,R);
+        case OP_EQ:  return value_eq (L,R);
+        case OP_NEQ: return value_neq(L,R);
+        case OP_LT:  return value_lt (L,R);
+        case OP_LTE: return value_lte(L,R);
+        case OP_GT:  return value_gt (L,R);
+        case OP_GTE: return value_gte(L,R);
+        case OP_AND: return value_and(L,R);
+        case OP_OR:  return value_or (L,R);
+        default:     return v_void();
+    }
+}
+
+static const const_entry *find_const(const folder_t *f, const char *name){
+    for(size_t i=0;i<f->consts_count;i++){
+        if(strcmp(f->consts[i].name, name)==0) return &f->consts[i];
+    }
+    return NULL;
+}
+
+// ---------------- plegado ----------------
+static expr *fold_expr(folder_t *f, expr *e);
+static void fold_stmt(folder_t *f, stmt *s);
+
+static expr *fold_expr(folder_t *f, expr *e){
+    if(!e) return NULL;
+    switch(e->kind){
+        case EXPR_IDENT: {
+            if(e->as.ident.depth >= 0) return e;
+            const const_entry *c = find_const(f, e->as.ident.name);
+            if(!c || (f->in_func ? !c->in_funcs : c->decl_index >= f->decl_index)) return e;
+            value_t v = literal_value(c->lit);
+            expr *lit = literal_from_value(f->arena, &v, e->line, e->col);
+            return lit ? lit : e;
+        }
+
+        case EXPR_GROUPING:
+            return fold_expr(f, e->as.grouping.inner);
+
+        case EXPR_UNARY: {
+            e->as.unary.right = fold_expr(f, e->as.unary.right);
+            if(!is_literal(e->as.unary.right)) return e;
+            value_t R = literal_value(e->as.unary.right), out = v_void();
+            if(e->as.unary.op == OP_NOT){
+                out = value_not(&R);
+            } else if(e->as.unary.op == OP_SUB){
+                value_t zero = v_int(0);
+                out = value_sub(&zero, &R);
+            }
+            value_free(&R);
+            expr *lit = literal_from_value(f->arena, &out, e->line, e->col);
+            return lit ? lit : e;
+        }
+
+        case EXPR_BINARY: {
+            e->as.binary.left  = fold_expr(f, e->as.binary.left);
+            e->as.binary.right = fold_expr(f, e->as.binary.right);
+            op_kind op = e->as.binary.op;
+            if((op == OP_AND || op == OP_OR) && is_literal(e->as.binary.left)){
+                // cortocircuito: `false && x` / `true || x` no evalúan x
+                value_t L = literal_value(e->as.binary.left), Lb = value_to_bool(&L);
+                bool decided = (op == OP_AND) ? !Lb.as.b : Lb.as.b;
+                value_free(&L);
+                if(decided) return expr_bool(f->arena, op == OP_OR, e->line, e->col);
+                if(e->as.binary.right->type == TYPE_BOOL) return e->as.binary.right;
+            }
+            if(!is_literal(e->as.binary.left) || !is_literal(e->as.binary.right)) return e;
+            value_t L = literal_value(e->as.binary.left), R = literal_value(e->as.binary.right);
+            value_t out = fold_binary_op(&L, e->as.binary.op, &R);
+            value_free(&L); value_free(&R);
+            expr *lit = literal_from_value(f->arena, &out, e->line, e->col);
+            return lit ? lit : e;
+        }
+
+        case EXPR_TERNARY: {
+            e->as.ternary.cond       = fold_expr(f, e->as.ternary.cond);
+            e->as.ternary.when_true  = fold_expr(f, e->as.ternary.when_true);
+            e->as.ternary.when_false = fold_expr(f, e->as.ternary.when_false);
+            if(!is_literal(e->as.ternary.cond)) return e;
+            value_t C = literal_value(e->as.ternary.cond);
+            value_t Cb = value_to_bool(&C);
+            bool take_true = Cb.as.b;
+            value_free(&C); value_free(&Cb);
+            return take_true ? e->as.ternary.when_true : e->as.ternary.when_false;
+        }
+
+        case EXPR_ASSIGN:
+            e->as.assign.value = fold_expr(f, e->as.assign.value);
+            return e;
+
+        case EXPR_CALL:
+            // el callee se busca por nombre: no se toca
+            for(size_t i=0;i<e->as.call.args.count;i++)
+                e->as.call.args.items[i] = fold_expr(f, e->as.call.args.items[i]);
+            return e;
+
+        case EXPR_ARRAY:
+            // cada evaluación crea un array nuevo: sólo se pliegan los elementos
+            for(size_t i=0;i<e->as.array.items.count;i++)
+                e->as.array.items.items[i] = fold_expr(f, e->as.array.items.items[i]);
+            return e;
+
+        case EXPR_INDEX:
+            e->as.index.target = fold_expr(f, e->as.index.target);
+            e->as.index.index  = fold_expr(f, e->as.index.index);
+            return e;
+
+        case EXPR_INDEX_ASSIGN:
+            e->as.index_assign.target = fold_expr(f, e->as.index_assign.target);
+            e->as.index_assign.index  = fold_expr(f, e->as.index_assign.index);
+            e->as.index_assign.value  = fold_expr(f, e->as.index_assign.value);
+            return e;
+
+        default:
+            return e;
+    }
+}
+
+static void fold_stmt(folder_t *f, stmt *s){
+    if(!s) return;
+    switch(s->kind){
+        case STMT_EXPR:   s->as.expr_stmt.value = fold_expr(f, s->as.expr_stmt.value); break;
+        case STMT_RETURN: s->as.ret.value = fold_expr(f, s->as.ret.value); break;
+        case STMT_BLOCK:
+            for(size_t i=0;i<s->as.block.stmts.count;i++) fold_stmt(f, s->as.block.stmts.items[i]);
+            break;
+        case STMT_IF:
+            s->as.if_stmt.cond = fold_expr(f, s->as.if_stmt.cond);
+            fold_stmt(f, s->as.if_stmt.then_branch);
+            fold_stmt(f, s->as.if_stmt.else_branch);
+            break;
+        case STMT_FOR_WHILELIKE:
+            s->as.for_while.cond = fold_expr(f, s->as.for_while.cond);
+            fold_stmt(f, s->as.for_while.body);
+            break;
+        case STMT_FOR_CLIKE:
+            fold_stmt(f, s->as.for_clike.init);
+            s->as.for_clike.cond = fold_expr(f, s->as.for_clike.cond);
+            s->as.for_clike.post = fold_expr(f, s->as.for_clike.post);
+            fold_stmt(f, s->as.for_clike.body);
+            break;
+        default: break;
+    }
+}
+
+// ---------------- candidatos a propagación ----------------
+// Un global no se propaga si se asigna por nombre en algún sitio (la
+// asignación a un const global crea un global que lo sombrea).
+static bool assigns_global(const expr *e, const char *name);
+
+static bool assigns_global_stmt(const stmt *s, const char *name){
+    if(!s) return false;
+    switch(s->kind){
+        case STMT_EXPR:   return assigns_global(s->as.expr_stmt.value, name);
+        case STMT_RETURN: return assigns_global(s->as.ret.value, name);
+        case STMT_BLOCK:
+            for(size_t i=0;i<s->as.block.stmts.count;i++)
+                if(assigns_global_stmt(s->as.block.stmts.items[i], name)) return true;
+            return false;
+        case STMT_IF:
+            return assigns_global(s->as.if_stmt.cond, name)
+                || assigns_global_stmt(s->as.if_stmt.then_branch, name)
+                || assigns_global_stmt(s->as.if_stmt.else_branch, name);
+        case STMT_FOR_WHILELIKE:
+            return assigns_global(s->as.for_while.cond, name)
+                || assigns_global_stmt(s->as.for_while.body, name);
+        case STMT_FOR_CLIKE:
+            return assigns_global_stmt(s->as.for_clike.init, name)
+                || assigns_global(s->as.for_clike.cond, name)
+                || assigns_global(s->as.for_clike.post, name)
+                || assigns_global_stmt(s->as.for_clike.body, name);
+        default: return false;
+    }
+}
+
+static bool assigns_global(const expr *e, const char *name){
+    if(!e) return false;
+    switch(e->kind){
+        case EXPR_ASSIGN:
+            if(e->as.assign.depth < 0 && strcmp(e->as.assign.name, name)==0) return true;
+            return assigns_global(e->as.assign.value, name);
+        case EXPR_UNARY:    return assigns_global(e->as.unary.right, name);
+        case EXPR_BINARY:   return assigns_global(e->as.binary.left, name) || assigns_global(e->as.binary.right, name);
+        case EXPR_GROUPING: return assigns_global(e->as.grouping.inner, name);
+        case EXPR_TERNARY:
+            return assigns_global(e->as.ternary.cond, name)
+                || assigns_global(e->as.ternary.when_true, name)
+                || assigns_global(e->as.ternary.when_false, name);
+        case EXPR_CALL:
+            for(size_t i=0;i<e->as.call.args.count;i++)
+                if(assigns_global(e->as.call.args.items[i], name)) return true;
+            return false;
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++)
+                if(assigns_global(e->as.array.items.items[i], name)) return true;
+            return false;
+        case EXPR_INDEX:
+            return assigns_global(e->as.index.target, name) || assigns_global(e->as.index.index, name);
+        case EXPR_INDEX_ASSIGN:
+            return assigns_global(e->as.index_assign.target, name) || assigns_global(e->as.index_assign.index, name)
+                || assigns_global(e->as.index_assign.value, name);
+        default: return false;
+    }
+}
+
+static bool has_call(const expr *e){
+    if(!e) return false;
+    switch(e->kind){
+        case EXPR_CALL:     return true;
+        case EXPR_ASSIGN:   return has_call(e->as.assign.value);
+        case EXPR_UNARY:    return has_call(e->as.unary.right);
+        case EXPR_BINARY:   return has_call(e->as.binary.left) || has_call(e->as.binary.right);
+        case EXPR_GROUPING: return has_call(e->as.grouping.inner);
+        case EXPR_TERNARY:
+            return has_call(e->as.ternary.cond) || has_call(e->as.ternary.when_true)
+                || has_call(e->as.ternary.when_false);
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++)
+                if(has_call(e->as.array.items.items[i])) return true;
+            return false;
+        case EXPR_INDEX:    return has_call(e->as.index.target) || has_call(e->as.index.index);
+        case EXPR_INDEX_ASSIGN:
+            return has_call(e->as.index_assign.target) || has_call(e->as.index_assign.index)
+                || has_call(e->as.index_assign.value);
+        default: return false;
+    }
+}
+
+static bool propagatable(const program_ast *P, size_t idx){
+    const var_decl *v = &P->decls.items[idx]->as.var;
+    for(size_t i=0;i<P->decls.count;i++){
+        const decl *d = P->decls.items[i];
+        const char *other = d->kind==DECL_VAR ? d->as.var.name : d->as.func.name;
+        if(i != idx && strcmp(other, v->name)==0) return false;
+        if(d->kind==DECL_VAR ? assigns_global(d->as.var.init, v->name)
+                             : assigns_global_stmt(d->as.func.body, v->name)) return false;
+    }
+    return true;
+}
+
+static void add_const(folder_t *f, const char *name, const expr *lit, size_t idx, bool in_funcs){
+    if(f->consts_count==f->consts_cap){
+        size_t nc=f->consts_cap?f->consts_cap*2u:8u;
+        f->consts=(const_entry*)realloc(f->consts, nc*sizeof(const_entry));
+        f->consts_cap=nc;
+    }
+    f->consts[f->consts_count].name=name;
+    f->consts[f->consts_count].lit=lit;
+    f->consts[f->consts_count].decl_index=idx;
+    f->consts[f->consts_count].in_funcs=in_funcs;
+    f->consts_count++;
+}
+
+// ---------------- LICM y reducción de fuerza ----------------
+// Trabaja sobre los bucles que son sentencias directas de un bloque B. Los
+// valores invariantes se calculan una vez en slots nuevos de B (B.nslots
+// crece), asignados justo antes del bucle. Las profundidades de un bucle se
+// miden desde B: `off` es la cantidad de bloques entre la expresión y B.
+typedef struct { int depth, slot; } var_ref;
+
+typedef struct {
+    const expr *src;       // expresión ya rebasada a B (para reutilizar el temporal)
+    const char *name;
+    int slot;              // slot del temporal en B
+} hoisted;
+
+typedef struct {
+    const program_ast *P;
+    ast_arena *arena;
+    stmt *outer;                                  // B
+    var_ref *defs; size_t defs_count, defs_cap;   // locales de B (o de más afuera) asignados en el bucle
+    const char **gdefs; size_t gdefs_count, gdefs_cap; // globales asignados por nombre en el bucle
+    bool calls;                                   // una llamada puede asignar globales
+    hoisted *temps; size_t temps_count, temps_cap;
+    stmt **pre; size_t pre_count, pre_cap;        // sentencias a insertar antes del bucle
+    unsigned *serial;                             // nombres únicos de temporales
+} loop_t;
+
+static void push_def(loop_t *L, int depth, int slot){
+    if(L->defs_count==L->defs_cap){
+        size_t nc=L->defs_cap?L->defs_cap*2u:8u;
+        L->defs=(var_ref*)realloc(L->defs, nc*sizeof(var_ref)); L->defs_cap=nc;
+    }
+    L->defs[L->defs_count].depth=depth; L->defs[L->defs_count].slot=slot; L->defs_count++;
+}
+
+static void push_gdef(loop_t *L, const char *name){
+    if(L->gdefs_count==L->gdefs_cap){
+        size_t nc=L->gdefs_cap?L->gdefs_cap*2u:4u;
+        L->gdefs=(const char**)realloc(L->gdefs, nc*sizeof(const char*)); L->gdefs_cap=nc;
+    }
+    L->gdefs[L->gdefs_count++]=name;
+}
+
+static void push_pre(loop_t *L, stmt *s){
+    if(L->pre_count==L->pre_cap){
+        size_t nc=L->pre_cap?L->pre_cap*2u:4u;
+        L->pre=(stmt**)realloc(L->pre, nc*sizeof(stmt*)); L->pre_cap=nc;
+    }
+    L->pre[L->pre_count++]=s;
+}
+
+static size_t def_count(const loop_t *L, int depth, int slot){
+    size_t n=0;
+    for(size_t i=0;i<L->defs_count;i++)
+        if(L->defs[i].depth==depth && L->defs[i].slot==slot) n++;
+    return n;
+}
+
+// ---- def-use: qué asigna el bucle ----
+static void collect_defs_stmt(loop_t *L, const stmt *s, int off);
+
+static void collect_defs(loop_t *L, const expr *e, int off){
+    if(!e) return;
+    switch(e->kind){
+        case EXPR_ASSIGN:
+            if(e->as.assign.depth < 0) push_gdef(L, e->as.assign.name);
+            else if(e->as.assign.depth >= off) push_def(L, e->as.assign.depth - off, e->as.assign.slot);
+            collect_defs(L, e->as.assign.value, off);
+            break;
+        case EXPR_UNARY:    collect_defs(L, e->as.unary.right, off); break;
+        case EXPR_BINARY:   collect_defs(L, e->as.binary.left, off); collect_defs(L, e->as.binary.right, off); break;
+        case EXPR_GROUPING: collect_defs(L, e->as.grouping.inner, off); break;
+        case EXPR_TERNARY:
+            collect_defs(L, e->as.ternary.cond, off);
+            collect_defs(L, e->as.ternary.when_true, off);
+            collect_defs(L, e->as.ternary.when_false, off);
+            break;
+        case EXPR_CALL:
+            L->calls = true;
+            for(size_t i=0;i<e->as.call.args.count;i++) collect_defs(L, e->as.call.args.items[i], off);
+            break;
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++) collect_defs(L, e->as.array.items.items[i], off);
+            break;
+        case EXPR_INDEX:
+            collect_defs(L, e->as.index.target, off);
+            collect_defs(L, e->as.index.index, off);
+            break;
+        case EXPR_INDEX_ASSIGN: // cambia el contenido, no la variable
+            collect_defs(L, e->as.index_assign.target, off);
+            collect_defs(L, e->as.index_assign.index, off);
+            collect_defs(L, e->as.index_assign.value, off);
+            break;
+        default: break;
+    }
+}
+
+static void collect_defs_stmt(loop_t *L, const stmt *s, int off){
+    if(!s) return;
+    switch(s->kind){
+        case STMT_EXPR:   collect_defs(L, s->as.expr_stmt.value, off); break;
+        case STMT_RETURN: collect_defs(L, s->as.ret.value, off); break;
+        case STMT_BLOCK:
+            for(size_t i=0;i<s->as.block.stmts.count;i++) collect_defs_stmt(L, s->as.block.stmts.items[i], off+1);
+            break;
+        case STMT_IF:
+            collect_defs(L, s->as.if_stmt.cond, off);
+            collect_defs_stmt(L, s->as.if_stmt.then_branch, off);
+            collect_defs_stmt(L, s->as.if_stmt.else_branch, off);
+            break;
+        case STMT_FOR_WHILELIKE:
+            collect_defs(L, s->as.for_while.cond, off);
+            collect_defs_stmt(L, s->as.for_while.body, off);
+            break;
+        case STMT_FOR_CLIKE:
+            collect_defs_stmt(L, s->as.for_clike.init, off);
+            collect_defs(L, s->as.for_clike.cond, off);
+            collect_defs(L, s->as.for_clike.post, off);
+            collect_defs_stmt(L, s->as.for_clike.body, off);
+            break;
+        default: break;
+    }
+}
+
+// ---- invariancia ----
+static bool global_invariant(const loop_t *L, const char *name){
+    for(size_t i=0;i<L->gdefs_count;i++) if(strcmp(L->gdefs[i], name)==0) return false;
+    if(!L->calls) return true;
+    // con llamadas, sólo los globales que nadie asigna por nombre
+    for(size_t i=0;i<L->P->decls.count;i++){
+        const decl *d = L->P->decls.items[i];
+        if(d->kind==DECL_VAR ? assigns_global(d->as.var.init, name)
+                             : assigns_global_stmt(d->as.func.body, name)) return false;
+    }
+    return true;
+}
+
+// Sin llamadas ni asignaciones, y toda variable leída viene de fuera del
+// bucle y no cambia en él. Los operadores no fallan (x/0 da 0), así que
+// evaluar antes o aunque el bucle no itere no cambia nada observable. Un
+// array nunca lo es: su contenido puede cambiar aunque la variable no.
+static bool invariant(const loop_t *L, const expr *e, int off){
+    switch(e->kind){
+        case EXPR_INT_LIT: case EXPR_FLOAT_LIT: case EXPR_BOOL_LIT: case EXPR_STRING_LIT:
+            return true;
+        case EXPR_IDENT:
+            if(type_is_array(e->type)) return false;
+            if(e->as.ident.depth < 0) return global_invariant(L, e->as.ident.name);
+            return e->as.ident.depth >= off
+                && def_count(L, e->as.ident.depth - off, e->as.ident.slot) == 0;
+        case EXPR_UNARY:    return invariant(L, e->as.unary.right, off);
+        case EXPR_BINARY:   return invariant(L, e->as.binary.left, off) && invariant(L, e->as.binary.right, off);
+        case EXPR_GROUPING: return invariant(L, e->as.grouping.inner, off);
+        case EXPR_TERNARY:
+            return invariant(L, e->as.ternary.cond, off)
+                && invariant(L, e->as.ternary.when_true, off)
+                && invariant(L, e->as.ternary.when_false, off);
+        default: return false;
+    }
+}
+
+// Merece un slot: hay cálculo (o una búsqueda de global por nombre).
+static bool worth_hoisting(const expr *e){
+    switch(e->kind){
+        case EXPR_IDENT: return e->as.ident.depth < 0;
+        case EXPR_UNARY: case EXPR_BINARY: case EXPR_TERNARY: case EXPR_GROUPING: return true;
+        default: return false;
+    }
+}
+
+static void rebase(expr *e, int off){
+    switch(e->kind){
+        case EXPR_IDENT: if(e->as.ident.depth >= 0) e->as.ident.depth -= off; break;
+        case EXPR_UNARY:    rebase(e->as.unary.right, off); break;
+        case EXPR_BINARY:   rebase(e->as.binary.left, off); rebase(e->as.binary.right, off); break;
+        case EXPR_GROUPING: rebase(e->as.grouping.inner, off); break;
+        case EXPR_TERNARY:
+            rebase(e->as.ternary.cond, off);
+            rebase(e->as.ternary.when_true, off);
+            rebase(e->as.ternary.when_false, off);
+            break;
+        default: break;
+    }
+}
+
+static bool same_expr(const expr *a, const expr *b){
+    if(a->kind != b->kind || a->type != b->type) return false;
+    switch(a->kind){
+        case EXPR_INT_LIT:   return a->as.int_lit.value == b->as.int_lit.value;
+        case EXPR_FLOAT_LIT: return a->as.float_lit.value == b->as.float_lit.value;
+        case EXPR_BOOL_LIT:  return a->as.bool_lit.value == b->as.bool_lit.value;
+        case EXPR_STRING_LIT: return strcmp(a->as.string_lit.text, b->as.string_lit.text)==0;
+        case EXPR_IDENT:
+            if(a->as.ident.depth != b->as.ident.depth) return false;
+            return a->as.ident.depth < 0 ? strcmp(a->as.ident.name, b->as.ident.name)==0
+                                         : a->as.ident.slot == b->as.ident.slot;
+        case EXPR_UNARY:
+            return a->as.unary.op == b->as.unary.op && same_expr(a->as.unary.right, b->as.unary.right);
+        case EXPR_BINARY:
+            return a->as.binary.op == b->as.binary.op
+                && same_expr(a->as.binary.left, b->as.binary.left)
+                && same_expr(a->as.binary.right, b->as.binary.right);
+        case EXPR_GROUPING: return same_expr(a->as.grouping.inner, b->as.grouping.inner);
+        case EXPR_TERNARY:
+            return same_expr(a->as.ternary.cond, b->as.ternary.cond)
+                && same_expr(a->as.ternary.when_true, b->as.ternary.when_true)
+                && same_expr(a->as.ternary.when_false, b->as.ternary.when_false);
+        default: return false;
+    }
+}
+
+static const char *temp_name(loop_t *L){
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "$t%u", (*L->serial)++);
+    return ast_intern(L->arena, buf, (size_t)n);
+}
+
+static expr *local_ref(loop_t *L, const char *name, int depth, int slot, type_kind t, int line, int col){
+    expr *e = expr_ident(L->arena, name, line, col);
+    e->as.ident.depth = depth; e->as.ident.slot = slot; e->type = t;
+    return e;
+}
+
+static expr *local_assign(loop_t *L, const char *name, int depth, int slot, expr *value){
+    expr *a = expr_assign(L->arena, name, OP_ASSIGN, value, value->line, value->col);
+    a->as.assign.depth = depth; a->as.assign.slot = slot; a->type = value->type;
+    return a;
+}
+
+// Nuevo slot de B con `$tN = value` antes del bucle (value ya rebasado a B).
+static int new_temp(loop_t *L, expr *value, const char **name){
+    int slot = L->outer->as.block.nslots++;
+    *name = temp_name(L);
+    push_pre(L, stmt_expr_stmt(L->arena, local_assign(L, *name, 0, slot, value), value->line, value->col));
+    return slot;
+}
+
+// Sustituye *pe por la lectura de un temporal con su valor; expresiones
+// iguales comparten temporal.
+static void hoist_to_temp(loop_t *L, expr **pe, int off){
+    expr *e = *pe;
+    rebase(e, off);
+    const hoisted *h = NULL;
+    for(size_t i=0;i<L->temps_count && !h;i++)
+        if(same_expr(L->temps[i].src, e)) h = &L->temps[i];
+    if(!h){
+        if(L->temps_count==L->temps_cap){
+            size_t nc=L->temps_cap?L->temps_cap*2u:4u;
+            L->temps=(hoisted*)realloc(L->temps, nc*sizeof(hoisted)); L->temps_cap=nc;
+        }
+        hoisted *n = &L->temps[L->temps_count++];
+        n->src = e;
+        n->slot = new_temp(L, e, &n->name);
+        h = n;
+    }
+    *pe = local_ref(L, h->name, off, h->slot, e->type, e->line, e->col);
+}
+
+static void hoist_stmt(loop_t *L, stmt *s, int off);
+
+static void hoist_expr(loop_t *L, expr **pe, int off){
+    expr *e = *pe;
+    if(!e) return;
+    if(invariant(L, e, off)){
+        if(worth_hoisting(e)) hoist_to_temp(L, pe, off);
+        return;
+    }
+    switch(e->kind){
+        case EXPR_UNARY:    hoist_expr(L, &e->as.unary.right, off); break;
+        case EXPR_BINARY:   hoist_expr(L, &e->as.binary.left, off); hoist_expr(L, &e->as.binary.right, off); break;
+        case EXPR_GROUPING: hoist_expr(L, &e->as.grouping.inner, off); break;
+        case EXPR_TERNARY:
+            hoist_expr(L, &e->as.ternary.cond, off);
+            hoist_expr(L, &e->as.ternary.when_true, off);
+            hoist_expr(L, &e->as.ternary.when_false, off);
+            break;
+        case EXPR_ASSIGN:   hoist_expr(L, &e->as.assign.value, off); break;
+        case EXPR_CALL:
+            for(size_t i=0;i<e->as.call.args.count;i++) hoist_expr(L, &e->as.call.args.items[i], off);
+            break;
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++) hoist_expr(L, &e->as.array.items.items[i], off);
+            break;
+        case EXPR_INDEX:
+            hoist_expr(L, &e->as.index.target, off);
+            hoist_expr(L, &e->as.index.index, off);
+            break;
+        case EXPR_INDEX_ASSIGN:
+            hoist_expr(L, &e->as.index_assign.target, off);
+            hoist_expr(L, &e->as.index_assign.index, off);
+            hoist_expr(L, &e->as.index_assign.value, off);
+            break;
+        default: break;
+    }
+}
+
+static void hoist_stmt(loop_t *L, stmt *s, int off){
+    if(!s) return;
+    switch(s->kind){
+        case STMT_EXPR:   hoist_expr(L, &s->as.expr_stmt.value, off); break;
+        case STMT_RETURN: hoist_expr(L, &s->as.ret.value, off); break;
+        case STMT_BLOCK:
+            for(size_t i=0;i<s->as.block.stmts.count;i++) hoist_stmt(L, s->as.block.stmts.items[i], off+1);
+            break;
+        case STMT_IF:
+            hoist_expr(L, &s->as.if_stmt.cond, off);
+            hoist_stmt(L, s->as.if_stmt.then_branch, off);
+            hoist_stmt(L, s->as.if_stmt.else_branch, off);
+            break;
+        case STMT_FOR_WHILELIKE:
+            hoist_expr(L, &s->as.for_while.cond, off);
+            hoist_stmt(L, s->as.for_while.body, off);
+            break;
+        case STMT_FOR_CLIKE:
+            hoist_stmt(L, s->as.for_clike.init, off);
+            hoist_expr(L, &s->as.for_clike.cond, off);
+            hoist_expr(L, &s->as.for_clike.post, off);
+            hoist_stmt(L, s->as.for_clike.body, off);
+            break;
+        default: break;
+    }
+}
+
+// ---- reducción de fuerza ----
+// Variable de inducción: int de fuera del bucle cuya única asignación en él
+// es `i = i ± c`, `i += c` o `i -= c`. Cada `i * k` (k literal o invariante)
+// pasa a un temporal que se inicializa antes del bucle y suma c*k justo
+// después de cada paso de i.
+typedef struct {
+    bool lit; long long k; var_ref kv; // factor: literal o local de B
+    const char *name; int slot;        // temporal con i*k
+} derived;
+
+typedef struct {
+    var_ref v; const char *name; long long step;
+    derived *ds; size_t ds_count, ds_cap;
+    stmt **updates; size_t updates_count, updates_cap;
+} induction;
+
+static bool is_var(const expr *e, int depth, int slot){
+    return e->kind==EXPR_IDENT && e->as.ident.depth==depth && e->as.ident.slot==slot;
+}
+
+static bool induction_step(const expr *u, long long *step){
+    if(!u || u->kind != EXPR_ASSIGN || u->as.assign.depth < 0 || u->type != TYPE_INT) return false;
+    const expr *val = u->as.assign.value;
+    int d = u->as.assign.depth, s = u->as.assign.slot;
+    switch(u->as.assign.op){
+        case OP_PLUS_ASSIGN: case OP_MINUS_ASSIGN:
+            if(val->kind != EXPR_INT_LIT) return false;
+            *step = u->as.assign.op==OP_PLUS_ASSIGN ? val->as.int_lit.value : -val->as.int_lit.value;
+            return true;
+        case OP_ASSIGN:
+            if(val->kind != EXPR_BINARY) return false;
+            if(val->as.binary.op == OP_ADD && val->as.binary.left->kind == EXPR_INT_LIT && is_var(val->as.binary.right, d, s)){
+                *step = val->as.binary.left->as.int_lit.value;
+                return true;
+            }
+            if((val->as.binary.op == OP_ADD || val->as.binary.op == OP_SUB)
+               && is_var(val->as.binary.left, d, s) && val->as.binary.right->kind == EXPR_INT_LIT){
+                *step = val->as.binary.op==OP_ADD ? val->as.binary.right->as.int_lit.value
+                                                  : -val->as.binary.right->as.int_lit.value;
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+// `continue` de este bucle (no de uno anidado)
+static bool has_continue(const stmt *s){
+    if(!s) return false;
+    switch(s->kind){
+        case STMT_CONTINUE: return true;
+        case STMT_BLOCK:
+            for(size_t i=0;i<s->as.block.stmts.count;i++)
+                if(has_continue(s->as.block.stmts.items[i])) return true;
+            return false;
+        case STMT_IF:
+            return has_continue(s->as.if_stmt.then_branch) || has_continue(s->as.if_stmt.else_branch);
+        default: return false;
+    }
+}
+
+static bool is_int_lit(const expr *e, long long v){ return e->kind == EXPR_INT_LIT && e->as.int_lit.value == v; }
+
+// x * 1, 1 * x, x + 0 y 0 + x quedan en x: la reescritura no debe dejar
+// multiplicaciones que el bucle vuelva a pagar.
+static expr *int_identity(expr *e){
+    if(e->kind != EXPR_BINARY) return e;
+    expr *l = e->as.binary.left, *r = e->as.binary.right;
+    switch(e->as.binary.op){
+        case OP_MUL:
+            if(is_int_lit(r, 1)) return l;
+            if(is_int_lit(l, 1)) return r;
+            break;
+        case OP_ADD:
+            if(is_int_lit(r, 0)) return l;
+            if(is_int_lit(l, 0)) return r;
+            break;
+        default: break;
+    }
+    return e;
+}
+
+static derived *derived_for(loop_t *L, induction *iv, const expr *k, int off){
+    bool lit = k->kind == EXPR_INT_LIT;
+    var_ref kv = { lit ? 0 : k->as.ident.depth - off, lit ? 0 : k->as.ident.slot };
+    for(size_t i=0;i<iv->ds_count;i++){
+        derived *d = &iv->ds[i];
+        if(d->lit != lit) continue;
+        if(lit ? d->k == k->as.int_lit.value : (d->kv.depth == kv.depth && d->kv.slot == kv.slot)) return d;
+    }
+    if(iv->ds_count==iv->ds_cap){
+        size_t nc=iv->ds_cap?iv->ds_cap*2u:4u;
+        iv->ds=(derived*)realloc(iv->ds, nc*sizeof(derived)); iv->ds_cap=nc;
+    }
+    derived *d = &iv->ds[iv->ds_count++];
+    d->lit = lit; d->k = lit ? k->as.int_lit.value : 0; d->kv = kv;
+
+    // antes del bucle: $t = i * k (y el paso c*k si k no es literal)
+    int line = k->line, col = k->col;
+    expr *kb = lit ? expr_int(L->arena, d->k, line, col)
+                   : local_ref(L, k->as.ident.name, kv.depth, kv.slot, TYPE_INT, line, col);
+    kb->type = TYPE_INT;
+    expr *init = expr_binary(L->arena, local_ref(L, iv->name, iv->v.depth, iv->v.slot, TYPE_INT, line, col), OP_MUL, kb, line, col);
+    init->type = TYPE_INT;
+    d->slot = new_temp(L, int_identity(init), &d->name);
+    push_def(L, 0, d->slot);
+
+    expr *step;
+    if(lit){
+        step = expr_int(L->arena, iv->step * d->k, line, col);
+    } else if(iv->step == 1){
+        // k * 1: se suma k directamente (un bloque por debajo de B)
+        step = local_ref(L, k->as.ident.name, kv.depth + 1, kv.slot, TYPE_INT, line, col);
+    } else {
+        expr *sk = expr_binary(L->arena, local_ref(L, k->as.ident.name, kv.depth, kv.slot, TYPE_INT, line, col),
+                               OP_MUL, expr_int(L->arena, iv->step, line, col), line, col);
+        sk->type = TYPE_INT; sk->as.binary.right->type = TYPE_INT;
+        const char *sname; int sslot = new_temp(L, sk, &sname);
+        step = local_ref(L, sname, 1, sslot, TYPE_INT, line, col);
+    }
+    step->type = TYPE_INT;
+    // en el cuerpo (un bloque por debajo de B): $t = $t + paso
+    expr *sum = expr_binary(L->arena, local_ref(L, d->name, 1, d->slot, TYPE_INT, line, col), OP_ADD, step, line, col);
+    sum->type = TYPE_INT;
+    if(int_identity(sum) != sum) return d; // paso 0 (k == 0): $t no cambia
+    stmt *up = stmt_expr_stmt(L->arena, local_assign(L, d->name, 1, d->slot, sum), line, col);
+    if(iv->updates_count==iv->updates_cap){
+        size_t nc=iv->updates_cap?iv->updates_cap*2u:4u;
+        iv->updates=(stmt**)realloc(iv->updates, nc*sizeof(stmt*)); iv->updates_cap=nc;
+    }
+    iv->updates[iv->updates_count++] = up;
+    return d;
+}
+
+static void reduce_stmt(loop_t *L, induction *iv, stmt *s, int off);
+
+static void reduce_expr(loop_t *L, induction *iv, expr **pe, int off){
+    expr *e = *pe;
+    if(!e) return;
+    switch(e->kind){
+        case EXPR_BINARY: {
+            reduce_expr(L, iv, &e->as.binary.left, off);
+            reduce_expr(L, iv, &e->as.binary.right, off);
+            if(e->as.binary.op != OP_MUL || e->type != TYPE_INT) return;
+            int d = iv->v.depth + off, s = iv->v.slot;
+            const expr *k = is_var(e->as.binary.left, d, s) ? e->as.binary.right
+                          : is_var(e->as.binary.right, d, s) ? e->as.binary.left : NULL;
+            if(!k || k->type != TYPE_INT) return;
+            if(k->kind != EXPR_INT_LIT
+               && !(k->kind == EXPR_IDENT && k->as.ident.depth >= off && invariant(L, k, off))) return;
+            derived *dv = derived_for(L, iv, k, off);
+            *pe = local_ref(L, dv->name, off, dv->slot, TYPE_INT, e->line, e->col);
+            return;
+        }
+        case EXPR_UNARY:    reduce_expr(L, iv, &e->as.unary.right, off); break;
+        case EXPR_GROUPING: reduce_expr(L, iv, &e->as.grouping.inner, off); break;
+        case EXPR_TERNARY:
+            reduce_expr(L, iv, &e->as.ternary.cond, off);
+            reduce_expr(L, iv, &e->as.ternary.when_true, off);
+            reduce_expr(L, iv, &e->as.ternary.when_false, off);
+            break;
+        case EXPR_ASSIGN:   reduce_expr(L, iv, &e->as.assign.value, off); break;
+        case EXPR_CALL:
+            for(size_t i=0;i<e->as.call.args.count;i++) reduce_expr(L, iv, &e->as.call.args.items[i], off);
+            break;
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++) reduce_expr(L, iv, &e->as.array.items.items[i], off);
+            break;
+        case EXPR_INDEX:
+            reduce_expr(L, iv, &e->as.index.target, off);
+            reduce_expr(L, iv, &e->as.index.index, off);
+            break;
+        case EXPR_INDEX_ASSIGN:
+            reduce_expr(L, iv, &e->as.index_assign.target, off);
+            reduce_expr(L, iv, &e->as.index_assign.index, off);
+            reduce_expr(L, iv, &e->as.index_assign.value, off);
+            break;
+        default: break;
+    }
+}
+
+static void reduce_stmt(loop_t *L, induction *iv, stmt *s, int off){
+    if(!s) return;
+    switch(s->kind){
+        case STMT_EXPR:   reduce_expr(L, iv, &s->as.expr_stmt.value, off); break;
+        case STMT_RETURN: reduce_expr(L, iv, &s->as.ret.value, off); break;
+        case STMT_BLOCK:
+            for(size_t i=0;i<s->as.block.stmts.count;i++) reduce_stmt(L, iv, s->as.block.stmts.items[i], off+1);
+            break;
+        case STMT_IF:
+            reduce_expr(L, iv, &s->as.if_stmt.cond, off);
+            reduce_stmt(L, iv, s->as.if_stmt.then_branch, off);
+            reduce_stmt(L, iv, s->as.if_stmt.else_branch, off);
+            break;
+        case STMT_FOR_WHILELIKE:
+            reduce_expr(L, iv, &s->as.for_while.cond, off);
+            reduce_stmt(L, iv, s->as.for_while.body, off);
+            break;
+        case STMT_FOR_CLIKE:
+            reduce_stmt(L, iv, s->as.for_clike.init, off);
+            reduce_expr(L, iv, &s->as.for_clike.cond, off);
+            reduce_expr(L, iv, &s->as.for_clike.post, off);
+            reduce_stmt(L, iv, s->as.for_clike.body, off);
+            break;
+        default: break;
+    }
+}
+
+// Inserta n sentencias en el bloque b a partir de la posición at.
+static void insert_stmts(ast_arena *a, stmt *b, size_t at, stmt **src, size_t n){
+    stmt_vec *v = &b->as.block.stmts;
+    stmt **items = (stmt**)ast_arena_alloc(a, (v->count + n) * sizeof(stmt*));
+    memcpy(items, v->items, at * sizeof(stmt*));
+    memcpy(items + at, src, n * sizeof(stmt*));
+    memcpy(items + at + n, v->items + at, (v->count - at) * sizeof(stmt*));
+    v->items = items; v->count += n; v->cap = v->count;
+}
+
+static void reduce_loop(loop_t *L, stmt *loop){
+    bool clike = loop->kind == STMT_FOR_CLIKE;
+    expr *post = clike ? loop->as.for_clike.post : NULL;
+    stmt *body = clike ? loop->as.for_clike.body : loop->as.for_while.body;
+    // j < 0: el paso está en el post (sus actualizaciones van al final del
+    // cuerpo, así que no puede haber `continue`); si no, es la sentencia j del cuerpo
+    for(long j = -1; j < (long)body->as.block.stmts.count; j++){
+        expr *u; int off;
+        if(j < 0){
+            if(!post || has_continue(body)) continue;
+            u = post; off = 0;
+        } else {
+            stmt *s = body->as.block.stmts.items[j];
+            if(s->kind != STMT_EXPR) continue;
+            u = s->as.expr_stmt.value; off = 1;
+        }
+        induction iv;
+        memset(&iv, 0, sizeof(iv));
+        if(!induction_step(u, &iv.step) || u->as.assign.depth < off) continue;
+        iv.v.depth = u->as.assign.depth - off; iv.v.slot = u->as.assign.slot; iv.name = u->as.assign.name;
+        if(def_count(L, iv.v.depth, iv.v.slot) != 1) continue;
+
+        reduce_expr(L, &iv, clike ? &loop->as.for_clike.cond : &loop->as.for_while.cond, 0);
+        if(post) reduce_expr(L, &iv, &loop->as.for_clike.post, 0);
+        reduce_stmt(L, &iv, body, 0);
+        if(iv.updates_count){
+            size_t at = j < 0 ? body->as.block.stmts.count : (size_t)j + 1u;
+            insert_stmts(L->arena, body, at, iv.updates, iv.updates_count);
+            if(j >= 0) j += (long)iv.updates_count;
+        }
+        free(iv.ds); free(iv.updates);
+    }
+}
+
+// Optimiza el bucle B[idx]; devuelve cuántas sentencias se insertaron antes.
+static size_t optimize_loop(const program_ast *P, unsigned *serial, stmt *B, size_t idx){
+    stmt *s = B->as.block.stmts.items[idx];
+    loop_t L;
+    memset(&L, 0, sizeof(L));
+    L.P = P; L.arena = P->arena; L.outer = B; L.serial = serial;
+
+    if(s->kind == STMT_FOR_CLIKE){
+        // el init se saca delante de los temporales: no cuenta como del bucle
+        collect_defs(&L, s->as.for_clike.cond, 0);
+        collect_defs(&L, s->as.for_clike.post, 0);
+        collect_defs_stmt(&L, s->as.for_clike.body, 0);
+        hoist_expr(&L, &s->as.for_clike.cond, 0);
+        hoist_expr(&L, &s->as.for_clike.post, 0);
+        hoist_stmt(&L, s->as.for_clike.body, 0);
+    } else {
+        collect_defs(&L, s->as.for_while.cond, 0);
+        collect_defs_stmt(&L, s->as.for_while.body, 0);
+        hoist_expr(&L, &s->as.for_while.cond, 0);
+        hoist_stmt(&L, s->as.for_while.body, 0);
+    }
+    reduce_loop(&L, s);
+
+    size_t n = 0;
+    if(L.pre_count){
+        if(s->kind == STMT_FOR_CLIKE && s->as.for_clike.init){
+            push_pre(&L, NULL);
+            memmove(L.pre + 1, L.pre, (L.pre_count - 1) * sizeof(stmt*));
+            L.pre[0] = s->as.for_clike.init;
+            s->as.for_clike.init = NULL;
+        }
+        insert_stmts(L.arena, B, idx, L.pre, L.pre_count);
+        n = L.pre_count;
+    }
+    free(L.defs); free(L.gdefs); free(L.temps); free(L.pre);
+    return n;
+}
+
+static void licm_stmt(const program_ast *P, unsigned *serial, stmt *s){
+    if(!s) return;
+    switch(s->kind){
+        case STMT_BLOCK:
+            for(size_t i=0;i<s->as.block.stmts.count;i++){
+                stmt *c = s->as.block.stmts.items[i];
+                licm_stmt(P, serial, c); // primero los bucles interiores
+                if(c->kind == STMT_FOR_CLIKE || c->kind == STMT_FOR_WHILELIKE)
+                    i += optimize_loop(P, serial, s, i);
+            }
+            break;
+        case STMT_IF:
+            licm_stmt(P, serial, s->as.if_stmt.then_branch);
+            licm_stmt(P, serial, s->as.if_stmt.else_branch);
+            break;
+        case STMT_FOR_WHILELIKE: licm_stmt(P, serial, s->as.for_while.body); break;
+        case STMT_FOR_CLIKE:     licm_stmt(P, serial, s->as.for_clike.body); break;
+        default: break;
+    }
+}
+
+void optimize_program(program_ast *P){
+    if(!P) return;
+    folder_t f;
+    memset(&f, 0, sizeof(f));
+    f.arena = P->arena;
+
+    // Globales en orden de declaración. Un const sólo es visible para las
+    // funciones si ningún inicializador anterior llama a una función (que
+    // podría leerlo antes de que exista).
+    bool call_seen = false;
+    for(size_t i=0;i<P->decls.count;i++){
+        decl *d = P->decls.items[i];
+        if(d->kind != DECL_VAR) continue;
+        f.decl_index = i;
+        d->as.var.init = fold_expr(&f, d->as.var.init);
+        if(has_call(d->as.var.init)) call_seen = true;
+        if(d->as.var.is_const && d->as.var.init && is_literal(d->as.var.init) && propagatable(P, i))
+            add_const(&f, d->as.var.name, d->as.var.init, i, !call_seen);
+    }
+
+    f.in_func = true;
+    for(size_t i=0;i<P->decls.count;i++){
+        decl *d = P->decls.items[i];
+        if(d->kind == DECL_FUNC) fold_stmt(&f, d->as.func.body);
+    }
+    free(f.consts);
+
+    unsigned serial = 0;
+    for(size_t i=0;i<P->decls.count;i++){
+        decl *d = P->decls.items[i];
+        if(d->kind == DECL_FUNC) licm_stmt(P, &serial, d->as.func.body);
+    }
+}
+
+// ---------------- inlining ----------------
+// Funciones candidatas: cuerpo `{ return <expr>; }` sin asignaciones, de a lo
+// sumo CELER_INLINE_MAX_NODES nodos, que no se llaman a sí mismas, con nombre
+// único y no tapadas por un builtin. Los parámetros (depth 1 dentro del
+// cuerpo) se sustituyen por copias de los argumentos, o por un temporal del
+// bloque llamador cuando el argumento no es trivial y se usa varias veces.
+typedef struct {
+    const program_ast *P;
+    env_t *global;
+    stmt *block;        // bloque de la sentencia en curso (NULL en globales)
+    unsigned serial;    // nombres únicos de temporales
+} inliner_t;
+
+static size_t expr_size(const expr *e){
+    if(!e) return 0;
+    switch(e->kind){
+        case EXPR_UNARY:    return 1 + expr_size(e->as.unary.right);
+        case EXPR_BINARY:   return 1 + expr_size(e->as.binary.left) + expr_size(e->as.binary.right);
+        case EXPR_GROUPING: return expr_size(e->as.grouping.inner);
+        case EXPR_TERNARY:
+            return 1 + expr_size(e->as.ternary.cond) + expr_size(e->as.ternary.when_true)
+                     + expr_size(e->as.ternary.when_false);
+        case EXPR_ASSIGN:   return 1 + expr_size(e->as.assign.value);
+        case EXPR_CALL: {
+            size_t n = 1;
+            for(size_t i=0;i<e->as.call.args.count;i++) n += expr_size(e->as.call.args.items[i]);
+            return n;
+        }
+        case EXPR_ARRAY: {
+            size_t n = 1;
+            for(size_t i=0;i<e->as.array.items.count;i++) n += expr_size(e->as.array.items.items[i]);
+            return n;
+        }
+        case EXPR_INDEX:    return 1 + expr_size(e->as.index.target) + expr_size(e->as.index.index);
+        case EXPR_INDEX_ASSIGN:
+            return 1 + expr_size(e->as.index_assign.target) + expr_size(e->as.index_assign.index)
+                     + expr_size(e->as.index_assign.value);
+        default: return 1;
+    }
+}
+
+static bool calls_name(const expr *e, const char *name){
+    if(!e) return false;
+    switch(e->kind){
+        case EXPR_CALL:
+            if(e->as.call.callee->kind == EXPR_IDENT && strcmp(e->as.call.callee->as.ident.name, name)==0) return true;
+            for(size_t i=0;i<e->as.call.args.count;i++)
+                if(calls_name(e->as.call.args.items[i], name)) return true;
+            return false;
+        case EXPR_ASSIGN:   return calls_name(e->as.assign.value, name);
+        case EXPR_UNARY:    return calls_name(e->as.unary.right, name);
+        case EXPR_BINARY:   return calls_name(e->as.binary.left, name) || calls_name(e->as.binary.right, name);
+        case EXPR_GROUPING: return calls_name(e->as.grouping.inner, name);
+        case EXPR_TERNARY:
+            return calls_name(e->as.ternary.cond, name) || calls_name(e->as.ternary.when_true, name)
+                || calls_name(e->as.ternary.when_false, name);
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++)
+                if(calls_name(e->as.array.items.items[i], name)) return true;
+            return false;
+        case EXPR_INDEX:    return calls_name(e->as.index.target, name) || calls_name(e->as.index.index, name);
+        case EXPR_INDEX_ASSIGN:
+            return calls_name(e->as.index_assign.target, name) || calls_name(e->as.index_assign.index, name)
+                || calls_name(e->as.index_assign.value, name);
+        default: return false;
+    }
+}
+
+static bool has_assign(const expr *e){
+    if(!e) return false;
+    switch(e->kind){
+        case EXPR_ASSIGN: case EXPR_INDEX_ASSIGN: return true;
+        case EXPR_UNARY:    return has_assign(e->as.unary.right);
+        case EXPR_BINARY:   return has_assign(e->as.binary.left) || has_assign(e->as.binary.right);
+        case EXPR_GROUPING: return has_assign(e->as.grouping.inner);
+        case EXPR_TERNARY:
+            return has_assign(e->as.ternary.cond) || has_assign(e->as.ternary.when_true)
+                || has_assign(e->as.ternary.when_false);
+        case EXPR_CALL:
+            for(size_t i=0;i<e->as.call.args.count;i++)
+                if(has_assign(e->as.call.args.items[i])) return true;
+            return false;
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++)
+                if(has_assign(e->as.array.items.items[i])) return true;
+            return false;
+        case EXPR_INDEX:    return has_assign(e->as.index.target) || has_assign(e->as.index.index);
+        default: return false;
+    }
+}
+
+static bool reads_global(const expr *e){
+    if(!e) return false;
+    switch(e->kind){
+        case EXPR_IDENT:    return e->as.ident.depth < 0;
+        case EXPR_INDEX:    return true; // memoria que una llamada puede cambiar
+        case EXPR_UNARY:    return reads_global(e->as.unary.right);
+        case EXPR_BINARY:   return reads_global(e->as.binary.left) || reads_global(e->as.binary.right);
+        case EXPR_GROUPING: return reads_global(e->as.grouping.inner);
+        case EXPR_TERNARY:
+            return reads_global(e->as.ternary.cond) || reads_global(e->as.ternary.when_true)
+                || reads_global(e->as.ternary.when_false);
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++)
+                if(reads_global(e->as.array.items.items[i])) return true;
+            return false;
+        default: return false;
+    }
+}
+
+// a[i] puede fallar (índice fuera de rango): como argumento se trata igual
+// que una llamada, que tiene que evaluarse siempre y antes que el resto.
+static bool has_index(const expr *e){
+    if(!e) return false;
+    switch(e->kind){
+        case EXPR_INDEX:    return true;
+        case EXPR_UNARY:    return has_index(e->as.unary.right);
+        case EXPR_BINARY:   return has_index(e->as.binary.left) || has_index(e->as.binary.right);
+        case EXPR_GROUPING: return has_index(e->as.grouping.inner);
+        case EXPR_TERNARY:
+            return has_index(e->as.ternary.cond) || has_index(e->as.ternary.when_true)
+                || has_index(e->as.ternary.when_false);
+        case EXPR_CALL:
+            for(size_t i=0;i<e->as.call.args.count;i++)
+                if(has_index(e->as.call.args.items[i])) return true;
+            return false;
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++)
+                if(has_index(e->as.array.items.items[i])) return true;
+            return false;
+        default: return false;
+    }
+}
+
+static int param_uses(const expr *e, int slot){
+    if(!e) return 0;
+    switch(e->kind){
+        case EXPR_IDENT:    return e->as.ident.depth == 1 && e->as.ident.slot == slot;
+        case EXPR_UNARY:    return param_uses(e->as.unary.right, slot);
+        case EXPR_BINARY:   return param_uses(e->as.binary.left, slot) + param_uses(e->as.binary.right, slot);
+        case EXPR_GROUPING: return param_uses(e->as.grouping.inner, slot);
+        case EXPR_TERNARY:
+            return param_uses(e->as.ternary.cond, slot) + param_uses(e->as.ternary.when_true, slot)
+                 + param_uses(e->as.ternary.when_false, slot);
+        case EXPR_CALL: {
+            int n = 0;
+            for(size_t i=0;i<e->as.call.args.count;i++) n += param_uses(e->as.call.args.items[i], slot);
+            return n;
+        }
+        case EXPR_ARRAY: {
+            int n = 0;
+            for(size_t i=0;i<e->as.array.items.count;i++) n += param_uses(e->as.array.items.items[i], slot);
+            return n;
+        }
+        case EXPR_INDEX:    return param_uses(e->as.index.target, slot) + param_uses(e->as.index.index, slot);
+        default: return 0;
+    }
+}
+
+// Declaración de `name` si sus llamadas se pueden expandir; NULL si no.
+static const func_decl *inline_target(const inliner_t *in, const char *name){
+    const func_decl *fn = NULL;
+    for(size_t i=0;i<in->P->decls.count;i++){
+        const decl *d = in->P->decls.items[i];
+        if(d->kind != DECL_FUNC || strcmp(d->as.func.name, name) != 0) continue;
+        if(fn) return NULL; // redefinida: gana la última en tiempo de ejecución
+        fn = &d->as.func;
+    }
+    if(!fn || (in->global && env_get_builtin(in->global, name))) return NULL;
+    const stmt *b = fn->body;
+    if(!b || b->as.block.stmts.count != 1 || b->as.block.nslots != 0) return NULL;
+    const stmt *r = b->as.block.stmts.items[0];
+    if(r->kind != STMT_RETURN || !r->as.ret.value) return NULL;
+    const expr *body = r->as.ret.value;
+    if(expr_size(body) > CELER_INLINE_MAX_NODES || has_assign(body) || calls_name(body, name)) return NULL;
+    return fn;
+}
+
+// Primer uso del parámetro en orden de evaluación: 1 si se evalúa siempre,
+// 0 si está bajo un `&&`/`||` o una rama de ternario, -1 si no se usa.
+static int first_use(const expr *e, int slot, bool cond){
+    if(!e) return -1;
+    int r;
+    switch(e->kind){
+        case EXPR_IDENT:
+            return (e->as.ident.depth == 1 && e->as.ident.slot == slot) ? !cond : -1;
+        case EXPR_UNARY:    return first_use(e->as.unary.right, slot, cond);
+        case EXPR_GROUPING: return first_use(e->as.grouping.inner, slot, cond);
+        case EXPR_BINARY: {
+            if((r = first_use(e->as.binary.left, slot, cond)) >= 0) return r;
+            bool sc = e->as.binary.op == OP_AND || e->as.binary.op == OP_OR;
+            return first_use(e->as.binary.right, slot, cond || sc);
+        }
+        case EXPR_TERNARY:
+            if((r = first_use(e->as.ternary.cond, slot, cond)) >= 0) return r;
+            if((r = first_use(e->as.ternary.when_true, slot, true)) >= 0) return r;
+            return first_use(e->as.ternary.when_false, slot, true);
+        case EXPR_CALL:
+            for(size_t i=0;i<e->as.call.args.count;i++)
+                if((r = first_use(e->as.call.args.items[i], slot, cond)) >= 0) return r;
+            return -1;
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++)
+                if((r = first_use(e->as.array.items.items[i], slot, cond)) >= 0) return r;
+            return -1;
+        case EXPR_INDEX:
+            if((r = first_use(e->as.index.target, slot, cond)) >= 0) return r;
+            return first_use(e->as.index.index, slot, cond);
+        default: return -1;
+    }
+}
+
+// Sustitución de un parámetro: copia del argumento o, si se usa varias
+// veces, `$aN = arg` en el primer uso y `$aN` en los demás.
+typedef struct {
+    expr *arg;
+    const char *name; int slot; // slot < 0: copia directa
+    bool bound;
+} inline_arg;
+
+// Copia de e con los parámetros sustituidos. Los hijos se copian en orden de
+// evaluación para que el primer uso sea el que asigna el temporal.
+static expr *clone_inline(ast_arena *a, const expr *e, inline_arg *args){
+    expr *out = NULL, *l, *r;
+    switch(e->kind){
+        case EXPR_IDENT:
+            if(args && e->as.ident.depth == 1){
+                inline_arg *p = &args[e->as.ident.slot];
+                if(p->slot < 0) return clone_inline(a, p->arg, NULL);
+                out = p->bound ? expr_ident(a, p->name, e->line, e->col)
+                               : expr_assign(a, p->name, OP_ASSIGN, clone_inline(a, p->arg, NULL), e->line, e->col);
+                if(p->bound){ out->as.ident.depth = 0; out->as.ident.slot = p->slot; }
+                else { out->as.assign.depth = 0; out->as.assign.slot = p->slot; }
+                p->bound = true;
+                out->type = p->arg->type;
+                return out;
+            }
+            out = expr_ident(a, e->as.ident.name, e->line, e->col);
+            out->as.ident.depth = e->as.ident.depth; out->as.ident.slot = e->as.ident.slot;
+            break;
+        case EXPR_INT_LIT:    out = expr_int(a, e->as.int_lit.value, e->line, e->col); break;
+        case EXPR_FLOAT_LIT:  out = expr_float(a, e->as.float_lit.value, e->line, e->col); break;
+        case EXPR_BOOL_LIT:   out = expr_bool(a, e->as.bool_lit.value, e->line, e->col); break;
+        case EXPR_STRING_LIT: out = expr_string(a, e->as.string_lit.text, e->line, e->col); break;
+        case EXPR_UNARY:
+            out = expr_unary(a, e->as.unary.op, clone_inline(a, e->as.unary.right, args), e->line, e->col);
+            break;
+        case EXPR_BINARY:
+            l = clone_inline(a, e->as.binary.left, args);
+            r = clone_inline(a, e->as.binary.right, args);
+            out = expr_binary(a, l, e->as.binary.op, r, e->line, e->col);
+            break;
+        case EXPR_GROUPING:
+            out = expr_group(a, clone_inline(a, e->as.grouping.inner, args), e->line, e->col);
+            break;
+        case EXPR_TERNARY: {
+            expr *c = clone_inline(a, e->as.ternary.cond, args);
+            l = clone_inline(a, e->as.ternary.when_true, args);
+            r = clone_inline(a, e->as.ternary.when_false, args);
+            out = expr_ternary(a, c, l, r, e->line, e->col);
+            break;
+        }
+        case EXPR_CALL:
+            out = expr_call(a, clone_inline(a, e->as.call.callee, NULL), e->line, e->col);
+            for(size_t i=0;i<e->as.call.args.count;i++)
+                expr_args_push(a, out, clone_inline(a, e->as.call.args.items[i], args));
+            break;
+        case EXPR_ARRAY:
+            out = expr_array(a, e->line, e->col);
+            for(size_t i=0;i<e->as.array.items.count;i++)
+                expr_array_push(a, out, clone_inline(a, e->as.array.items.items[i], args));
+            break;
+        case EXPR_INDEX:
+            l = clone_inline(a, e->as.index.target, args);
+            r = clone_inline(a, e->as.index.index, args);
+            out = expr_index(a, l, r, e->line, e->col);
+            break;
+        default: return NULL; // asignaciones: excluidas por inline_target
+    }
+    out->type = e->type;
+    return out;
+}
+
+static bool trivial_arg(const expr *e){
+    return is_literal(e) || (e->kind == EXPR_IDENT && e->as.ident.depth >= 0);
+}
+
+static void inline_expr(inliner_t *in, expr **pe){
+    expr *e = *pe;
+    if(!e) return;
+    switch(e->kind){
+        case EXPR_UNARY:    inline_expr(in, &e->as.unary.right); return;
+        case EXPR_BINARY:   inline_expr(in, &e->as.binary.left); inline_expr(in, &e->as.binary.right); return;
+        case EXPR_GROUPING: inline_expr(in, &e->as.grouping.inner); return;
+        case EXPR_TERNARY:
+            inline_expr(in, &e->as.ternary.cond);
+            inline_expr(in, &e->as.ternary.when_true);
+            inline_expr(in, &e->as.ternary.when_false);
+            return;
+        case EXPR_ASSIGN:   inline_expr(in, &e->as.assign.value); return;
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++) inline_expr(in, &e->as.array.items.items[i]);
+            return;
+        case EXPR_INDEX:    inline_expr(in, &e->as.index.target); inline_expr(in, &e->as.index.index); return;
+        case EXPR_INDEX_ASSIGN:
+            inline_expr(in, &e->as.index_assign.target);
+            inline_expr(in, &e->as.index_assign.index);
+            inline_expr(in, &e->as.index_assign.value);
+            return;
+        case EXPR_CALL:     break;
+        default: return;
+    }
+    // los argumentos primero: add(add(1, 2), 3) se expande entero
+    for(size_t i=0;i<e->as.call.args.count;i++) inline_expr(in, &e->as.call.args.items[i]);
+    if(e->as.call.callee->kind != EXPR_IDENT) return;
+    const func_decl *fn = inline_target(in, e->as.call.callee->as.ident.name);
+    size_t argc = e->as.call.args.count;
+    if(!fn || fn->params.count != argc) return;
+    const expr *body = fn->body->as.block.stmts.items[0]->as.ret.value;
+    // el tipo del resultado no puede empeorar: los kernels del padre confían en él
+    if(e->type != TYPE_UNKNOWN && body->type != e->type) return;
+
+    // Cada argumento se evalúa una vez y antes del cuerpo. Sin efectos, el
+    // orden da igual salvo para globales que el cuerpo pueda cambiar con una
+    // llamada. Uno con llamadas se admite sólo si el cuerpo no llama ni lee
+    // globales, ningún otro argumento lee globales y su primer uso es seguro.
+    bool body_calls = has_call(body);
+    int effectful = -1;
+    for(size_t i=0;i<argc;i++){
+        const expr *arg = e->as.call.args.items[i];
+        int uses = param_uses(body, (int)i);
+        if(has_assign(arg)) return;
+        if(has_call(arg) || has_index(arg)){
+            if(effectful >= 0 || body_calls || reads_global(body) || first_use(body, (int)i, false) != 1) return;
+            effectful = (int)i;
+        } else if(body_calls && reads_global(arg)){
+            return;
+        }
+        if(uses > 1 && !trivial_arg(arg) && (!in->block || first_use(body, (int)i, false) != 1)) return;
+    }
+    if(effectful >= 0){
+        for(size_t i=0;i<argc;i++)
+            if((int)i != effectful && reads_global(e->as.call.args.items[i])) return;
+    }
+
+    inline_arg *args = (inline_arg*)calloc(argc ? argc : 1u, sizeof(inline_arg));
+    for(size_t i=0;i<argc;i++){
+        expr *arg = e->as.call.args.items[i];
+        args[i].arg = arg;
+        args[i].slot = -1;
+        if(param_uses(body, (int)i) > 1 && !trivial_arg(arg)){
+            char buf[32];
+            int n = snprintf(buf, sizeof(buf), "$a%u", in->serial++);
+            args[i].name = ast_intern(in->P->arena, buf, (size_t)n);
+            args[i].slot = in->block->as.block.nslots++;
+        }
+    }
+    *pe = clone_inline(in->P->arena, body, args);
+    free(args);
+}
+
+static void inline_stmt(inliner_t *in, stmt *s){
+    if(!s) return;
+    switch(s->kind){
+        case STMT_EXPR:   inline_expr(in, &s->as.expr_stmt.value); break;
+        case STMT_RETURN: inline_expr(in, &s->as.ret.value); break;
+        case STMT_BLOCK: {
+            stmt *outer = in->block;
+            in->block = s;
+            for(size_t i=0;i<s->as.block.stmts.count;i++) inline_stmt(in, s->as.block.stmts.items[i]);
+            in->block = outer;
+            break;
+        }
+        case STMT_IF:
+            inline_expr(in, &s->as.if_stmt.cond);
+            inline_stmt(in, s->as.if_stmt.then_branch);
+            inline_stmt(in, s->as.if_stmt.else_branch);
+            break;
+        case STMT_FOR_WHILELIKE:
+            inline_expr(in, &s->as.for_while.cond);
+            inline_stmt(in, s->as.for_while.body);
+            break;
+        case STMT_FOR_CLIKE:
+            inline_stmt(in, s->as.for_clike.init);
+            inline_expr(in, &s->as.for_clike.cond);
+            inline_expr(in, &s->as.for_clike.post);
+            inline_stmt(in, s->as.for_clike.body);
+            break;
+        default: break;
+    }
+}
+
+void inline_program(program_ast *P, env_t *global){
+    if(!P) return;
+    inliner_t in = { P, global, NULL, 0 };
+    for(size_t i=0;i<P->decls.count;i++){
+        decl *d = P->decls.items[i];
+        if(d->kind == DECL_VAR) inline_expr(&in, &d->as.var.init);
+        else inline_stmt(&in, d->as.func.body);
+    }
+}
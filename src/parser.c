@@ -16,12 +16,55 @@ static void perr_push(parse_error_list *lst, int line, int col, const char *msg)
     lst->count++;
 }
 
+// --- unescape de string literal de Celer ("...") ---
+static char *unescape_celer_string(const char *lex, size_t n) {
+    // asume que lex viene como: "contenido con \n \t \\ \" "
+    if(!lex) return NULL;
+    size_t start = 0, end = n;
+    if(n >= 2 && lex[0] == '\"' && lex[n-1] == '\"') { start = 1; end = n-1; }
+
+    // tamaño máximo igual al contenido (escapes reducen o igualan)
+    char *out = (char*)malloc((end - start) + 1);
+    if(!out) return NULL;
+
+    size_t oi = 0;
+    for(size_t i = start; i < end; ++i) {
+        char c = lex[i];
+        if(c == '\\' && i + 1 < end) {
+            char e = lex[i+1];
+            switch(e) {
+                case 'n':  out[oi++] = '\n'; break;
+                case 't':  out[oi++] = '\t'; break;
+                case '\\': out[oi++] = '\\'; break;
+                case '\"': out[oi++] = '\"'; break;
+                default:   out[oi++] = e;    break; // pasa tal cual el escape desconocido
+            }
+            i++; // saltar el char escapado
+        } else {
+            out[oi++] = c;
+        }
+    }
+    out[oi] = '\0';
+    return out;
+}
+
 // ---------- token helpers ----------
 static void advance_tok(parser_t *ps){
-    if(ps->prev.lexeme) token_free(&ps->prev);
+    // los tokens son vistas sobre el fuente: no hay nada que liberar
     ps->prev = ps->curr;
     ps->curr = lexer_next_token(ps->lx);
 }
+// Nombre del token previo internado en la arena del AST (ver ast_intern).
+static const char *prev_name(parser_t *ps){
+    return ast_intern(ps->arena, ps->prev.lexeme, ps->prev.length);
+}
+// Copia un lexema corto (números) a `buf` terminado en '\0'.
+static const char *lexeme_cstr(const token_t *t, char *buf, size_t cap){
+    size_t n = t->length < cap ? t->length : cap - 1u;
+    memcpy(buf, t->lexeme, n);
+    buf[n] = '\0';
+    return buf;
+}
 static bool check(parser_t *ps, token_type t){ return ps->curr.type==t; }
 static bool match(parser_t *ps, token_type t){ if(check(ps,t)){ advance_tok(ps); return true; } return false; }
 
@@ -71,8 +114,6 @@ void parser_init(parser_t *ps, lexer_t *lx){
     advance_tok(ps); // carga curr
 }
 void parser_dispose(parser_t *ps){
-    if(ps->curr.lexeme) token_free(&ps->curr);
-    if(ps->prev.lexeme) token_free(&ps->prev);
     for(size_t i=0;i<ps->errors.count;i++) free(ps->errors.items[i].message);
     free(ps->errors.items);
     memset(ps,0,sizeof(*ps));
@@ -126,19 +167,31 @@ static op_kind op_from_token(token_type t){
     }
 }
 
+// `T[]` tras un tipo base: array contiguo (sólo int, float y bool)
+static type_spec array_suffix(parser_t *ps, type_kind base){
+    if(!match(ps, TOK_LBRACKET)) return type_make(base);
+    consume_or_err(ps, TOK_RBRACKET, "Se esperaba ']' en el tipo array");
+    type_kind t = type_array_of(base);
+    if(t == TYPE_UNKNOWN){
+        error_at_previous(ps, "Los arrays sólo admiten int, float o bool");
+        return type_make(base);
+    }
+    return type_make(t);
+}
+
 static type_spec parse_type_spec(parser_t *ps){
-    if(match(ps, TOK_INT))    return type_make(TYPE_INT);
-    if(match(ps, TOK_BOOL))   return type_make(TYPE_BOOL);
-    if(match(ps, TOK_FLOAT))  return type_make(TYPE_FLOAT);
-    if(match(ps, TOK_STRING)) return type_make(TYPE_STRING);
+    if(match(ps, TOK_INT))    return array_suffix(ps, TYPE_INT);
+    if(match(ps, TOK_BOOL))   return array_suffix(ps, TYPE_BOOL);
+    if(match(ps, TOK_FLOAT))  return array_suffix(ps, TYPE_FLOAT);
+    if(match(ps, TOK_STRING)) return array_suffix(ps, TYPE_STRING);
     // permitir void sólo en retorno de función; no distinguimos aquí
     // lo haremos permisivo para que el parser de función lo use.
     // (si quieres prohibirlo en variables, valida en semántica).
-    if(ps->curr.type==TOK_IDENT && strcmp(ps->curr.lexeme,"void")==0){
+    if(ps->curr.type==TOK_IDENT && token_lexeme_is(&ps->curr,"void")){
         advance_tok(ps);
         return type_make(TYPE_VOID);
     }
-    error_at_current(ps, "Tipo esperado (int, bool, float, string)");
+    error_at_current(ps, "Tipo esperado (int, bool, float, string, int[], float[], bool[])");
     return type_make(TYPE_VOID);
 }
 
@@ -148,50 +201,76 @@ static expr* parse_precedence(parser_t *ps, precedence prec);
 static expr* parse_primary(parser_t *ps){
     if(match(ps, TOK_IDENT)){
         // podría ser inicio de llamada (se resuelve posteriormente en parse_call_suffix)
-        return expr_ident(ps->prev.lexeme, ps->prev.line, ps->prev.column);
+        return expr_ident(ps->arena, prev_name(ps), ps->prev.line, ps->prev.column);
     }
     if(match(ps, TOK_INT_LIT)){
-        long long v = atoll(ps->prev.lexeme);
-        return expr_int(v, ps->prev.line, ps->prev.column);
+        char buf[64];
+        long long v = strtoll(lexeme_cstr(&ps->prev, buf, sizeof buf), NULL, 10);
+        return expr_int(ps->arena, v, ps->prev.line, ps->prev.column);
     }
     if(match(ps, TOK_FLOAT_LIT)){
-        double d = atof(ps->prev.lexeme);
-        return expr_float(d, ps->prev.line, ps->prev.column);
+        char buf[64];
+        double d = strtod(lexeme_cstr(&ps->prev, buf, sizeof buf), NULL);
+        return expr_float(ps->arena, d, ps->prev.line, ps->prev.column);
     }
     if(match(ps, TOK_STRING_LIT)){
-        return expr_string(ps->prev.lexeme, ps->prev.line, ps->prev.column);
+        // se decodifica una sola vez; el AST guarda el valor listo para usar
+        char *text = unescape_celer_string(ps->prev.lexeme, ps->prev.length);
+        expr *e = expr_string(ps->arena, text ? text : "", ps->prev.line, ps->prev.column);
+        free(text);
+        return e;
     }
-    if(match(ps, TOK_TRUE))  return expr_bool(true,  ps->prev.line, ps->prev.column);
-    if(match(ps, TOK_FALSE)) return expr_bool(false, ps->prev.line, ps->prev.column);
+    if(match(ps, TOK_TRUE))  return expr_bool(ps->arena, true,  ps->prev.line, ps->prev.column);
+    if(match(ps, TOK_FALSE)) return expr_bool(ps->arena, false, ps->prev.line, ps->prev.column);
 
     if(match(ps, TOK_LPAREN)){
         int l = ps->prev.line, c = ps->prev.column;
         expr *inner = parse_expression(ps);
         consume_or_err(ps, TOK_RPAREN, "Se esperaba ')'");
-        return expr_group(inner, l, c);
+        return expr_group(ps->arena, inner, l, c);
+    }
+    if(match(ps, TOK_LBRACKET)){
+        // literal de array: '[' (expr (',' expr)*)? ']'
+        expr *arr = expr_array(ps->arena, ps->prev.line, ps->prev.column);
+        if(!check(ps, TOK_RBRACKET)){
+            do{
+                expr_array_push(ps->arena, arr, parse_expression(ps));
+            } while(match(ps, TOK_COMMA));
+        }
+        consume_or_err(ps, TOK_RBRACKET, "Se esperaba ']' al cerrar el array");
+        return arr;
     }
 
     error_at_current(ps, "Expresión primaria esperada");
     // avanza para no quedar en loop
     advance_tok(ps);
-    return expr_int(0, ps->prev.line, ps->prev.column);
+    return expr_int(ps->arena, 0, ps->prev.line, ps->prev.column);
 }
 
 static expr* parse_call_suffix(parser_t *ps, expr *callee){
     // llamada: '(' args? ')'
     if(!match(ps, TOK_LPAREN)) return callee;
     int l = ps->prev.line, c = ps->prev.column;
-    expr *call = expr_call(callee, l, c);
+    expr *call = expr_call(ps->arena, callee, l, c);
     if(!check(ps, TOK_RPAREN)){
         do{
             expr *arg = parse_expression(ps);
-            expr_args_push(call, arg);
+            expr_args_push(ps->arena, call, arg);
         } while(match(ps, TOK_COMMA));
     }
     consume_or_err(ps, TOK_RPAREN, "Se esperaba ')' después de argumentos");
     return call;
 }
 
+static expr* parse_index_suffix(parser_t *ps, expr *target){
+    // indexación: '[' expr ']'
+    if(!match(ps, TOK_LBRACKET)) return target;
+    int l = ps->prev.line, c = ps->prev.column;
+    expr *index = parse_expression(ps);
+    consume_or_err(ps, TOK_RBRACKET, "Se esperaba ']' después del índice");
+    return expr_index(ps->arena, target, index, l, c);
+}
+
 // Ternario especial: ? { true: <e1> : false: <e2> }
 static expr* parse_ternary_suffix(parser_t *ps, expr *cond){
     if(!match(ps, TOK_QUESTION)) return cond;
@@ -204,7 +283,7 @@ static expr* parse_ternary_suffix(parser_t *ps, expr *cond){
     consume_or_err(ps, TOK_COLON, "Se esperaba ':' después de 'false'");
     expr *e_false = parse_expression(ps);
     consume_or_err(ps, TOK_RBRACE, "Se esperaba '}' al cerrar ternario");
-    return expr_ternary(cond, e_true, e_false, cond->line, cond->col);
+    return expr_ternary(ps->arena, cond, e_true, e_false, cond->line, cond->col);
 }
 
 static expr* parse_unary(parser_t *ps){
@@ -212,7 +291,7 @@ static expr* parse_unary(parser_t *ps){
         token_type op_t = ps->prev.type;
         op_kind op = op_from_token(op_t);
         expr *right = parse_precedence(ps, PREC_UNARY);
-        return expr_unary(op, right, ps->prev.line, ps->prev.column);
+        return expr_unary(ps->arena, op, right, ps->prev.line, ps->prev.column);
     }
     return parse_primary(ps);
 }
@@ -228,7 +307,7 @@ static precedence precedence_of(token_type t){
         case TOK_LT: case TOK_LTE: case TOK_GT: case TOK_GTE: return PREC_COMPARE;
         case TOK_PLUS: case TOK_MINUS: return PREC_TERM;
         case TOK_STAR: case TOK_SLASH: case TOK_PERCENT: return PREC_FACTOR;
-        case TOK_LPAREN: return PREC_CALL;
+        case TOK_LPAREN: case TOK_LBRACKET: return PREC_CALL;
         default: return PREC_LOWEST;
     }
 }
@@ -238,9 +317,9 @@ static expr* parse_precedence(parser_t *ps, precedence prec){
 
     // Postfijos: llamada y ternario especial tienen mayor precedencia que binarios
     for(;;){
-        // llamadas (encadenadas)
+        // llamadas e indexación (encadenadas)
         if(precedence_of(ps->curr.type) == PREC_CALL){
-            left = parse_call_suffix(ps, left);
+            left = check(ps, TOK_LBRACKET) ? parse_index_suffix(ps, left) : parse_call_suffix(ps, left);
             continue;
         }
 
@@ -249,9 +328,17 @@ static expr* parse_precedence(parser_t *ps, precedence prec){
 
         // asignación es right-assoc
         if(nextp == PREC_ASSIGN){
-            // sólo permitimos lvalue = ... si left es IDENT
+            // a[i] op= ... modifica el elemento; el array se evalúa como expresión
+            if(left->kind == EXPR_INDEX){
+                token_type op_t = ps->curr.type; advance_tok(ps);
+                expr *rhs = parse_precedence(ps, PREC_ASSIGN);
+                left = expr_index_assign(ps->arena, left->as.index.target, left->as.index.index,
+                                         op_from_token(op_t), rhs, left->line, left->col);
+                continue;
+            }
+            // si no, sólo permitimos lvalue = ... si left es IDENT
             if(left->kind != EXPR_IDENT){
-                error_at_previous(ps, "El lado izquierdo de una asignación debe ser un identificador");
+                error_at_previous(ps, "El lado izquierdo de una asignación debe ser un identificador o a[i]");
                 // intenta consumir el operador para no buclear
                 advance_tok(ps);
                 // sigue parseando como si fuera binario para recuperar
@@ -262,7 +349,7 @@ static expr* parse_precedence(parser_t *ps, precedence prec){
             token_type op_t = ps->curr.type; advance_tok(ps);
             op_kind op = op_from_token(op_t);
             expr *rhs = parse_precedence(ps, PREC_ASSIGN);
-            left = expr_assign(left->as.ident.name, op, rhs, left->line, left->col);
+            left = expr_assign(ps->arena, left->as.ident.name, op, rhs, left->line, left->col);
             continue;
         }
 
@@ -273,7 +360,7 @@ static expr* parse_precedence(parser_t *ps, precedence prec){
         // definición de precedencia y asociatividad (izq-asoc)
         precedence rhs_prec = (nextp + 1);
         expr *right = parse_precedence(ps, rhs_prec);
-        left = expr_binary(left, op, right, ps->prev.line, ps->prev.column);
+        left = expr_binary(ps->arena, left, op, right, ps->prev.line, ps->prev.column);
     }
 
     // El ternario tiene menor precedencia que cualquier binario (como en C).
@@ -296,10 +383,10 @@ static stmt* parse_return(parser_t *ps){
     if(!check(ps, TOK_SEMICOLON)){
         expr *e = parse_expression(ps);
         consume_or_err(ps, TOK_SEMICOLON, "Se esperaba ';' después de return");
-        return stmt_return(e, l, c);
+        return stmt_return(ps->arena, e, l, c);
     } else {
         consume_or_err(ps, TOK_SEMICOLON, "Se esperaba ';' después de return");
-        return stmt_return(NULL, l, c);
+        return stmt_return(ps->arena, NULL, l, c);
     }
 }
 
@@ -313,7 +400,7 @@ static stmt* parse_if(parser_t *ps){
     if(match(ps, TOK_ELSE)){
         elseB = parse_block_stmt(ps);
     }
-    return stmt_if(cond, thenB, elseB, l, c);
+    return stmt_if(ps->arena, cond, thenB, elseB, l, c);
 }
 
 static stmt* parse_for(parser_t *ps){
@@ -328,7 +415,7 @@ static stmt* parse_for(parser_t *ps){
         if (!check(ps, TOK_RPAREN))    post = parse_expression(ps);
         consume_or_err(ps, TOK_RPAREN, "Se esperaba ')' al cerrar for");
         stmt *body = parse_block_stmt(ps);
-        return stmt_for_clike(/*init=*/NULL, cond, post, body, l, c);
+        return stmt_for_clike(ps->arena, /*init=*/NULL, cond, post, body, l, c);
     }
 
     // Caso B: for (variable ... ; ...)  o  for (const ... ; ...)
@@ -336,11 +423,9 @@ static stmt* parse_for(parser_t *ps){
         decl *vd = parse_declaration(ps); // consume hasta ';'
         stmt *init_stmt = NULL;
         if (vd && vd->kind==DECL_VAR) {
-            expr *assign = expr_assign(vd->as.var.name, OP_ASSIGN, vd->as.var.init, vd->as.var.line, vd->as.var.col);
-            init_stmt = stmt_expr_stmt(assign, vd->as.var.line, vd->as.var.col);
-            vd->as.var.init = NULL;
-            free(vd->as.var.name);
-            free(vd);
+            expr *assign = expr_assign(ps->arena, vd->as.var.name, OP_ASSIGN, vd->as.var.init, vd->as.var.line, vd->as.var.col);
+            assign->as.assign.decl_type = vd->as.var.type; // se conserva para el checker
+            init_stmt = stmt_expr_stmt(ps->arena, assign, vd->as.var.line, vd->as.var.col);
         }
         expr *cond = NULL, *post = NULL;
         if (!check(ps, TOK_SEMICOLON)) cond = parse_expression(ps);
@@ -348,7 +433,7 @@ static stmt* parse_for(parser_t *ps){
         if (!check(ps, TOK_RPAREN))    post = parse_expression(ps);
         consume_or_err(ps, TOK_RPAREN, "Se esperaba ')' al cerrar for");
         stmt *body = parse_block_stmt(ps);
-        return stmt_for_clike(init_stmt, cond, post, body, l, c);
+        return stmt_for_clike(ps->arena, init_stmt, cond, post, body, l, c);
     }
 
     // Caso C / D: empieza con una expresión
@@ -359,7 +444,7 @@ static stmt* parse_for(parser_t *ps){
     if (match(ps, TOK_RPAREN)) {
         // while-like
         stmt *body = parse_block_stmt(ps);
-        return stmt_for_while(first, body, l, c);
+        return stmt_for_while(ps->arena, first, body, l, c);
     }
 
     // Debe ser C-like con init=expr-stmt
@@ -372,21 +457,21 @@ static stmt* parse_for(parser_t *ps){
     consume_or_err(ps, TOK_RPAREN, "Se esperaba ')' al cerrar for");
 
     stmt *body = parse_block_stmt(ps);
-    return stmt_for_clike(stmt_expr_stmt(first, l, c), cond, post, body, l, c);
+    return stmt_for_clike(ps->arena, stmt_expr_stmt(ps->arena, first, l, c), cond, post, body, l, c);
 }
 
 static stmt* parse_statement(parser_t *ps){
     if(match(ps, TOK_RETURN))  return parse_return(ps);
-    if(match(ps, TOK_BREAK))   { consume_or_err(ps, TOK_SEMICOLON, "Se esperaba ';'"); return stmt_break(ps->prev.line, ps->prev.column); }
-    if(match(ps, TOK_CONTINUE)){ consume_or_err(ps, TOK_SEMICOLON, "Se esperaba ';'"); return stmt_continue(ps->prev.line, ps->prev.column); }
+    if(match(ps, TOK_BREAK))   { consume_or_err(ps, TOK_SEMICOLON, "Se esperaba ';'"); return stmt_break(ps->arena, ps->prev.line, ps->prev.column); }
+    if(match(ps, TOK_CONTINUE)){ consume_or_err(ps, TOK_SEMICOLON, "Se esperaba ';'"); return stmt_continue(ps->arena, ps->prev.line, ps->prev.column); }
     if(match(ps, TOK_IF))      return parse_if(ps);
     if(match(ps, TOK_FOR))     return parse_for(ps);
     if(match(ps, TOK_LBRACE))  {
         // ya consumimos '{' => devolvemos bloque llenándolo
-        stmt *blk = stmt_block(); // ubicaciones 0 por simplicidad
+        stmt *blk = stmt_block(ps->arena); // ubicaciones 0 por simplicidad
         while(!check(ps, TOK_RBRACE) && ps->curr.type != TOK_EOF){
             stmt *s = parse_statement(ps);
-            stmt_block_push(blk, s);
+            stmt_block_push(ps->arena, blk, s);
         }
         consume_or_err(ps, TOK_RBRACE, "Se esperaba '}'");
         return blk;
@@ -395,12 +480,12 @@ static stmt* parse_statement(parser_t *ps){
     // stmt expresión:
     expr *e = parse_expression(ps);
     consume_or_err(ps, TOK_SEMICOLON, "Se esperaba ';' al final de la sentencia");
-    return stmt_expr_stmt(e, ps->prev.line, ps->prev.column);
+    return stmt_expr_stmt(ps->arena, e, ps->prev.line, ps->prev.column);
 }
 
 static stmt* parse_block_stmt(parser_t *ps){
     consume_or_err(ps, TOK_LBRACE, "Se esperaba '{'");
-    stmt *blk = stmt_block();
+    stmt *blk = stmt_block(ps->arena);
     while(!check(ps, TOK_RBRACE) && ps->curr.type != TOK_EOF){
         // En un bloque pueden venir declaraciones o sentencias
         if(check(ps, TOK_VARIABLE) || check(ps, TOK_CONST) || check(ps, TOK_Function)){
@@ -408,19 +493,18 @@ static stmt* parse_block_stmt(parser_t *ps){
             // Para este AST no hay stmt_decl, así que lo insertamos como expr-stmt equivalente cuando es var:
             if(d){
                 if(d->kind==DECL_VAR){
-                    expr *assign = expr_assign(d->as.var.name, OP_ASSIGN, d->as.var.init, d->as.var.line, d->as.var.col);
-                    stmt_block_push(blk, stmt_expr_stmt(assign, d->as.var.line, d->as.var.col));
-                    d->as.var.init=NULL; free(d->as.var.name); free(d); // consumido
+                    expr *assign = expr_assign(ps->arena, d->as.var.name, OP_ASSIGN, d->as.var.init, d->as.var.line, d->as.var.col);
+                    assign->as.assign.decl_type = d->as.var.type; // se conserva para el checker
+                    stmt_block_push(ps->arena, blk, stmt_expr_stmt(ps->arena, assign, d->as.var.line, d->as.var.col));
                 } else {
                     // Las funciones dentro de bloque no están en la gramática original.
                     // Si quisieras soportar anidadas, deberías ampliar AST.
                     error_at_previous(ps, "Declaración de función no permitida dentro de bloque");
-                    decl_free(d);
                 }
             }
         } else {
             stmt *s = parse_statement(ps);
-            stmt_block_push(blk, s);
+            stmt_block_push(ps->arena, blk, s);
         }
     }
     consume_or_err(ps, TOK_RBRACE, "Se esperaba '}'");
@@ -435,16 +519,14 @@ static decl* parse_var_decl(parser_t *ps, bool is_const){
         error_at_current(ps, "Se esperaba un identificador");
         return NULL;
     }
-    char *name = dup_cstr(ps->prev.lexeme);
+    const char *name = prev_name(ps);
     consume_or_err(ps, TOK_COLON, "Se esperaba ':' después del nombre");
     type_spec t = parse_type_spec(ps);
     consume_or_err(ps, TOK_ASSIGN, "Se esperaba '=' en inicialización");
     expr *init = parse_expression(ps);
     consume_or_err(ps, TOK_SEMICOLON, "Se esperaba ';' al final de la declaración");
 
-    decl *d = decl_var(name, is_const, t, init, l, c);
-    free(name); // decl_var duplica
-    return d;
+    return decl_var(ps->arena, name, is_const, t, init, l, c);
 }
 
 static decl* parse_func_decl(parser_t *ps){
@@ -454,11 +536,10 @@ static decl* parse_func_decl(parser_t *ps){
         error_at_current(ps, "Se esperaba nombre de función");
         return NULL;
     }
-    char *fname = dup_cstr(ps->prev.lexeme);
+    const char *fname = prev_name(ps);
     consume_or_err(ps, TOK_LPAREN, "Se esperaba '('");
 
-    decl *fn = decl_func(fname, type_make(TYPE_VOID), l, c);
-    free(fname);
+    decl *fn = decl_func(ps->arena, fname, type_make(TYPE_VOID), l, c);
 
     if(!check(ps, TOK_RPAREN)){
         do{
@@ -466,11 +547,10 @@ static decl* parse_func_decl(parser_t *ps){
                 error_at_current(ps, "Se esperaba nombre de parámetro");
                 break;
             }
-            char *pname = dup_cstr(ps->prev.lexeme);
+            const char *pname = prev_name(ps);
             consume_or_err(ps, TOK_COLON, "Se esperaba ':' después del parámetro");
             type_spec pt = parse_type_spec(ps);
-            decl_func_param_push(fn, pname, pt);
-            free(pname);
+            decl_func_param_push(ps->arena, fn, pname, pt);
         } while(match(ps, TOK_COMMA));
     }
     consume_or_err(ps, TOK_RPAREN, "Se esperaba ')' al cerrar parámetros");
@@ -500,6 +580,7 @@ static decl* parse_declaration(parser_t *ps){
 // ---------- programa ----------
 program_ast parse_program(parser_t *ps){
     program_ast prog = program_make();
+    ps->arena = prog.arena;
     while(ps->curr.type != TOK_EOF){
         decl *d = parse_declaration(ps);
         if(d) program_push_decl(&prog, d);
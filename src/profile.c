@@ -0,0 +1,300 @@
+#if !defined(_WIN32) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 600   // clock_gettime, sigaction, setitimer
+#endif
+#include "../include/profile.h"
+#include "../include/stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#if !defined(_WIN32)
+#include <sys/time.h>
+#endif
+
+bool g_prof_enabled;
+volatile sig_atomic_t g_prof_sample;
+
+// datos por función
+typedef struct {
+    const func_decl *fn;
+    unsigned long long calls, allocs;
+    uint64_t incl_ns, excl_ns;
+    unsigned active;             // activaciones abiertas (recursión)
+} prof_fn;
+
+// nodo del árbol de pilas: la raíz (0) es el script
+typedef struct {
+    size_t fn;                   // índice en g_fns
+    size_t parent, child, next;  // 0 = ninguno (la raíz nunca es hijo)
+    uint64_t self_ns;
+} prof_node;
+
+typedef struct {
+    size_t fn, node;
+    uint64_t start, child_ns;
+    unsigned long long allocs0, child_allocs;
+} prof_frame;
+
+static prof_fn *g_fns;       static size_t g_fns_count, g_fns_cap;
+static size_t *g_index;      static size_t g_index_cap;   // hash fn -> g_fns+1 (0 = vacío)
+static prof_node *g_nodes;   static size_t g_nodes_count, g_nodes_cap;
+static prof_frame *g_frames; static size_t g_frames_count, g_frames_cap;
+
+static uint64_t now_ns(void){
+#if defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#else
+    return (uint64_t)((double)clock() * (1e9 / (double)CLOCKS_PER_SEC));
+#endif
+}
+
+static size_t hash_ptr(const void *p, size_t cap){
+    uintptr_t x = (uintptr_t)p;
+    x ^= x >> 17; x *= (uintptr_t)0x9E3779B97F4A7C15ull; x ^= x >> 29;
+    return (size_t)x & (cap - 1u);
+}
+
+static void index_insert(size_t i){
+    size_t h = hash_ptr(g_fns[i].fn, g_index_cap);
+    while(g_index[h]) h = (h + 1u) & (g_index_cap - 1u);
+    g_index[h] = i + 1u;
+}
+
+static size_t fn_index(const func_decl *fn){
+    if(g_index_cap){
+        for(size_t h = hash_ptr(fn, g_index_cap); g_index[h]; h = (h + 1u) & (g_index_cap - 1u))
+            if(g_fns[g_index[h] - 1u].fn == fn) return g_index[h] - 1u;
+    }
+    if(g_fns_count == g_fns_cap){
+        g_fns_cap = g_fns_cap ? g_fns_cap * 2u : 16u;
+        g_fns = (prof_fn*)realloc(g_fns, g_fns_cap * sizeof(prof_fn));
+    }
+    memset(&g_fns[g_fns_count], 0, sizeof(prof_fn));
+    g_fns[g_fns_count].fn = fn;
+    size_t i = g_fns_count++;
+    if(g_fns_count * 2u > g_index_cap){
+        free(g_index);
+        g_index_cap = g_index_cap ? g_index_cap * 2u : 32u;
+        g_index = (size_t*)calloc(g_index_cap, sizeof(size_t));
+        for(size_t k = 0; k < g_fns_count; k++) index_insert(k);
+    } else index_insert(i);
+    return i;
+}
+
+static size_t new_node(size_t fn, size_t parent){
+    if(g_nodes_count == g_nodes_cap){
+        g_nodes_cap = g_nodes_cap ? g_nodes_cap * 2u : 64u;
+        g_nodes = (prof_node*)realloc(g_nodes, g_nodes_cap * sizeof(prof_node));
+    }
+    prof_node *n = &g_nodes[g_nodes_count];
+    n->fn = fn; n->parent = parent; n->child = 0; n->next = 0; n->self_ns = 0;
+    return g_nodes_count++;
+}
+
+static size_t child_node(size_t parent, size_t fn){
+    for(size_t c = g_nodes[parent].child; c; c = g_nodes[c].next)
+        if(g_nodes[c].fn == fn) return c;
+    size_t c = new_node(fn, parent);
+    g_nodes[c].next = g_nodes[parent].child;
+    g_nodes[parent].child = c;
+    return c;
+}
+
+void prof_enable(void){
+    g_prof_enabled = true;
+    if(!g_nodes_count) new_node(0, 0);
+}
+
+void prof_enter(const func_decl *fn){
+    size_t f = fn_index(fn);
+    g_fns[f].calls++;
+    g_fns[f].active++;
+    if(g_frames_count == g_frames_cap){
+        g_frames_cap = g_frames_cap ? g_frames_cap * 2u : 64u;
+        g_frames = (prof_frame*)realloc(g_frames, g_frames_cap * sizeof(prof_frame));
+    }
+    prof_frame *fr = &g_frames[g_frames_count++];
+    fr->fn = f;
+    fr->node = child_node(g_frames_count > 1 ? g_frames[g_frames_count - 2].node : 0, f);
+    fr->child_ns = 0; fr->child_allocs = 0;
+    fr->allocs0 = g_stats.allocs;
+    fr->start = now_ns();
+}
+
+void prof_leave(void){
+    if(!g_frames_count) return;
+    uint64_t t = now_ns();
+    prof_frame *fr = &g_frames[--g_frames_count];
+    prof_fn *f = &g_fns[fr->fn];
+    uint64_t total = t - fr->start, self = total - fr->child_ns;
+    unsigned long long allocs = g_stats.allocs - fr->allocs0;
+    f->excl_ns += self;
+    f->allocs += allocs - fr->child_allocs;
+    if(--f->active == 0) f->incl_ns += total;
+    g_nodes[fr->node].self_ns += self;
+    if(g_frames_count){
+        g_frames[g_frames_count - 1].child_ns += total;
+        g_frames[g_frames_count - 1].child_allocs += allocs;
+    }
+}
+
+void prof_tail(const func_decl *fn){
+    prof_leave();
+    prof_enter(fn);
+}
+
+static int cmp_excl(const void *a, const void *b){
+    const prof_fn *x = (const prof_fn*)a, *y = (const prof_fn*)b;
+    if(x->excl_ns != y->excl_ns) return x->excl_ns < y->excl_ns ? 1 : -1;
+    return strcmp(x->fn->name, y->fn->name);
+}
+
+void prof_report(FILE *out){
+    while(g_frames_count) prof_leave();
+    uint64_t total = 0;
+    for(size_t i = 0; i < g_fns_count; i++) total += g_fns[i].excl_ns;
+    // se ordena una copia: los nodos del árbol guardan índices de g_fns
+    prof_fn *sorted = (prof_fn*)malloc((g_fns_count ? g_fns_count : 1u) * sizeof(prof_fn));
+    if(!sorted) return;
+    if(g_fns_count) memcpy(sorted, g_fns, g_fns_count * sizeof(prof_fn));
+    qsort(sorted, g_fns_count, sizeof(prof_fn), cmp_excl);
+    fprintf(out, "Perfil: %zu funciones, %.3f ms en llamadas\n", g_fns_count, (double)total / 1e6);
+    fprintf(out, "%12s %7s %12s %12s %10s  %s\n", "excl ms", "excl %", "incl ms", "llamadas", "reservas", "función");
+    for(size_t i = 0; i < g_fns_count; i++){
+        const prof_fn *f = &sorted[i];
+        fprintf(out, "%12.3f %6.1f%% %12.3f %12llu %10llu  %s\n",
+                (double)f->excl_ns / 1e6, total ? 100.0 * (double)f->excl_ns / (double)total : 0.0,
+                (double)f->incl_ns / 1e6, f->calls, f->allocs, f->fn->name);
+    }
+    free(sorted);
+}
+
+// escribe la pila del nodo n (de la raíz hacia abajo)
+static void write_path(FILE *f, size_t n){
+    if(g_nodes[n].parent) { write_path(f, g_nodes[n].parent); fputc(';', f); }
+    fputs(g_fns[g_nodes[n].fn].fn->name, f);
+}
+
+bool prof_write_collapsed(const char *path){
+    while(g_frames_count) prof_leave();
+    FILE *f = fopen(path, "w");
+    if(!f) return false;
+    for(size_t n = 1; n < g_nodes_count; n++){
+        uint64_t us = (g_nodes[n].self_ns + 500u) / 1000u;
+        if(!us) continue;
+        write_path(f, n);
+        fprintf(f, " %llu\n", (unsigned long long)us);
+    }
+    bool ok = !ferror(f);
+    return fclose(f) == 0 && ok;
+}
+
+// ----- muestreo por línea -----
+
+static unsigned long long *g_line_hits; static size_t g_line_cap;
+static unsigned long long g_samples;
+static unsigned g_interval_us;
+
+#if defined(SIGPROF) && !defined(_WIN32)
+static void on_sigprof(int sig){
+    (void)sig;
+    if(g_prof_sample < 0x7fff) g_prof_sample++;
+}
+
+bool prof_sample_start(unsigned interval_us){
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sigprof;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if(sigaction(SIGPROF, &sa, NULL) != 0) return false;
+    struct itimerval it;
+    it.it_interval.tv_sec = (time_t)(interval_us / 1000000u);
+    it.it_interval.tv_usec = (suseconds_t)(interval_us % 1000000u);
+    it.it_value = it.it_interval;
+    if(setitimer(ITIMER_PROF, &it, NULL) != 0) return false;
+    g_interval_us = interval_us;
+    return true;
+}
+
+void prof_sample_stop(void){
+    struct itimerval it;
+    memset(&it, 0, sizeof(it));
+    setitimer(ITIMER_PROF, &it, NULL);
+    signal(SIGPROF, SIG_DFL);
+    g_prof_sample = 0;
+}
+#else
+bool prof_sample_start(unsigned interval_us){ (void)interval_us; return false; }
+void prof_sample_stop(void){ g_prof_sample = 0; }
+#endif
+
+void prof_sample_hit(int line){
+    // varios ticks antes de llegar a un punto de control cuentan todos aquí
+    unsigned n = (unsigned)g_prof_sample;
+    g_prof_sample = 0;
+    if(line < 0) line = 0;
+    if((size_t)line >= g_line_cap){
+        size_t cap = g_line_cap ? g_line_cap : 256u;
+        while(cap <= (size_t)line) cap *= 2u;
+        unsigned long long *nh = (unsigned long long*)realloc(g_line_hits, cap * sizeof(*nh));
+        if(!nh) return;
+        memset(nh + g_line_cap, 0, (cap - g_line_cap) * sizeof(*nh));
+        g_line_hits = nh; g_line_cap = cap;
+    }
+    g_line_hits[line] += n;
+    g_samples += n;
+}
+
+static const unsigned long long *g_sort_hits;
+
+static int cmp_hits(const void *a, const void *b){
+    size_t x = *(const size_t*)a, y = *(const size_t*)b;
+    if(g_sort_hits[x] != g_sort_hits[y]) return g_sort_hits[x] < g_sort_hits[y] ? 1 : -1;
+    return x < y ? -1 : x > y;
+}
+
+void prof_sample_report(FILE *out, const char *source, size_t len){
+    fprintf(out, "Muestras: %llu (cada %u us de CPU)\n", g_samples, g_interval_us);
+    if(!g_samples) return;
+    size_t nlines = 0;
+    for(size_t l = 0; l < g_line_cap; l++) if(g_line_hits[l]) nlines++;
+    size_t *order = (size_t*)malloc(nlines * sizeof(size_t));
+    if(!order) return;
+    nlines = 0;
+    for(size_t l = 0; l < g_line_cap; l++) if(g_line_hits[l]) order[nlines++] = l;
+    g_sort_hits = g_line_hits;
+    qsort(order, nlines, sizeof(size_t), cmp_hits);
+    // comienzo de cada línea del fuente (1-based)
+    size_t nsrc = 1;
+    for(size_t i = 0; i < len; i++) if(source[i] == '\n') nsrc++;
+    size_t *starts = (size_t*)malloc((nsrc + 1u) * sizeof(size_t));
+    if(!starts){ free(order); return; }
+    starts[0] = starts[1] = 0;
+    for(size_t i = 0, l = 1; i < len; i++) if(source[i] == '\n') starts[++l] = i + 1u;
+    fprintf(out, "%10s %7s %6s  %s\n", "muestras", "%", "línea", "código");
+    for(size_t i = 0; i < nlines; i++){
+        size_t l = order[i];
+        fprintf(out, "%10llu %6.1f%% %6zu  ", g_line_hits[l], 100.0 * (double)g_line_hits[l] / (double)g_samples, l);
+        if(l >= 1 && l <= nsrc){
+            const char *p = source + starts[l], *end = source + len;
+            while(p < end && (*p == ' ' || *p == '\t')) p++;
+            const char *q = p;
+            while(q < end && *q != '\n' && *q != '\r') q++;
+            fprintf(out, "%.*s", (int)(q - p > 60 ? 60 : q - p), p);
+        }
+        fputc('\n', out);
+    }
+    free(starts);
+    free(order);
+}
+
+void prof_release(void){
+    free(g_fns); free(g_index); free(g_nodes); free(g_frames); free(g_line_hits);
+    g_fns = NULL; g_index = NULL; g_nodes = NULL; g_frames = NULL; g_line_hits = NULL;
+    g_fns_count = g_fns_cap = g_index_cap = g_nodes_count = g_nodes_cap = g_frames_count = g_frames_cap = 0;
+    g_line_cap = 0; g_samples = 0;
+    g_prof_enabled = false;
+}
@@ -3,6 +3,8 @@
 #include "../include/ast.h"
 #include "../include/env.h"
 #include "../include/eval.h"
+#include "../include/resolver.h"
+#include "../include/typecheck.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -68,8 +70,24 @@ static char* read_chunk(void){
     return buf;
 }
 
+// Programas ya cargados: el entorno global referencia sus funciones y
+// literales, así que viven hasta el final de la sesión.
+typedef struct {
+    program_ast *items;
+    size_t count, cap;
+} program_list;
+
+static void program_list_push(program_list *l, program_ast p){
+    if(l->count==l->cap){
+        size_t nc = l->cap ? l->cap*2u : 8u;
+        l->items = (program_ast*)realloc(l->items, nc*sizeof(program_ast));
+        l->cap = nc;
+    }
+    l->items[l->count++] = p;
+}
+
 // Ejecuta un "programa" en el entorno dado
-static int run_program_in_env(env_t *global, const char *src){
+static int run_program_in_env(env_t *global, const char *src, program_list *loaded){
     lexer_t lx; lexer_from_cstr(&lx, src);
     parser_t ps; parser_init(&ps, &lx);
     program_ast P = parse_program(&ps);
@@ -85,9 +103,21 @@ static int run_program_in_env(env_t *global, const char *src){
     }
 
     // Usa el evaluator para cargar vars/funcs y ejecutar main() si existe
+    resolve_program(&P, global);
+    eval_register_builtins(global);
+    parse_error_list terrs = { NULL, 0, 0 };
+    if(!typecheck_program(&P, global, false, &terrs)){
+        fprintf(stderr,"Errores de tipo: %zu\n", terrs.count);
+        for(size_t i=0;i<terrs.count;i++){
+            fprintf(stderr," @%d:%d %s\n", terrs.items[i].line, terrs.items[i].col, terrs.items[i].message);
+        }
+        typecheck_errors_free(&terrs);
+        program_free(&P); parser_dispose(&ps);
+        return 1;
+    }
     (void)eval_program(global, &P);
 
-    program_free(&P);
+    program_list_push(loaded, P);
     parser_dispose(&ps);
     return 0;
 }
@@ -100,6 +130,7 @@ int main(void){
 #endif
 
     env_t *global = env_new(NULL);
+    program_list loaded = { NULL, 0, 0 };
 
     for(;;){
         char *chunk = read_chunk();
@@ -111,7 +142,7 @@ int main(void){
         int rc = 0;
         if(is_decl){
             // Compilar/registrar declaraciones tal cual
-            rc = run_program_in_env(global, chunk);
+            rc = run_program_in_env(global, chunk, &loaded);
         } else {
             // Envolver sentencias/expresiones en una función main() temporal
             const char *pre = "Function main() -> void {\n";
@@ -123,7 +154,7 @@ int main(void){
             strcat(wrapped, chunk);
             strcat(wrapped, suf);
 
-            rc = run_program_in_env(global, wrapped);
+            rc = run_program_in_env(global, wrapped, &loaded);
             free(wrapped);
         }
 
@@ -134,6 +165,8 @@ int main(void){
     }
 
     env_free(global);
+    for(size_t i=0;i<loaded.count;i++) program_free(&loaded.items[i]);
+    free(loaded.items);
     puts("Adiós!");
     return 0;
 }
@@ -0,0 +1,195 @@
+#include "../include/resolver.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char **names; // no son dueños: apuntan al AST
+    size_t count, cap;
+} scope_t;
+
+typedef struct {
+    const char *name;   // NULL = vacío
+    bool is_const;
+} global_name;
+
+typedef struct {
+    scope_t *scopes; size_t count, cap;
+    global_name *globals; size_t globals_cap; // globales del programa (hash abierto, cap potencia de 2)
+    env_t *global;
+} resolver_t;
+
+// ---------------- scopes ----------------
+static void push_scope(resolver_t *r){
+    if(r->count==r->cap){
+        size_t nc=r->cap?r->cap*2u:8u;
+        r->scopes=(scope_t*)realloc(r->scopes, nc*sizeof(scope_t));
+        r->cap=nc;
+    }
+    r->scopes[r->count].names=NULL;
+    r->scopes[r->count].count=0;
+    r->scopes[r->count].cap=0;
+    r->count++;
+}
+static size_t pop_scope(resolver_t *r){
+    scope_t *sc=&r->scopes[--r->count];
+    size_t n=sc->count;
+    free(sc->names);
+    return n;
+}
+static int declare(resolver_t *r, const char *name){
+    scope_t *sc=&r->scopes[r->count-1];
+    if(sc->count==sc->cap){
+        size_t nc=sc->cap?sc->cap*2u:8u;
+        sc->names=(const char**)realloc(sc->names, nc*sizeof(const char*));
+        sc->cap=nc;
+    }
+    sc->names[sc->count]=name;
+    return (int)sc->count++;
+}
+static bool lookup(const resolver_t *r, const char *name, int *depth, int *slot){
+    for(size_t i=r->count; i>0; i--){
+        const scope_t *sc=&r->scopes[i-1];
+        for(size_t j=0;j<sc->count;j++){
+            if(strcmp(sc->names[j], name)==0){
+                *depth=(int)(r->count-i); *slot=(int)j; return true;
+            }
+        }
+    }
+    return false;
+}
+
+static size_t hash_name(const char *s){
+    size_t h = 2166136261u; // FNV-1a
+    for(; *s; s++){ h ^= (unsigned char)*s; h *= 16777619u; }
+    return h;
+}
+
+static global_name *global_slot(const resolver_t *r, const char *name){
+    size_t h = hash_name(name) & (r->globals_cap - 1u);
+    while(r->globals[h].name && strcmp(r->globals[h].name, name) != 0) h = (h + 1u) & (r->globals_cap - 1u);
+    return &r->globals[h];
+}
+
+// ¿Existe un global asignable con ese nombre? (del programa o del entorno)
+static bool global_assignable(const resolver_t *r, const char *name){
+    const global_name *g=global_slot(r, name);
+    if(g->name) return !g->is_const;
+    bool is_const=false;
+    if(r->global && env_has_var(r->global, name, &is_const)) return !is_const;
+    return false;
+}
+
+// ---------------- recorrido ----------------
+static void resolve_expr(resolver_t *r, expr *e);
+static void resolve_stmt(resolver_t *r, stmt *s);
+
+static void resolve_expr(resolver_t *r, expr *e){
+    if(!e) return;
+    switch(e->kind){
+        case EXPR_IDENT: {
+            int d, sl;
+            if(r->count && lookup(r, e->as.ident.name, &d, &sl)){
+                e->as.ident.depth=d; e->as.ident.slot=sl;
+            } else {
+                e->as.ident.depth=-1; e->as.ident.slot=-1;
+            }
+            break;
+        }
+        case EXPR_INT_LIT: case EXPR_FLOAT_LIT: case EXPR_BOOL_LIT: case EXPR_STRING_LIT: break;
+        case EXPR_UNARY: resolve_expr(r, e->as.unary.right); break;
+        case EXPR_BINARY: resolve_expr(r, e->as.binary.left); resolve_expr(r, e->as.binary.right); break;
+        case EXPR_GROUPING: resolve_expr(r, e->as.grouping.inner); break;
+        case EXPR_TERNARY:
+            resolve_expr(r, e->as.ternary.cond);
+            resolve_expr(r, e->as.ternary.when_true);
+            resolve_expr(r, e->as.ternary.when_false);
+            break;
+        case EXPR_CALL:
+            // el callee se busca en la tabla de funciones, no como variable
+            for(size_t i=0;i<e->as.call.args.count;i++) resolve_expr(r, e->as.call.args.items[i]);
+            break;
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++) resolve_expr(r, e->as.array.items.items[i]);
+            break;
+        case EXPR_INDEX: resolve_expr(r, e->as.index.target); resolve_expr(r, e->as.index.index); break;
+        case EXPR_INDEX_ASSIGN:
+            // a[i] = v lee `a`: no define ni reasigna la variable
+            resolve_expr(r, e->as.index_assign.target);
+            resolve_expr(r, e->as.index_assign.index);
+            resolve_expr(r, e->as.index_assign.value);
+            break;
+        case EXPR_ASSIGN: {
+            // el valor se evalúa antes de definir el nombre
+            resolve_expr(r, e->as.assign.value);
+            int d, sl;
+            e->as.assign.depth=-1; e->as.assign.slot=-1;
+            if(!r->count) break; // nivel global: por nombre
+            if(lookup(r, e->as.assign.name, &d, &sl)){
+                e->as.assign.depth=d; e->as.assign.slot=sl;
+            } else if(e->as.assign.op==OP_ASSIGN && !global_assignable(r, e->as.assign.name)){
+                e->as.assign.depth=0;
+                e->as.assign.slot=declare(r, e->as.assign.name);
+            }
+            break;
+        }
+    }
+}
+
+static void resolve_stmt(resolver_t *r, stmt *s){
+    if(!s) return;
+    switch(s->kind){
+        case STMT_EXPR: resolve_expr(r, s->as.expr_stmt.value); break;
+        case STMT_RETURN: resolve_expr(r, s->as.ret.value); break;
+        case STMT_BREAK: case STMT_CONTINUE: break;
+        case STMT_BLOCK:
+            push_scope(r);
+            for(size_t i=0;i<s->as.block.stmts.count;i++) resolve_stmt(r, s->as.block.stmts.items[i]);
+            s->as.block.nslots=(int)pop_scope(r);
+            break;
+        case STMT_IF:
+            resolve_expr(r, s->as.if_stmt.cond);
+            resolve_stmt(r, s->as.if_stmt.then_branch);
+            resolve_stmt(r, s->as.if_stmt.else_branch);
+            break;
+        case STMT_FOR_WHILELIKE:
+            resolve_expr(r, s->as.for_while.cond);
+            resolve_stmt(r, s->as.for_while.body);
+            break;
+        case STMT_FOR_CLIKE:
+            // init/cond/post viven en el bloque que contiene al for
+            resolve_stmt(r, s->as.for_clike.init);
+            resolve_expr(r, s->as.for_clike.cond);
+            resolve_expr(r, s->as.for_clike.post);
+            resolve_stmt(r, s->as.for_clike.body);
+            break;
+    }
+}
+
+void resolve_program(program_ast *P, env_t *global){
+    resolver_t r; memset(&r, 0, sizeof(r));
+    r.global=global;
+    // la primera declaración de cada global decide si es constante
+    r.globals_cap=16u;
+    while(r.globals_cap < P->decls.count*2u) r.globals_cap*=2u;
+    r.globals=(global_name*)calloc(r.globals_cap, sizeof(global_name));
+    for(size_t i=0;i<P->decls.count;i++){
+        const decl *d=P->decls.items[i];
+        if(d->kind!=DECL_VAR) continue;
+        global_name *g=global_slot(&r, d->as.var.name);
+        if(!g->name){ g->name=d->as.var.name; g->is_const=d->as.var.is_const; }
+    }
+    for(size_t i=0;i<P->decls.count;i++){
+        decl *d=P->decls.items[i];
+        if(d->kind==DECL_VAR){
+            resolve_expr(&r, d->as.var.init);
+        } else {
+            func_decl *fn=&d->as.func;
+            push_scope(&r); // frame de parámetros
+            for(size_t j=0;j<fn->params.count;j++) declare(&r, fn->params.items[j].name);
+            resolve_stmt(&r, fn->body);
+            pop_scope(&r);
+        }
+    }
+    free(r.scopes);
+    free(r.globals);
+}
@@ -1,11 +1,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 #include "../include/lexer.h"
 #include "../include/parser.h"
 #include "../include/ast.h"
 #include "../include/env.h"
 #include "../include/eval.h"
+#include "../include/resolver.h"
+#include "../include/optimizer.h"
+#include "../include/typecheck.h"
+#include "../include/jit.h"
+#include "../include/emitc.h"
+#include "../include/profile.h"
+#include "../include/stats.h"
+#include "../include/bytecode.h"
+#include "../include/vm.h"
 
 static char *read_file(const char *path, size_t *out_len){
     FILE *f = fopen(path, "rb"); if(!f) return NULL;
@@ -31,12 +41,76 @@ static char *read_stdin_all(void){
     return buf;
 }
 
+static void usage(const char *prog){
+    fprintf(stderr,"Uso: %s [opciones] [archivo.celer]\n", prog);
+    fprintf(stderr,"  --vm        ejecuta con el compilador a bytecode + VM de pila\n");
+    fprintf(stderr,"  --no-opt    desactiva las optimizaciones del AST (plegado, LICM)\n");
+    fprintf(stderr,"  --no-inline no expande las llamadas a funciones pequeñas\n");
+    fprintf(stderr,"  --no-jit    no compila a código nativo las funciones calientes\n");
+    fprintf(stderr,"  --jit-log   informa en stderr qué funciones compila el JIT\n");
+    fprintf(stderr,"  --dump-ast  imprime el AST antes y después de optimizar\n");
+    fprintf(stderr,"  --emit-c    no ejecuta: escribe en stdout el programa traducido a C99\n");
+    fprintf(stderr,"  --profile   al terminar muestra (en stderr) tiempo, llamadas y reservas por función; desactiva el JIT\n");
+    fprintf(stderr,"  --profile-out F  con --profile, escribe en F las pilas para flame graphs\n");
+    fprintf(stderr,"  --sample    muestrea el tiempo de CPU y al terminar muestra (en stderr) las líneas más calientes; desactiva el JIT\n");
+    fprintf(stderr,"  --sample-us N  con --sample, intervalo de muestreo en microsegundos (por defecto 1000)\n");
+    fprintf(stderr,"  --stats     al terminar muestra (en stderr) reservas, bytes, entornos y accesos a variables; desactiva el JIT\n");
+    fprintf(stderr,"  --max-depth N  profundidad máxima de llamadas (por defecto %u)\n", CELER_MAX_DEPTH_DEFAULT);
+}
+
+// Compila a bytecode y ejecuta; si el programa no se puede compilar, cae al evaluador.
+// Devuelve false si hubo un error de ejecución.
+static bool run_with_vm(env_t *global, const program_ast *P){
+    eval_register_builtins(global);
+    bc_program prog; char err[256];
+    if(!bc_compile_program(P, global, &prog, err, sizeof(err))){
+        fprintf(stderr,"VM: no se pudo compilar (%s); usando el evaluador\n", err);
+        return eval_program(global, P).sig != SIG_RUNTIME_ERROR;
+    }
+    bool ok = vm_run(&prog, global);
+    bc_program_free(&prog);
+    return ok;
+}
+
 int main(int argc, char **argv){
     char *source=NULL; size_t slen=0;
+    const char *path=NULL;
+    bool use_vm=false, optimize=true, inline_calls=true, use_jit=true, dump_ast=false, emit_c=false, profile=false, sample=false, stats=false;
+    const char *profile_out=NULL;
+    unsigned sample_us = 1000u;
+    size_t max_depth = CELER_MAX_DEPTH_DEFAULT;
+
+    for(int i=1;i<argc;i++){
+        if(strcmp(argv[i],"--vm")==0) use_vm=true;
+        else if(strcmp(argv[i],"--no-opt")==0) optimize=false;
+        else if(strcmp(argv[i],"--no-inline")==0) inline_calls=false;
+        else if(strcmp(argv[i],"--no-jit")==0) use_jit=false;
+        else if(strcmp(argv[i],"--jit-log")==0) jit_set_log(true);
+        else if(strcmp(argv[i],"--dump-ast")==0) dump_ast=true;
+        else if(strcmp(argv[i],"--emit-c")==0) emit_c=true;
+        else if(strcmp(argv[i],"--profile")==0) profile=true;
+        else if(strcmp(argv[i],"--profile-out")==0 && i+1<argc){ profile=true; profile_out=argv[++i]; }
+        else if(strcmp(argv[i],"--sample")==0) sample=true;
+        else if(strcmp(argv[i],"--stats")==0) stats=true;
+        else if(strcmp(argv[i],"--sample-us")==0 && i+1<argc){
+            char *end; unsigned long n = strtoul(argv[++i], &end, 10);
+            if(*end || n == 0 || n > 1000000ul){ usage(argv[0]); return 1; }
+            sample=true; sample_us=(unsigned)n;
+        }
+        else if(strcmp(argv[i],"--max-depth")==0 && i+1<argc){
+            char *end; unsigned long n = strtoul(argv[++i], &end, 10);
+            if(*end || n == 0){ usage(argv[0]); return 1; }
+            max_depth = (size_t)n;
+            eval_set_max_depth(max_depth);
+            vm_set_max_depth(max_depth);
+        }
+        else if(strncmp(argv[i],"--",2)==0){ usage(argv[0]); return 1; }
+        else path=argv[i];
+    }
 
-    if(argc>=2){
-        source = read_file(argv[1], &slen);
-        if(!source){ fprintf(stderr,"No pude leer %s\n", argv[1]); return 1; }
+    if(path){
+        source = read_file(path, &slen);
+        if(!source){ fprintf(stderr,"No pude leer %s\n", path); return 1; }
     } else {
         printf("Escribe tu programa Celer completo y presiona Ctrl+D (Unix) / Ctrl+Z (Windows) para ejecutar:\n");
         source = read_stdin_all();
@@ -57,12 +131,61 @@ int main(int argc, char **argv){
     }
 
     env_t *global = env_new(NULL);
-    (void)eval_program(global, &P);
+    resolve_program(&P, global);
+    eval_register_builtins(global);
+
+    parse_error_list terrs = { NULL, 0, 0 };
+    if(!typecheck_program(&P, global, true, &terrs)){
+        fprintf(stderr,"Errores de tipo: %zu\n", terrs.count);
+        for(size_t i=0;i<terrs.count;i++){
+            fprintf(stderr," @%d:%d %s\n", terrs.items[i].line, terrs.items[i].col, terrs.items[i].message);
+        }
+        typecheck_errors_free(&terrs);
+        env_free(global); program_free(&P); parser_dispose(&ps); free(source);
+        return 2;
+    }
+    if(dump_ast){ printf("==== AST ====\n"); ast_print_program(&P); }
+    if(optimize){
+        // --profile mide por función: sin expandir, cada una conserva su fila
+        if(inline_calls && !profile) inline_program(&P, global);
+        optimize_program(&P);
+        if(dump_ast){ printf("==== AST optimizado ====\n"); ast_print_program(&P); }
+    }
+    if(emit_c){
+        bool wrote = emit_c_program(&P, max_depth, stdout);
+        env_free(global); program_free(&P); parser_dispose(&ps); free(source);
+        return wrote ? 0 : 1;
+    }
+    // --profile, --sample y --stats miden en el intérprete: el código nativo no
+    // pasa por los hooks, los puntos de muestreo ni los contadores, así que
+    // con cualquiera de ellos no se activa el JIT.
+    if(profile) prof_enable();
+    else if(use_jit && !sample && !stats) jit_enable(global);
+    if(sample && !prof_sample_start(sample_us)){
+        fprintf(stderr,"--sample no está disponible en esta plataforma\n");
+        sample=false;
+    }
+    bool ran_ok = use_vm ? run_with_vm(global, &P)
+                         : eval_program(global, &P).sig != SIG_RUNTIME_ERROR;
+    if(sample) prof_sample_stop();
+    if(profile){
+        fflush(stdout);
+        prof_report(stderr);
+        if(profile_out && !prof_write_collapsed(profile_out))
+            fprintf(stderr,"No pude escribir %s\n", profile_out);
+    }
+    if(sample){
+        fflush(stdout);
+        prof_sample_report(stderr, source, slen? slen: strlen(source));
+    }
+    if(profile || sample) prof_release();
+    if(stats){ fflush(stdout); stats_report(stderr); }
 
     // Limpieza
+    jit_release();
     env_free(global);
     program_free(&P);
     parser_dispose(&ps);
     free(source);
-    return 0;
+    return ran_ok ? 0 : 3;
 }
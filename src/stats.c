@@ -0,0 +1,37 @@
+#include "../include/stats.h"
+#include <string.h>
+
+celer_stats g_stats;
+
+static double avg_depth(void){
+    return g_stats.lookups ? (double)g_stats.hops / (double)g_stats.lookups : 0.0;
+}
+
+bool stats_get(const char *name, double *out){
+    if(!name) return false;
+    if(strcmp(name, "allocs") == 0)          *out = (double)g_stats.allocs;
+    else if(strcmp(name, "frees") == 0)      *out = (double)g_stats.frees;
+    else if(strcmp(name, "bytes") == 0)      *out = (double)g_stats.bytes;
+    else if(strcmp(name, "live_bytes") == 0) *out = (double)g_stats.live_bytes;
+    else if(strcmp(name, "peak_bytes") == 0) *out = (double)g_stats.peak_bytes;
+    else if(strcmp(name, "frames") == 0)     *out = (double)g_stats.frames;
+    else if(strcmp(name, "lookups") == 0)    *out = (double)g_stats.lookups;
+    else if(strcmp(name, "avg_depth") == 0)  *out = avg_depth();
+    else return false;
+    return true;
+}
+
+void stats_summary(char *buf, size_t n){
+    snprintf(buf, n, "allocs=%llu frees=%llu bytes=%llu live_bytes=%zu peak_bytes=%zu frames=%llu lookups=%llu avg_depth=%.2f",
+             g_stats.allocs, g_stats.frees, g_stats.bytes, g_stats.live_bytes, g_stats.peak_bytes,
+             g_stats.frames, g_stats.lookups, avg_depth());
+}
+
+void stats_report(FILE *out){
+    fprintf(out, "Estadísticas del runtime:\n");
+    fprintf(out, "  reservas          %12llu (%llu liberaciones)\n", g_stats.allocs, g_stats.frees);
+    fprintf(out, "  bytes reservados  %12llu\n", g_stats.bytes);
+    fprintf(out, "  bytes vivos       %12zu (pico %zu)\n", g_stats.live_bytes, g_stats.peak_bytes);
+    fprintf(out, "  entornos creados  %12llu\n", g_stats.frames);
+    fprintf(out, "  accesos a vars    %12llu (profundidad media %.2f)\n", g_stats.lookups, avg_depth());
+}
@@ -1,20 +1,6 @@
 #include "../include/token.h"
 
 #include <string.h>
-#include <stdlib.h>
-
-// strdup no es estándar, implementamos una versión local.
-static char *celer_strdup_n(const char *s, size_t n) {
-    char *p = (char*)malloc(n + 1u);
-    if (!p) return NULL;
-    if (n) memcpy(p, s, n);
-    p[n] = '\0';
-    return p;
-}
-
-static char *celer_strdup(const char *s) {
-    return celer_strdup_n(s, s ? strlen(s) : 0u);
-}
 
 // ---- Tabla de nombres de tipos ----
 const char *token_type_name(token_type t) {
@@ -86,79 +72,90 @@ const char *token_type_name(token_type t) {
 token_t token_make(token_type type, const char *start, size_t length, int line, int column) {
     token_t t;
     t.type = type;
-    t.lexeme = celer_strdup_n(start ? start : "", length);
-    t.length = t.lexeme ? length : 0u;
+    t.lexeme = start ? start : "";
+    t.length = start ? length : 0u;
     t.line = line;
     t.column = column;
     return t;
 }
 
 token_t token_from_cstr(token_type type, const char *cstr, int line, int column) {
-    token_t t;
-    size_t n = cstr ? strlen(cstr) : 0u;
-    t.type = type;
-    t.lexeme = celer_strdup(cstr ? cstr : "");
-    t.length = t.lexeme ? n : 0u;
-    t.line = line;
-    t.column = column;
-    return t;
+    return token_make(type, cstr ? cstr : "", cstr ? strlen(cstr) : 0u, line, column);
 }
 
 token_t token_copy(const token_t *src) {
     if (!src) {
-        token_t z = { TOK_ILLEGAL, NULL, 0u, 0, 0 };
+        token_t z = { TOK_ILLEGAL, "", 0u, 0, 0 };
         return z;
     }
-    token_t t;
-    t.type = src->type;
-    t.lexeme = celer_strdup(src->lexeme ? src->lexeme : "");
-    t.length = src->lexeme ? src->length : 0u;
-    t.line = src->line;
-    t.column = src->column;
-    return t;
+    return *src;
 }
 
 void token_free(token_t *tok) {
     if (!tok) return;
-    free(tok->lexeme);
     tok->lexeme = NULL;
     tok->length = 0u;
     tok->type = TOK_ILLEGAL;
     tok->line = tok->column = 0;
 }
 
+int token_lexeme_is(const token_t *tok, const char *cstr) {
+    size_t n = strlen(cstr);
+    return tok->lexeme && tok->length == n && memcmp(tok->lexeme, cstr, n) == 0;
+}
+
 // ---- Keyword lookup ----
 // Importante: sensible a mayúsculas.
 // - "Function" (F mayúscula) es keyword. "function" NO lo es.
 // - true/false los tratamos como keywords dedicadas (TOK_TRUE/TOK_FALSE)
-typedef struct { const char *kw; token_type t; } kw_pair;
-
-static const kw_pair KW_TABLE[] = {
-    {"Function", TOK_Function},
-    {"variable", TOK_VARIABLE},
-    {"const",    TOK_CONST},
-    {"return",   TOK_RETURN},
-    {"for",      TOK_FOR},
-    {"if",       TOK_IF},
-    {"else",     TOK_ELSE},
-    {"break",    TOK_BREAK},
-    {"continue", TOK_CONTINUE},
-    {"int",      TOK_INT},
-    {"bool",     TOK_BOOL},
-    {"float",    TOK_FLOAT},
-    {"string",   TOK_STRING},
-    {"true",     TOK_TRUE},
-    {"false",    TOK_FALSE},
-};
+// Despacho por (longitud, primer carácter): a lo sumo una comparación de
+// bytes por identificador. Al agregar una keyword, añadir su caso aquí.
+#define KW(s, tok) (memcmp(ident, (s), sizeof(s) - 1u) == 0 ? (tok) : TOK_IDENT)
 
 token_type token_keyword_lookup(const char *ident, size_t len) {
     if (!ident) return TOK_IDENT;
-    for (size_t i = 0; i < sizeof(KW_TABLE)/sizeof(KW_TABLE[0]); ++i) {
-        const char *k = KW_TABLE[i].kw;
-        if (strlen(k) == len && strncmp(ident, k, len) == 0) {
-            return KW_TABLE[i].t;
-        }
+    switch (len) {
+        case 2:
+            if (ident[0] == 'i') return KW("if", TOK_IF);
+            break;
+        case 3:
+            if (ident[0] == 'f') return KW("for", TOK_FOR);
+            if (ident[0] == 'i') return KW("int", TOK_INT);
+            break;
+        case 4:
+            switch (ident[0]) {
+                case 'e': return KW("else", TOK_ELSE);
+                case 'b': return KW("bool", TOK_BOOL);
+                case 't': return KW("true", TOK_TRUE);
+                default: break;
+            }
+            break;
+        case 5:
+            switch (ident[0]) {
+                case 'c': return KW("const", TOK_CONST);
+                case 'b': return KW("break", TOK_BREAK);
+                case 'f':
+                    if (ident[1] == 'l') return KW("float", TOK_FLOAT);
+                    return KW("false", TOK_FALSE);
+                default: break;
+            }
+            break;
+        case 6:
+            if (ident[0] == 'r') return KW("return", TOK_RETURN);
+            if (ident[0] == 's') return KW("string", TOK_STRING);
+            break;
+        case 8:
+            switch (ident[0]) {
+                case 'F': return KW("Function", TOK_Function);
+                case 'v': return KW("variable", TOK_VARIABLE);
+                case 'c': return KW("continue", TOK_CONTINUE);
+                default: break;
+            }
+            break;
+        default: break;
     }
     return TOK_IDENT;
 }
 
+#undef KW
+
@@ -0,0 +1,659 @@
+#include "../include/typecheck.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    type_kind t;        // tipo garantizado (TYPE_UNKNOWN si no)
+    type_kind declared; // tipo declarado (TYPE_UNKNOWN si no hay)
+    bool set;           // ya recibió algún valor
+    bool seen;          // asignado en la pasada actual
+} tc_slot;
+
+typedef struct {
+    func_decl *fn;
+    tc_slot *slots; size_t nslots; // params + locales de todos los bloques (ids únicos)
+    type_kind ret;                 // tipo de sus llamadas
+    bool trusted;                  // nombre único y no tapado por un builtin
+} tc_func;
+
+typedef struct {
+    const char *name;
+    type_kind declared;
+    type_kind t;
+    size_t decl_index;
+    bool in_funcs;      // fiable dentro de funciones (ver optimizer.c)
+    bool trusted;
+} tc_global;
+
+// Índice de nombres de nivel superior, armado una vez antes de las pasadas.
+typedef struct {
+    const char *name;   // NULL = vacío
+    size_t uses;        // declaraciones con este nombre
+    tc_global *global;  // la primera de cada clase
+    tc_func *func;
+} tc_name;
+
+typedef struct {
+    program_ast *P;
+    env_t *global;
+    bool closed;
+    tc_func *funcs; size_t nfuncs;
+    tc_global *globals; size_t nglobals;
+    tc_name *names; size_t names_cap;   // hash abierto, cap potencia de 2
+    tc_func **decl_funcs;               // decls[i] -> su tc_func
+
+    tc_func *cur;       // función en curso (NULL en inicializadores globales)
+    size_t cur_decl;
+    int *frames; size_t frames_count, frames_cap; // base de slots por frame
+    int next_base;
+    int cond_depth;     // >0: código que puede no ejecutarse
+
+    bool changed;
+    bool report;        // última pasada: registrar errores
+    parse_error_list *errs;
+} tc_t;
+
+// ---------------- utils ----------------
+static const char *tname(type_kind k){
+    switch(k){
+        case TYPE_VOID: return "void";
+        case TYPE_INT: return "int";
+        case TYPE_BOOL: return "bool";
+        case TYPE_FLOAT: return "float";
+        case TYPE_STRING: return "string";
+        case TYPE_ARRAY_INT: return "int[]";
+        case TYPE_ARRAY_FLOAT: return "float[]";
+        case TYPE_ARRAY_BOOL: return "bool[]";
+        default: return "?";
+    }
+}
+
+static const char *opname(op_kind op){
+    switch(op){
+        case OP_ADD: case OP_PLUS_ASSIGN: return "+";
+        case OP_SUB: case OP_MINUS_ASSIGN: return "-";
+        case OP_MUL: case OP_STAR_ASSIGN: return "*";
+        case OP_DIV: case OP_SLASH_ASSIGN: return "/";
+        case OP_MOD: case OP_PERCENT_ASSIGN: return "%";
+        case OP_EQ: return "=="; case OP_NEQ: return "!=";
+        case OP_LT: return "<"; case OP_LTE: return "<=";
+        case OP_GT: return ">"; case OP_GTE: return ">=";
+        case OP_AND: return "&&"; case OP_OR: return "||"; case OP_NOT: return "!";
+        default: return "?";
+    }
+}
+
+static void tc_error(tc_t *tc, int line, int col, const char *fmt, ...){
+    if(!tc->report) return;
+    char msg[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    parse_error_list *l = tc->errs;
+    if(l->count==l->cap){ size_t nc=l->cap?l->cap*2u:4u; l->items=(parse_error*)realloc(l->items, nc*sizeof(parse_error)); l->cap=nc; }
+    l->items[l->count].line = line;
+    l->items[l->count].col  = col;
+    size_t n = strlen(msg);
+    l->items[l->count].message = (char*)malloc(n+1);
+    if(l->items[l->count].message) memcpy(l->items[l->count].message, msg, n+1);
+    l->count++;
+}
+
+static bool is_known(type_kind t){ return t != TYPE_UNKNOWN; }
+static bool is_numeric(type_kind t){ return t == TYPE_INT || t == TYPE_FLOAT; }
+
+// ¿Es un literal int (posiblemente negado o entre paréntesis)?
+static bool is_int_const(const expr *e){
+    switch(e->kind){
+        case EXPR_INT_LIT: return true;
+        case EXPR_GROUPING: return is_int_const(e->as.grouping.inner);
+        case EXPR_UNARY: return e->as.unary.op == OP_SUB && is_int_const(e->as.unary.right);
+        default: return false;
+    }
+}
+static void widen_int_const(expr *e){
+    switch(e->kind){
+        case EXPR_INT_LIT: {
+            double d = (double)e->as.int_lit.value;
+            e->kind = EXPR_FLOAT_LIT;
+            e->as.float_lit.value = d;
+            break;
+        }
+        case EXPR_GROUPING: widen_int_const(e->as.grouping.inner); break;
+        case EXPR_UNARY: widen_int_const(e->as.unary.right); break;
+        default: break;
+    }
+    e->type = TYPE_FLOAT;
+}
+
+// Verifica que `e` (de tipo t) pueda ir donde se espera `want`.
+// Devuelve el tipo resultante (tras convertir literales int a float).
+// Un literal de array toma el tipo esperado si es `[]` o si es int[] y se
+// espera float[] (el tipo del literal decide cómo se construye).
+static type_kind coerce_to(tc_t *tc, expr *e, type_kind t, type_kind want){
+    if(e && e->kind == EXPR_ARRAY && type_is_array(want)
+       && (e->as.array.items.count == 0 || (t == TYPE_ARRAY_INT && want == TYPE_ARRAY_FLOAT))){
+        for(size_t i=0;i<e->as.array.items.count;i++)
+            if(is_int_const(e->as.array.items.items[i])) widen_int_const(e->as.array.items.items[i]);
+        e->type = want;
+        return want;
+    }
+    if(!is_known(want) || !is_known(t) || t == want) return t;
+    if(want == TYPE_FLOAT && t == TYPE_INT && is_int_const(e)){
+        widen_int_const(e);
+        return TYPE_FLOAT;
+    }
+    tc_error(tc, e->line, e->col, "Tipos incompatibles: se esperaba %s, se obtuvo %s", tname(want), tname(t));
+    return t;
+}
+
+// Une un tipo nuevo al de una variable; cualquier discrepancia la deja sin tipo.
+static void join(tc_t *tc, type_kind *slot_t, bool *set, type_kind t){
+    if(!*set){ *set = true; *slot_t = t; tc->changed = true; return; }
+    if(*slot_t != t && *slot_t != TYPE_UNKNOWN){ *slot_t = TYPE_UNKNOWN; tc->changed = true; }
+}
+
+static size_t hash_name(const char *s){
+    size_t h = 2166136261u; // FNV-1a
+    for(; *s; s++){ h ^= (unsigned char)*s; h *= 16777619u; }
+    return h;
+}
+
+// Entrada de `name` (vacía si no está).
+static tc_name *name_slot(tc_t *tc, const char *name){
+    size_t h = hash_name(name) & (tc->names_cap - 1u);
+    while(tc->names[h].name && strcmp(tc->names[h].name, name) != 0) h = (h + 1u) & (tc->names_cap - 1u);
+    return &tc->names[h];
+}
+
+static tc_global *find_global(tc_t *tc, const char *name){
+    return name_slot(tc, name)->global;
+}
+static tc_func *find_func(tc_t *tc, const char *name){
+    return name_slot(tc, name)->func;
+}
+
+static tc_slot *slot_of(tc_t *tc, int depth, int slot){
+    if(!tc->cur || depth < 0 || (size_t)depth >= tc->frames_count) return NULL;
+    int id = tc->frames[tc->frames_count - 1 - (size_t)depth] + slot;
+    if(id < 0 || (size_t)id >= tc->cur->nslots) return NULL;
+    return &tc->cur->slots[id];
+}
+
+static void push_frame(tc_t *tc, int nslots){
+    if(tc->frames_count==tc->frames_cap){
+        size_t nc=tc->frames_cap?tc->frames_cap*2u:8u;
+        tc->frames=(int*)realloc(tc->frames, nc*sizeof(int));
+        tc->frames_cap=nc;
+    }
+    tc->frames[tc->frames_count++] = tc->next_base;
+    tc->next_base += nslots;
+}
+
+// ---------------- tipos de operaciones ----------------
+static type_kind binary_type(tc_t *tc, const expr *at, op_kind op, type_kind L, type_kind R){
+    switch(op){
+        case OP_EQ: case OP_NEQ: case OP_AND: case OP_OR:
+            return TYPE_BOOL; // siempre devuelven bool
+        default: break;
+    }
+    if(!is_known(L) || !is_known(R)) return TYPE_UNKNOWN;
+    switch(op){
+        case OP_ADD: case OP_PLUS_ASSIGN:
+            if(L == TYPE_STRING && R == TYPE_STRING) return TYPE_STRING;
+            /* fallthrough */
+        case OP_SUB: case OP_MUL: case OP_DIV:
+        case OP_MINUS_ASSIGN: case OP_STAR_ASSIGN: case OP_SLASH_ASSIGN:
+            if(L == TYPE_INT && R == TYPE_INT) return TYPE_INT;
+            if(is_numeric(L) && is_numeric(R)) return TYPE_FLOAT;
+            break;
+        case OP_MOD: case OP_PERCENT_ASSIGN:
+            if(L == TYPE_INT && R == TYPE_INT) return TYPE_INT;
+            break;
+        case OP_LT: case OP_LTE: case OP_GT: case OP_GTE:
+            if(is_numeric(L) && is_numeric(R)) return TYPE_BOOL;
+            break;
+        default: break;
+    }
+    tc_error(tc, at->line, at->col, "Operación '%s' inválida entre %s y %s", opname(op), tname(L), tname(R));
+    return TYPE_UNKNOWN;
+}
+
+// ---------------- recorrido ----------------
+static type_kind tc_expr(tc_t *tc, expr *e);
+static void tc_stmt(tc_t *tc, stmt *s);
+
+// Tipo de un global leído por nombre desde el punto actual.
+static type_kind global_type(tc_t *tc, const char *name){
+    if(!tc->closed) return TYPE_UNKNOWN;
+    tc_global *g = find_global(tc, name);
+    if(!g || !g->trusted) return TYPE_UNKNOWN;
+    // un global sólo existe tras su declaración
+    if(tc->cur ? !g->in_funcs : g->decl_index >= tc->cur_decl) return TYPE_UNKNOWN;
+    return g->t;
+}
+
+static type_kind tc_ident(tc_t *tc, expr *e){
+    if(e->as.ident.depth >= 0){
+        tc_slot *sl = slot_of(tc, e->as.ident.depth, e->as.ident.slot);
+        return (sl && sl->set) ? sl->t : TYPE_UNKNOWN;
+    }
+    return global_type(tc, e->as.ident.name);
+}
+
+static type_kind tc_assign(tc_t *tc, expr *e){
+    type_kind V = tc_expr(tc, e->as.assign.value);
+    op_kind op = e->as.assign.op;
+    type_kind decl_t = e->as.assign.decl_type.kind;
+
+    if(e->as.assign.depth >= 0){
+        tc_slot *sl = slot_of(tc, e->as.assign.depth, e->as.assign.slot);
+        if(!sl) return TYPE_UNKNOWN;
+        if(!sl->seen && !sl->set && is_known(decl_t)) sl->declared = decl_t;
+        else if(is_known(decl_t) && is_known(sl->declared) && decl_t != sl->declared)
+            tc_error(tc, e->line, e->col, "Variable %s redeclarada con otro tipo (%s)", e->as.assign.name, tname(sl->declared));
+        type_kind want = is_known(decl_t) ? decl_t : sl->declared;
+        type_kind out;
+        if(op == OP_ASSIGN){
+            out = coerce_to(tc, e->as.assign.value, V, want);
+        } else {
+            type_kind cur = sl->set ? sl->t : TYPE_UNKNOWN;
+            out = binary_type(tc, e, op, cur, V);
+            if(is_known(want) && is_known(out) && out != want)
+                tc_error(tc, e->line, e->col, "Tipos incompatibles: se esperaba %s, se obtuvo %s", tname(want), tname(out));
+        }
+        // la asignación que define el slot debe ejecutarse siempre
+        if(!sl->seen && tc->cond_depth > 0) out = TYPE_UNKNOWN;
+        sl->seen = true;
+        join(tc, &sl->t, &sl->set, out);
+        return out;
+    }
+
+    // global por nombre
+    tc_global *g = tc->closed ? find_global(tc, e->as.assign.name) : NULL;
+    type_kind out;
+    if(op == OP_ASSIGN){
+        out = coerce_to(tc, e->as.assign.value, V, g ? g->declared : TYPE_UNKNOWN);
+    } else {
+        out = binary_type(tc, e, op, global_type(tc, e->as.assign.name), V);
+        if(g && is_known(out) && out != g->declared)
+            tc_error(tc, e->line, e->col, "Tipos incompatibles: se esperaba %s, se obtuvo %s", tname(g->declared), tname(out));
+    }
+    if(g){
+        bool set = true;
+        join(tc, &g->t, &set, out);
+    }
+    return out;
+}
+
+// len() y push() de los arrays; el resto de los builtins no tiene tipo.
+static type_kind tc_builtin(tc_t *tc, expr *e, const char *name, type_kind *args){
+    size_t argc = e->as.call.args.count;
+    if(strcmp(name, "len") == 0 && argc == 1){
+        if(type_is_array(args[0]) || args[0] == TYPE_STRING) return TYPE_INT;
+        if(is_known(args[0])) tc_error(tc, e->line, e->col, "len() espera un array o un string, se obtuvo %s", tname(args[0]));
+    } else if(strcmp(name, "push") == 0 && argc == 2){
+        if(type_is_array(args[0])) (void)coerce_to(tc, e->as.call.args.items[1], args[1], type_elem_of(args[0]));
+        else if(is_known(args[0])) tc_error(tc, e->line, e->col, "push() espera un array, se obtuvo %s", tname(args[0]));
+    }
+    return TYPE_UNKNOWN;
+}
+
+// [a, b, ...]: todos int, todos bool, o int y float mezclados (float[]).
+static type_kind tc_array(tc_t *tc, expr *e){
+    type_kind elem = TYPE_UNKNOWN;
+    bool known = true;
+    for(size_t i=0;i<e->as.array.items.count;i++){
+        expr *it = e->as.array.items.items[i];
+        type_kind t = tc_expr(tc, it);
+        if(!is_known(t)){ known = false; continue; }
+        if(t != TYPE_INT && t != TYPE_FLOAT && t != TYPE_BOOL){
+            tc_error(tc, it->line, it->col, "Los arrays sólo admiten int, float o bool, se obtuvo %s", tname(t));
+            known = false;
+        } else if(elem == TYPE_UNKNOWN || elem == t){
+            elem = t;
+        } else if(is_numeric(elem) && is_numeric(t)){
+            elem = TYPE_FLOAT;
+        } else {
+            tc_error(tc, it->line, it->col, "Elementos de tipos incompatibles en el array (%s y %s)", tname(elem), tname(t));
+            known = false;
+        }
+    }
+    return known ? type_array_of(elem) : TYPE_UNKNOWN;
+}
+
+// Tipo del elemento de target[index] (chequea ambos).
+static type_kind tc_element(tc_t *tc, expr *at, expr *target, expr *index){
+    type_kind T = tc_expr(tc, target);
+    type_kind I = tc_expr(tc, index);
+    if(is_known(I) && I != TYPE_INT)
+        tc_error(tc, index->line, index->col, "El índice de un array debe ser int, se obtuvo %s", tname(I));
+    if(is_known(T) && !type_is_array(T)){
+        tc_error(tc, at->line, at->col, "Sólo se pueden indexar arrays, se obtuvo %s", tname(T));
+        return TYPE_UNKNOWN;
+    }
+    return type_elem_of(T);
+}
+
+static type_kind tc_index_assign(tc_t *tc, expr *e){
+    type_kind elem = tc_element(tc, e, e->as.index_assign.target, e->as.index_assign.index);
+    type_kind V = tc_expr(tc, e->as.index_assign.value);
+    op_kind op = e->as.index_assign.op;
+    if(!is_known(elem)) return TYPE_UNKNOWN;
+    if(op == OP_ASSIGN){
+        (void)coerce_to(tc, e->as.index_assign.value, V, elem);
+    } else {
+        type_kind out = binary_type(tc, e, op, elem, V);
+        if(is_known(out) && out != elem)
+            tc_error(tc, e->line, e->col, "Tipos incompatibles: se esperaba %s, se obtuvo %s", tname(elem), tname(out));
+    }
+    return elem; // el valor queda con el tipo del array
+}
+
+static type_kind tc_call(tc_t *tc, expr *e){
+    size_t argc = e->as.call.args.count;
+    type_kind *args = argc ? (type_kind*)malloc(argc * sizeof(type_kind)) : NULL;
+    for(size_t i=0;i<argc;i++) args[i] = tc_expr(tc, e->as.call.args.items[i]);
+
+    type_kind out = TYPE_UNKNOWN;
+    if(e->as.call.callee->kind != EXPR_IDENT){ free(args); return out; }
+    const char *name = e->as.call.callee->as.ident.name;
+
+    // los builtins tienen prioridad y son variádicos
+    if(tc->global && env_get_builtin(tc->global, name)){
+        out = tc_builtin(tc, e, name, args);
+        free(args);
+        return out;
+    }
+
+    tc_func *f = find_func(tc, name);
+    func_decl *fn = f ? f->fn : (tc->global ? env_get_func(tc->global, name) : NULL);
+    if(!fn){
+        if(tc->closed) tc_error(tc, e->line, e->col, "Función no definida: %s", name);
+        free(args);
+        return out;
+    }
+    if(fn->params.count != argc)
+        tc_error(tc, e->line, e->col, "Número de argumentos inválido en %s: se esperaban %zu, se obtuvieron %zu",
+                 name, fn->params.count, argc);
+    for(size_t i=0;i<argc && i<fn->params.count;i++){
+        type_kind want = fn->params.items[i].type.kind;
+        type_kind got = coerce_to(tc, e->as.call.args.items[i], args[i], want);
+        // un argumento sin tipo garantizado quita el tipo al parámetro
+        if(f && f->trusted && tc->closed && got != want && f->slots[i].t != TYPE_UNKNOWN){
+            f->slots[i].t = TYPE_UNKNOWN;
+            tc->changed = true;
+        }
+    }
+    if(f && f->trusted && tc->closed) out = f->ret;
+    free(args);
+    return out;
+}
+
+static type_kind tc_expr(tc_t *tc, expr *e){
+    if(!e) return TYPE_UNKNOWN;
+    type_kind t = TYPE_UNKNOWN;
+    switch(e->kind){
+        case EXPR_IDENT: t = tc_ident(tc, e); break;
+        case EXPR_INT_LIT: t = TYPE_INT; break;
+        case EXPR_FLOAT_LIT: t = TYPE_FLOAT; break;
+        case EXPR_BOOL_LIT: t = TYPE_BOOL; break;
+        case EXPR_STRING_LIT: t = TYPE_STRING; break;
+        case EXPR_GROUPING: t = tc_expr(tc, e->as.grouping.inner); break;
+        case EXPR_UNARY: {
+            type_kind R = tc_expr(tc, e->as.unary.right);
+            if(e->as.unary.op == OP_NOT) t = TYPE_BOOL;
+            else if(e->as.unary.op == OP_SUB){
+                if(is_numeric(R)) t = R;
+                else if(is_known(R)) tc_error(tc, e->line, e->col, "Operación '-' inválida para %s", tname(R));
+            }
+            break;
+        }
+        case EXPR_BINARY: {
+            type_kind L = tc_expr(tc, e->as.binary.left);
+            // && / || en cortocircuito: el lado derecho puede no ejecutarse
+            bool lazy = e->as.binary.op == OP_AND || e->as.binary.op == OP_OR;
+            if(lazy) tc->cond_depth++;
+            type_kind R = tc_expr(tc, e->as.binary.right);
+            if(lazy) tc->cond_depth--;
+            t = binary_type(tc, e, e->as.binary.op, L, R);
+            break;
+        }
+        case EXPR_ASSIGN: t = tc_assign(tc, e); break;
+        case EXPR_TERNARY: {
+            (void)tc_expr(tc, e->as.ternary.cond);
+            tc->cond_depth++;
+            type_kind a = tc_expr(tc, e->as.ternary.when_true);
+            type_kind b = tc_expr(tc, e->as.ternary.when_false);
+            tc->cond_depth--;
+            t = (a == b) ? a : TYPE_UNKNOWN;
+            break;
+        }
+        case EXPR_CALL: t = tc_call(tc, e); break;
+        case EXPR_ARRAY: t = tc_array(tc, e); break;
+        case EXPR_INDEX: t = tc_element(tc, e, e->as.index.target, e->as.index.index); break;
+        case EXPR_INDEX_ASSIGN: t = tc_index_assign(tc, e); break;
+    }
+    e->type = t;
+    return t;
+}
+
+// ¿Toda ejecución del stmt termina en return?
+static bool always_returns(const stmt *s){
+    if(!s) return false;
+    switch(s->kind){
+        case STMT_RETURN: return true;
+        case STMT_BLOCK:
+            for(size_t i=0;i<s->as.block.stmts.count;i++)
+                if(always_returns(s->as.block.stmts.items[i])) return true;
+            return false;
+        case STMT_IF:
+            return always_returns(s->as.if_stmt.then_branch) && always_returns(s->as.if_stmt.else_branch);
+        default: return false;
+    }
+}
+
+static void tc_branch(tc_t *tc, stmt *s){
+    // un bloque abre su propio frame; otra sentencia definiría en el actual
+    if(s && s->kind != STMT_BLOCK){ tc->cond_depth++; tc_stmt(tc, s); tc->cond_depth--; }
+    else tc_stmt(tc, s);
+}
+
+static void tc_stmt(tc_t *tc, stmt *s){
+    if(!s) return;
+    switch(s->kind){
+        case STMT_EXPR: (void)tc_expr(tc, s->as.expr_stmt.value); break;
+        case STMT_RETURN: {
+            type_kind want = tc->cur ? tc->cur->fn->ret_type.kind : TYPE_UNKNOWN;
+            if(!s->as.ret.value){
+                if(tc->cur && want != TYPE_VOID)
+                    tc_error(tc, s->line, s->col, "return sin valor en función que retorna %s", tname(want));
+                break;
+            }
+            type_kind t = tc_expr(tc, s->as.ret.value);
+            if(tc->cur && want == TYPE_VOID){
+                tc_error(tc, s->line, s->col, "return con valor en función void");
+                break;
+            }
+            t = coerce_to(tc, s->as.ret.value, t, want);
+            if(tc->cur && t != want && tc->cur->ret != TYPE_UNKNOWN){
+                tc->cur->ret = TYPE_UNKNOWN;
+                tc->changed = true;
+            }
+            break;
+        }
+        case STMT_BREAK: case STMT_CONTINUE: break;
+        case STMT_BLOCK:
+            push_frame(tc, s->as.block.nslots);
+            for(size_t i=0;i<s->as.block.stmts.count;i++) tc_stmt(tc, s->as.block.stmts.items[i]);
+            tc->frames_count--;
+            break;
+        case STMT_IF:
+            (void)tc_expr(tc, s->as.if_stmt.cond);
+            tc_branch(tc, s->as.if_stmt.then_branch);
+            tc_branch(tc, s->as.if_stmt.else_branch);
+            break;
+        case STMT_FOR_WHILELIKE:
+            (void)tc_expr(tc, s->as.for_while.cond);
+            tc_branch(tc, s->as.for_while.body);
+            break;
+        case STMT_FOR_CLIKE:
+            tc_stmt(tc, s->as.for_clike.init);
+            (void)tc_expr(tc, s->as.for_clike.cond);
+            // el post sólo corre tras una vuelta del cuerpo
+            tc->cond_depth++;
+            (void)tc_expr(tc, s->as.for_clike.post);
+            tc->cond_depth--;
+            tc_branch(tc, s->as.for_clike.body);
+            break;
+    }
+}
+
+static int count_slots(const stmt *s){
+    if(!s) return 0;
+    switch(s->kind){
+        case STMT_BLOCK: {
+            int n = s->as.block.nslots;
+            for(size_t i=0;i<s->as.block.stmts.count;i++) n += count_slots(s->as.block.stmts.items[i]);
+            return n;
+        }
+        case STMT_IF: return count_slots(s->as.if_stmt.then_branch) + count_slots(s->as.if_stmt.else_branch);
+        case STMT_FOR_WHILELIKE: return count_slots(s->as.for_while.body);
+        case STMT_FOR_CLIKE: return count_slots(s->as.for_clike.init) + count_slots(s->as.for_clike.body);
+        default: return 0;
+    }
+}
+
+static bool has_call(const expr *e){
+    if(!e) return false;
+    switch(e->kind){
+        case EXPR_CALL:     return true;
+        case EXPR_ASSIGN:   return has_call(e->as.assign.value);
+        case EXPR_UNARY:    return has_call(e->as.unary.right);
+        case EXPR_BINARY:   return has_call(e->as.binary.left) || has_call(e->as.binary.right);
+        case EXPR_GROUPING: return has_call(e->as.grouping.inner);
+        case EXPR_TERNARY:
+            return has_call(e->as.ternary.cond) || has_call(e->as.ternary.when_true)
+                || has_call(e->as.ternary.when_false);
+        case EXPR_ARRAY:
+            for(size_t i=0;i<e->as.array.items.count;i++) if(has_call(e->as.array.items.items[i])) return true;
+            return false;
+        case EXPR_INDEX: return has_call(e->as.index.target) || has_call(e->as.index.index);
+        case EXPR_INDEX_ASSIGN:
+            return has_call(e->as.index_assign.target) || has_call(e->as.index_assign.index)
+                || has_call(e->as.index_assign.value);
+        default: return false;
+    }
+}
+
+// Una pasada completa sobre el programa.
+static void tc_pass(tc_t *tc){
+    for(size_t i=0;i<tc->P->decls.count;i++){
+        decl *d = tc->P->decls.items[i];
+        tc->cur_decl = i;
+        if(d->kind == DECL_VAR){
+            tc->cur = NULL;
+            type_kind t = tc_expr(tc, d->as.var.init);
+            if(d->as.var.init) t = coerce_to(tc, d->as.var.init, t, d->as.var.type.kind);
+            tc_global *g = tc->closed ? find_global(tc, d->as.var.name) : NULL;
+            if(g && g->decl_index == i && t != g->declared && g->t != TYPE_UNKNOWN){
+                g->t = TYPE_UNKNOWN;
+                tc->changed = true;
+            }
+        } else {
+            tc_func *f = tc->decl_funcs[i];
+            tc->cur = f;
+            tc->frames_count = 0;
+            tc->next_base = 0;
+            tc->cond_depth = 0;
+            for(size_t j=0;j<f->nslots;j++) f->slots[j].seen = false;
+            push_frame(tc, (int)d->as.func.params.count);
+            tc_stmt(tc, d->as.func.body);
+            tc->cur = NULL;
+        }
+    }
+}
+
+bool typecheck_program(program_ast *P, env_t *global, bool closed_world, parse_error_list *errs){
+    tc_t tc;
+    memset(&tc, 0, sizeof(tc));
+    tc.P = P; tc.global = global; tc.closed = closed_world; tc.errs = errs;
+    size_t errs_before = errs->count;
+
+    tc.funcs = (tc_func*)calloc(P->decls.count ? P->decls.count : 1u, sizeof(tc_func));
+    tc.globals = (tc_global*)calloc(P->decls.count ? P->decls.count : 1u, sizeof(tc_global));
+    tc.decl_funcs = (tc_func**)calloc(P->decls.count ? P->decls.count : 1u, sizeof(tc_func*));
+    tc.names_cap = 16u;
+    while(tc.names_cap < P->decls.count * 2u) tc.names_cap *= 2u;
+    tc.names = (tc_name*)calloc(tc.names_cap, sizeof(tc_name));
+    // cuántas declaraciones comparten cada nombre
+    for(size_t i=0;i<P->decls.count;i++){
+        const decl *d = P->decls.items[i];
+        tc_name *n = name_slot(&tc, d->kind==DECL_VAR ? d->as.var.name : d->as.func.name);
+        n->name = d->kind==DECL_VAR ? d->as.var.name : d->as.func.name;
+        n->uses++;
+    }
+    bool call_seen = false;
+    for(size_t i=0;i<P->decls.count;i++){
+        decl *d = P->decls.items[i];
+        if(d->kind == DECL_FUNC){
+            func_decl *fn = &d->as.func;
+            tc_func *f = &tc.funcs[tc.nfuncs++];
+            tc_name *n = name_slot(&tc, fn->name);
+            if(!n->func) n->func = f;
+            tc.decl_funcs[i] = f;
+            f->fn = fn;
+            f->trusted = n->uses == 1 && !(global && env_get_builtin(global, fn->name))
+                      && strcmp(fn->name, "main") != 0; // main se llama sin argumentos
+            f->nslots = fn->params.count + (size_t)count_slots(fn->body);
+            f->slots = (tc_slot*)calloc(f->nslots ? f->nslots : 1u, sizeof(tc_slot));
+            for(size_t j=0;j<f->nslots;j++) f->slots[j].t = f->slots[j].declared = TYPE_UNKNOWN;
+            for(size_t j=0;j<fn->params.count;j++){
+                f->slots[j].declared = fn->params.items[j].type.kind;
+                f->slots[j].t = (closed_world && f->trusted) ? f->slots[j].declared : TYPE_UNKNOWN;
+                f->slots[j].set = true;
+            }
+            f->ret = fn->ret_type.kind;
+            if(f->ret != TYPE_VOID && !always_returns(fn->body)) f->ret = TYPE_UNKNOWN;
+        } else {
+            tc_global *g = &tc.globals[tc.nglobals++];
+            tc_name *n = name_slot(&tc, d->as.var.name);
+            if(!n->global) n->global = g;
+            g->name = d->as.var.name;
+            g->declared = d->as.var.type.kind;
+            g->t = d->as.var.init ? g->declared : TYPE_UNKNOWN;
+            g->decl_index = i;
+            g->in_funcs = !call_seen;
+            g->trusted = n->uses == 1;
+            if(has_call(d->as.var.init)) call_seen = true;
+        }
+    }
+
+    // punto fijo: cada cambio fija un slot o lo pasa a TYPE_UNKNOWN y nada
+    // vuelve atrás, así que termina. Cortarlo antes dejaría anotaciones que los
+    // kernels tipados leen sin mirar el kind.
+    do {
+        tc.changed = false;
+        tc_pass(&tc);
+    } while(tc.changed);
+    tc.report = true;
+    tc_pass(&tc);
+
+    for(size_t i=0;i<tc.nfuncs;i++) free(tc.funcs[i].slots);
+    free(tc.funcs);
+    free(tc.globals);
+    free(tc.decl_funcs);
+    free(tc.names);
+    free(tc.frames);
+    return errs->count == errs_before;
+}
+
+void typecheck_errors_free(parse_error_list *errs){
+    for(size_t i=0;i<errs->count;i++) free(errs->items[i].message);
+    free(errs->items);
+    errs->items = NULL;
+    errs->count = errs->cap = 0;
+}
@@ -1,28 +1,164 @@
 #include "../include/value.h"
+#include "../include/stats.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
 
 static char *dup_cstr(const char *s){
-    if(!s){ char *z=(char*)malloc(1); if(z) z[0]='\0'; return z; }
-    size_t n=strlen(s); char *p=(char*)malloc(n+1); if(!p) return NULL; memcpy(p,s,n+1); return p;
+    if(!s){ char *z=(char*)stats_malloc(1); if(z) z[0]='\0'; return z; }
+    size_t n=strlen(s); char *p=(char*)stats_malloc(n+1); if(!p) return NULL; memcpy(p,s,n+1); return p;
 }
 
 value_t v_void(void){ value_t v; v.kind=VAL_VOID; v.as.s=NULL; return v; }
 value_t v_int(long long x){ value_t v; v.kind=VAL_INT; v.as.i=x; return v; }
 value_t v_float(double x){ value_t v; v.kind=VAL_FLOAT; v.as.f=x; return v; }
 value_t v_bool(bool x){ value_t v; v.kind=VAL_BOOL; v.as.b=x; return v; }
-value_t v_string(const char *s){ value_t v; v.kind=VAL_STRING; v.as.s=dup_cstr(s?s:""); return v; }
+// reserva un string de n bytes (contenido a cargo del llamador)
+static celer_str *str_alloc(size_t n){
+    celer_str *s=(celer_str*)stats_malloc(sizeof(celer_str)+n+1);
+    if(!s) return NULL;
+    s->refs=1; s->len=n; s->data[n]='\0';
+    return s;
+}
+value_t v_string_n(const char *s, size_t n){
+    value_t v; v.kind=VAL_STRING;
+    v.as.s=str_alloc(n);
+    if(v.as.s && n) memcpy(v.as.s->data, s, n);
+    return v;
+}
+size_t value_str_bytes(size_t n){ return sizeof(celer_str)+n+1; }
+value_t v_string_at(void *mem, const char *s, size_t n){
+    celer_str *cs=(celer_str*)mem;
+    cs->refs=1; cs->len=n;
+    if(n) memcpy(cs->data, s, n);
+    cs->data[n]='\0';
+    value_t v; v.kind=VAL_STRING; v.as.s=cs; return v;
+}
+value_t v_string(const char *s){ return v_string_n(s?s:"", s?strlen(s):0u); }
+
+// ---------------- arrays ----------------
+static size_t elem_size(value_kind k){ return k == VAL_BOOL ? 1u : k == VAL_VOID ? 0u : 8u; }
+
+static bool array_reserve(celer_array *a, size_t n){
+    if(n <= a->cap) return true;
+    size_t es = elem_size(a->elem), nc = a->cap ? a->cap : 4u;
+    while(nc < n) nc *= 2u;
+    void *p = stats_realloc(a->data.i, a->cap * es, nc * es);
+    if(!p) return false;
+    a->data.i = (long long*)p;
+    a->cap = nc;
+    return true;
+}
+
+value_t v_array(value_kind elem, size_t cap){
+    value_t v = v_void();
+    celer_array *a = (celer_array*)stats_malloc(sizeof(celer_array));
+    if(!a) return v;
+    a->refs = 1; a->elem = elem; a->len = 0; a->cap = 0; a->data.i = NULL;
+    if(elem != VAL_VOID && cap && !array_reserve(a, cap)){ stats_free(a, sizeof(celer_array)); return v; }
+    v.kind = VAL_ARRAY; v.as.a = a;
+    return v;
+}
+
+// Escribe v en data[i] (i < cap); int se promueve en un float[]. false si
+// el tipo no corresponde.
+static bool array_put(celer_array *a, size_t i, const value_t *v){
+    switch(a->elem){
+        case VAL_INT:
+            if(v->kind != VAL_INT) return false;
+            a->data.i[i] = v->as.i; return true;
+        case VAL_FLOAT:
+            if(v->kind == VAL_FLOAT) a->data.f[i] = v->as.f;
+            else if(v->kind == VAL_INT) a->data.f[i] = (double)v->as.i;
+            else return false;
+            return true;
+        case VAL_BOOL:
+            if(v->kind != VAL_BOOL) return false;
+            a->data.b[i] = v->as.b ? 1u : 0u; return true;
+        default: return false;
+    }
+}
+
+static const char *k_bad_elem = "tipo de elemento incompatible con el array";
+
+const char *value_array_from(value_kind elem, const value_t *items, size_t n, value_t *out){
+    *out = v_void();
+    if(elem == VAL_VOID){
+        for(size_t i=0;i<n;i++){
+            value_kind k = items[i].kind;
+            if(k != VAL_INT && k != VAL_FLOAT && k != VAL_BOOL) return "los arrays sólo admiten int, float o bool";
+            if(i == 0) elem = k;
+            else if(k != elem){
+                if((k == VAL_BOOL) != (elem == VAL_BOOL)) return k_bad_elem;
+                elem = VAL_FLOAT; // int y float mezclados
+            }
+        }
+    }
+    value_t v = v_array(elem, n);
+    if(v.kind != VAL_ARRAY) return "sin memoria para el array";
+    for(size_t i=0;i<n;i++){
+        if(!array_put(v.as.a, i, &items[i])){ value_free(&v); return k_bad_elem; }
+    }
+    v.as.a->len = n;
+    *out = v;
+    return NULL;
+}
+
+// a[i] con chequeo; en *at queda la posición
+static const char *check_index(const value_t *a, const value_t *i, size_t *at){
+    if(a->kind != VAL_ARRAY) return "sólo se pueden indexar arrays";
+    if(i->kind != VAL_INT) return "el índice de un array debe ser int";
+    if(i->as.i < 0 || (unsigned long long)i->as.i >= a->as.a->len) return "índice fuera de rango";
+    *at = (size_t)i->as.i;
+    return NULL;
+}
+
+const char *value_index(const value_t *a, const value_t *i, value_t *out){
+    size_t at = 0;
+    const char *err = check_index(a, i, &at);
+    *out = err ? v_void() : value_array_get(a->as.a, at);
+    return err;
+}
+
+const char *value_index_set(const value_t *a, const value_t *i, const value_t *v, value_t *stored){
+    size_t at = 0;
+    const char *err = check_index(a, i, &at);
+    if(!err && !array_put(a->as.a, at, v)) err = k_bad_elem;
+    *stored = err ? v_void() : value_array_get(a->as.a, at);
+    return err;
+}
+
+const char *value_array_push(const value_t *a, const value_t *v){
+    if(a->kind != VAL_ARRAY) return "push() espera un array";
+    celer_array *arr = a->as.a;
+    if(arr->elem == VAL_VOID){
+        if(v->kind != VAL_INT && v->kind != VAL_FLOAT && v->kind != VAL_BOOL) return "los arrays sólo admiten int, float o bool";
+        arr->elem = v->kind; // [] sin tipo: todavía sin memoria
+    }
+    if(!array_reserve(arr, arr->len + 1u)) return "sin memoria para el array";
+    if(!array_put(arr, arr->len, v)) return k_bad_elem;
+    arr->len++;
+    return NULL;
+}
+
+static void array_release(celer_array *a){
+    stats_free(a->data.i, a->cap * elem_size(a->elem));
+    stats_free(a, sizeof(celer_array));
+}
 
 void value_free(value_t *v){
     if(!v) return;
-    if(v->kind==VAL_STRING) free(v->as.s);
+    if(v->kind==VAL_STRING && v->as.s && --v->as.s->refs==0)
+        stats_free(v->as.s, sizeof(celer_str)+v->as.s->len+1);
+    else if(v->kind==VAL_ARRAY && --v->as.a->refs==0)
+        array_release(v->as.a);
     v->kind=VAL_VOID; v->as.s=NULL;
 }
 value_t value_copy(const value_t *v){
     if(!v) return v_void();
-    if(v->kind==VAL_STRING) return v_string(v->as.s);
+    if(v->kind==VAL_STRING && v->as.s) v->as.s->refs++;
+    else if(v->kind==VAL_ARRAY) v->as.a->refs++;
     return *v;
 }
 const char *value_kind_name(value_kind k){
@@ -32,19 +168,22 @@ const char *value_kind_name(value_kind k){
         case VAL_BOOL: return "bool";
         case VAL_FLOAT: return "float";
         case VAL_STRING: return "string";
+        case VAL_ARRAY: return "array";
         default: return "?";
     }
 }
 
-value_t value_to_bool(const value_t *v){
+bool value_truthy(const value_t *v){
     switch(v->kind){
-        case VAL_BOOL:  return v_bool(v->as.b);
-        case VAL_INT:   return v_bool(v->as.i!=0);
-        case VAL_FLOAT: return v_bool(fabs(v->as.f) > 1e-12);
-        case VAL_STRING:return v_bool(v->as.s && v->as.s[0]!='\0');
-        default:        return v_bool(false);
+        case VAL_BOOL:  return v->as.b;
+        case VAL_INT:   return v->as.i!=0;
+        case VAL_FLOAT: return fabs(v->as.f) > 1e-12;
+        case VAL_STRING:return value_strlen(v)!=0;
+        case VAL_ARRAY: return v->as.a->len!=0;
+        default:        return false;
     }
 }
+value_t value_to_bool(const value_t *v){ return v_bool(value_truthy(v)); }
 value_t value_to_float(const value_t *v){
     switch(v->kind){
         case VAL_FLOAT: return v_float(v->as.f);
@@ -68,7 +207,33 @@ char *value_to_cstr(const value_t *v){
         case VAL_BOOL: return dup_cstr(v->as.b?"true":"false");
         case VAL_INT:  snprintf(buf,sizeof(buf),"%lld", v->as.i); return dup_cstr(buf);
         case VAL_FLOAT:snprintf(buf,sizeof(buf),"%g", v->as.f); return dup_cstr(buf);
-        case VAL_STRING: return dup_cstr(v->as.s?v->as.s:"");
+        case VAL_STRING: return dup_cstr(value_str(v));
+        case VAL_ARRAY: {
+            // "[1, 2, 3]"; se arma aparte para que el resultado mida strlen+1
+            const celer_array *a = v->as.a;
+            size_t cap = 64u, n = 0;
+            char *tmp = (char*)malloc(cap);
+            if(!tmp) return NULL;
+            tmp[n++] = '[';
+            for(size_t i=0;i<a->len;i++){
+                value_t x = value_array_get(a, i);
+                int k = x.kind==VAL_INT ? snprintf(buf,sizeof(buf),"%lld", x.as.i)
+                      : x.kind==VAL_FLOAT ? snprintf(buf,sizeof(buf),"%g", x.as.f)
+                      : snprintf(buf,sizeof(buf),"%s", x.as.b?"true":"false");
+                if(n + (size_t)k + 4u > cap){
+                    while(n + (size_t)k + 4u > cap) cap *= 2u;
+                    char *nt = (char*)realloc(tmp, cap);
+                    if(!nt){ free(tmp); return NULL; }
+                    tmp = nt;
+                }
+                if(i){ tmp[n++] = ','; tmp[n++] = ' '; }
+                memcpy(tmp + n, buf, (size_t)k); n += (size_t)k;
+            }
+            tmp[n++] = ']'; tmp[n] = '\0';
+            char *out = dup_cstr(tmp);
+            free(tmp);
+            return out;
+        }
         default: return dup_cstr("?");
     }
 }
@@ -77,11 +242,13 @@ static int both_floaty(const value_t *a, const value_t *b){ return a->kind==VAL_
 
 value_t value_add(const value_t *a, const value_t *b){
     if(a->kind==VAL_STRING && b->kind==VAL_STRING){
-        size_t na=strlen(a->as.s), nb=strlen(b->as.s);
-        char *s=(char*)malloc(na+nb+1);
+        size_t na=value_strlen(a), nb=value_strlen(b);
+        if(nb==0) return value_copy(a);
+        if(na==0) return value_copy(b);
+        celer_str *s=str_alloc(na+nb);
         if(!s) return v_void();
-        memcpy(s,a->as.s,na); memcpy(s+na,b->as.s,nb); s[na+nb]='\0';
-        value_t v=v_string(s); free(s); return v;
+        memcpy(s->data,a->as.s->data,na); memcpy(s->data+na,b->as.s->data,nb);
+        value_t v; v.kind=VAL_STRING; v.as.s=s; return v;
     }
     if(both_floaty(a,b)) return v_float((a->kind==VAL_FLOAT? a->as.f:(double)a->as.i) + (b->kind==VAL_FLOAT? b->as.f:(double)b->as.i));
     if(a->kind==VAL_INT && b->kind==VAL_INT) return v_int(a->as.i + b->as.i);
@@ -121,7 +288,20 @@ value_t value_eq (const value_t *a, const value_t *b){
         case VAL_BOOL: return v_bool(a->as.b==b->as.b);
         case VAL_INT:  return v_bool(a->as.i==b->as.i);
         case VAL_FLOAT:return v_bool(fabs(a->as.f-b->as.f)<1e-12);
-        case VAL_STRING:return v_bool(strcmp(a->as.s? a->as.s:"", b->as.s? b->as.s:"")==0);
+        case VAL_STRING:
+            if(a->as.s==b->as.s) return v_bool(true);
+            return v_bool(value_strlen(a)==value_strlen(b) && memcmp(value_str(a), value_str(b), value_strlen(a))==0);
+        case VAL_ARRAY: {
+            // mismo array o mismos elementos (int y float se comparan como float)
+            const celer_array *x = a->as.a, *y = b->as.a;
+            if(x==y) return v_bool(true);
+            if(x->len!=y->len) return v_bool(false);
+            for(size_t i=0;i<x->len;i++){
+                value_t xi = value_array_get(x, i), yi = value_array_get(y, i);
+                if(!value_eq(&xi, &yi).as.b) return v_bool(false);
+            }
+            return v_bool(true);
+        }
         default: return v_bool(false);
     }
 }
@@ -135,24 +315,30 @@ value_t value_lt (const value_t *a, const value_t *b){
     if(a->kind==VAL_INT && b->kind==VAL_INT) return v_bool(a->as.i < b->as.i);
     return v_void();
 }
+// Comparación directa: sin pasar por value_lt/value_eq ni crear temporales.
+// Fuera de los numéricos `<` es void, así que `<=` queda en `==` y `>` en su negación.
 value_t value_lte(const value_t *a, const value_t *b){
-    value_t lt=value_lt(a,b); value_t eq=value_eq(a,b);
-    value_t r=v_bool( (lt.kind==VAL_BOOL && lt.as.b) || (eq.kind==VAL_BOOL && eq.as.b) ); value_free(&lt); value_free(&eq); return r;
+    if(a->kind==VAL_INT && b->kind==VAL_INT) return v_bool(a->as.i <= b->as.i);
+    if(both_floaty(a,b)){
+        double aa=(a->kind==VAL_FLOAT?a->as.f:(double)a->as.i);
+        double bb=(b->kind==VAL_FLOAT?b->as.f:(double)b->as.i);
+        return v_bool(aa<bb || fabs(aa-bb)<1e-12);
+    }
+    return value_eq(a,b);
 }
 value_t value_gt (const value_t *a, const value_t *b){
-    value_t le=value_lte(a,b); if(le.kind==VAL_BOOL){ value_t r=v_bool(!le.as.b); value_free(&le); return r; } value_free(&le); return v_void();
+    value_t le=value_lte(a,b); le.as.b=!le.as.b; return le;
 }
 value_t value_gte(const value_t *a, const value_t *b){
-    value_t lt=value_lt(a,b); if(lt.kind==VAL_BOOL){ value_t r=v_bool(!lt.as.b); value_free(&lt); return r; } value_free(&lt); return v_void();
+    if(a->kind==VAL_INT && b->kind==VAL_INT) return v_bool(a->as.i >= b->as.i);
+    value_t lt=value_lt(a,b); if(lt.kind==VAL_BOOL) lt.as.b=!lt.as.b; return lt;
 }
 value_t value_and(const value_t *a, const value_t *b){
-    value_t aa=value_to_bool(a), bb=value_to_bool(b);
-    value_t r=v_bool(aa.as.b && bb.as.b); value_free(&aa); value_free(&bb); return r;
+    return v_bool(value_truthy(a) && value_truthy(b));
 }
 value_t value_or (const value_t *a, const value_t *b){
-    value_t aa=value_to_bool(a), bb=value_to_bool(b);
-    value_t r=v_bool(aa.as.b || bb.as.b); value_free(&aa); value_free(&bb); return r;
+    return v_bool(value_truthy(a) || value_truthy(b));
 }
 value_t value_not(const value_t *a){
-    value_t aa=value_to_bool(a); value_t r=v_bool(!aa.as.b); value_free(&aa); return r;
+    return v_bool(!value_truthy(a));
 }
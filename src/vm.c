@@ -0,0 +1,375 @@
+#include "../include/vm.h"
+#include "../include/eval.h"
+#include "../include/jit.h"
+#include "../include/profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Pila de valores y de frames en el heap; crecen al doble según haga falta.
+#define VM_STACK_INIT  (1u << 12)
+#define VM_FRAMES_INIT 64u
+
+// Despacho con "computed goto" (extensión de GCC/Clang); switch en el resto.
+#if defined(__GNUC__) && !defined(CELER_NO_COMPUTED_GOTO)
+#define VM_USE_COMPUTED_GOTO 1
+#endif
+
+typedef struct {
+    const bc_function *fn;
+    const uint8_t *ip;   // guardado al llamar
+    value_t *slots;      // base del frame en la pila de valores
+} vm_frame;
+
+static size_t g_max_depth = CELER_MAX_DEPTH_DEFAULT;
+
+void vm_set_max_depth(size_t n){ g_max_depth = n ? n : 1; }
+
+// Agranda la pila de valores hasta que quepan `need` valores y reubica los
+// punteros que apuntan dentro de ella (frames, slots y tope).
+static bool grow_stack(value_t **stack, size_t *cap, size_t need, vm_frame *frames, size_t frame_count,
+                       value_t **sp, value_t **slots){
+    size_t nc = *cap;
+    while(nc < need) nc *= 2u;
+    value_t *ns = (value_t*)realloc(*stack, nc * sizeof(value_t));
+    if(!ns) return false;
+    for(size_t i=0;i<frame_count;i++) frames[i].slots = ns + (frames[i].slots - *stack);
+    *sp = ns + (*sp - *stack);
+    *slots = ns + (*slots - *stack);
+    *stack = ns;
+    *cap = nc;
+    return true;
+}
+
+// Nuevo valor de a[i] en `a[i] op= v` (op es el op_kind del operador).
+static value_t compound_value(unsigned op, const value_t *cur, const value_t *v){
+    switch((op_kind)op){
+        case OP_PLUS_ASSIGN:    return value_add(cur, v);
+        case OP_MINUS_ASSIGN:   return value_sub(cur, v);
+        case OP_STAR_ASSIGN:    return value_mul(cur, v);
+        case OP_SLASH_ASSIGN:   return value_div(cur, v);
+        case OP_PERCENT_ASSIGN: return value_mod(cur, v);
+        default:                return value_copy(v);
+    }
+}
+
+bool vm_run(const bc_program *prog, env_t *global){
+    size_t stack_cap = VM_STACK_INIT, frames_cap = VM_FRAMES_INIT;
+    value_t *stack = (value_t*)malloc(stack_cap * sizeof(value_t));
+    vm_frame *frames = (vm_frame*)malloc(frames_cap * sizeof(vm_frame));
+    if(!stack || !frames){ free(stack); free(frames); fprintf(stderr, "Error de ejecución: sin memoria para la VM\n"); return false; }
+    const value_t *consts = prog->consts;
+    bool ok = true;
+    const char *errmsg = NULL;
+    char errbuf[96];
+
+    // las funciones también van al entorno, como en eval_program: el JIT
+    // resuelve ahí las llamadas entre funciones compiladas
+    for(size_t i=0;i<prog->funcs_count;i++)
+        if(prog->funcs[i].decl) env_define_func(global, prog->funcs[i].name, prog->funcs[i].decl);
+
+    size_t frame_count = 1;
+    vm_frame *frame = &frames[0];
+    frame->fn = &prog->script;
+    frame->slots = stack;
+
+    const uint8_t *ip = prog->script.chunk.code;
+    value_t *slots = stack;
+    value_t *sp = stack;
+
+#define READ_U16() (ip += 2, (uint16_t)(ip[-2] | (ip[-1] << 8)))
+// muestreo (--sample): atribuye a la línea de la instrucción en curso
+#define SAMPLE_POINT() do { if(g_prof_sample) \
+        prof_sample_hit(frame->fn->chunk.lines[ip - frame->fn->chunk.code - 1]); } while(0)
+#define RT_ERROR(msg) do { errmsg = (msg); goto fatal; } while(0)
+// Garantiza lugar para `n` valores desde `base`; `base` se recalcula si la pila se mueve.
+#define ENSURE_STACK(base, n) do { \
+        size_t off_ = (size_t)((base) - stack), need_ = off_ + (size_t)(n); \
+        if(need_ > stack_cap){ \
+            if(!grow_stack(&stack, &stack_cap, need_, frames, frame_count, &sp, &slots)) \
+                RT_ERROR("sin memoria para la pila de valores"); \
+            (base) = stack + off_; \
+        } \
+    } while(0)
+#define BINARY(fnc) do { \
+        value_t r_ = fnc(sp-2, sp-1); \
+        value_free(sp-2); value_free(sp-1); \
+        sp--; sp[-1] = r_; \
+    } while(0)
+
+// Los ints no tienen memoria asociada: no hace falta value_free.
+#define INT_BINARY(expr_) do { \
+        long long a = sp[-2].as.i, b = sp[-1].as.i; \
+        sp--; sp[-1] = (expr_); \
+    } while(0)
+#define INT_CMP_JUMP(cmp) do { \
+        uint16_t off_ = READ_U16(); \
+        bool c_ = sp[-2].as.i cmp sp[-1].as.i; \
+        sp -= 2; \
+        SAMPLE_POINT(); \
+        if(!c_) ip += off_; \
+    } while(0)
+
+    ENSURE_STACK(sp, prog->script.max_stack);
+
+#ifdef VM_USE_COMPUTED_GOTO
+    static void *const dispatch[BC__COUNT] = {
+#define BC_LABEL(op) &&L_##op,
+        BC_OPCODES(BC_LABEL)
+#undef BC_LABEL
+    };
+#define VM_CASE(op) L_##op:
+#define VM_NEXT()   goto *dispatch[*ip++]
+    VM_NEXT();
+#else
+#define VM_CASE(op) case op:
+#define VM_NEXT()   continue
+    for(;;) switch((bc_op)*ip++){
+#endif
+
+    VM_CASE(BC_CONST){ uint16_t k = READ_U16(); *sp++ = value_copy(&consts[k]); VM_NEXT(); }
+    VM_CASE(BC_VOID){ *sp++ = v_void(); VM_NEXT(); }
+    VM_CASE(BC_POP){ value_free(--sp); SAMPLE_POINT(); VM_NEXT(); }
+    VM_CASE(BC_SWAP){ value_t t = sp[-1]; sp[-1] = sp[-2]; sp[-2] = t; VM_NEXT(); }
+    VM_CASE(BC_POPN){ uint16_t n = READ_U16(); while(n--) value_free(--sp); VM_NEXT(); }
+
+    VM_CASE(BC_GET_LOCAL){ uint16_t s = READ_U16(); *sp++ = value_copy(&slots[s]); VM_NEXT(); }
+    VM_CASE(BC_SET_LOCAL){
+        uint16_t s = READ_U16();
+        value_free(&slots[s]);
+        slots[s] = value_copy(sp-1);
+        VM_NEXT();
+    }
+    VM_CASE(BC_CLEAR){
+        uint16_t s = READ_U16(); uint16_t n = READ_U16();
+        for(value_t *p = slots + s; p < slots + s + n; p++) value_free(p);
+        VM_NEXT();
+    }
+
+    VM_CASE(BC_GET_GLOBAL){
+        uint16_t k = READ_U16();
+        value_t v;
+        if(!env_get_var(global, value_str(&consts[k]), &v)) v = v_void();
+        *sp++ = v;
+        VM_NEXT();
+    }
+    VM_CASE(BC_SET_GLOBAL){
+        uint16_t k = READ_U16();
+        if(!env_set_var(global, value_str(&consts[k]), sp[-1]))
+            env_define_var(global, value_str(&consts[k]), false, sp[-1]);
+        VM_NEXT();
+    }
+    VM_CASE(BC_DEFINE_GLOBAL){
+        uint16_t k = READ_U16();
+        env_define_var(global, value_str(&consts[k]), false, sp[-1]);
+        value_free(--sp);
+        VM_NEXT();
+    }
+    VM_CASE(BC_DEFINE_CONST){
+        uint16_t k = READ_U16();
+        env_define_var(global, value_str(&consts[k]), true, sp[-1]);
+        value_free(--sp);
+        VM_NEXT();
+    }
+
+    VM_CASE(BC_ADD){ BINARY(value_add); VM_NEXT(); }
+    VM_CASE(BC_SUB){ BINARY(value_sub); VM_NEXT(); }
+    VM_CASE(BC_MUL){ BINARY(value_mul); VM_NEXT(); }
+    VM_CASE(BC_DIV){ BINARY(value_div); VM_NEXT(); }
+    VM_CASE(BC_MOD){ BINARY(value_mod); VM_NEXT(); }
+    VM_CASE(BC_EQ){  BINARY(value_eq);  VM_NEXT(); }
+    VM_CASE(BC_NEQ){ BINARY(value_neq); VM_NEXT(); }
+    VM_CASE(BC_LT){  BINARY(value_lt);  VM_NEXT(); }
+    VM_CASE(BC_LTE){ BINARY(value_lte); VM_NEXT(); }
+    VM_CASE(BC_GT){  BINARY(value_gt);  VM_NEXT(); }
+    VM_CASE(BC_GTE){ BINARY(value_gte); VM_NEXT(); }
+    VM_CASE(BC_NOT){
+        value_t r = value_not(sp-1);
+        value_free(sp-1); sp[-1] = r;
+        VM_NEXT();
+    }
+    VM_CASE(BC_NEG){
+        value_t zero = v_int(0);
+        value_t r = value_sub(&zero, sp-1);
+        value_free(sp-1); sp[-1] = r;
+        VM_NEXT();
+    }
+
+    VM_CASE(BC_JUMP){ uint16_t off = READ_U16(); ip += off; VM_NEXT(); }
+    VM_CASE(BC_JUMP_IF_FALSE){
+        uint16_t off = READ_U16();
+        bool c = value_truthy(sp-1);
+        value_free(--sp);
+        SAMPLE_POINT();
+        if(!c) ip += off;
+        VM_NEXT();
+    }
+    VM_CASE(BC_JUMP_IF_TRUE){
+        uint16_t off = READ_U16();
+        bool c = value_truthy(sp-1);
+        value_free(--sp);
+        if(c) ip += off;
+        VM_NEXT();
+    }
+    VM_CASE(BC_LOOP){ uint16_t off = READ_U16(); SAMPLE_POINT(); ip -= off; VM_NEXT(); }
+
+    VM_CASE(BC_CALL){
+        uint16_t f = READ_U16(); uint16_t argc = READ_U16();
+        SAMPLE_POINT();
+        const bc_function *callee = &prog->funcs[f];
+        // args de más se descartan; los que faltan quedan void
+        while(argc > callee->arity){ value_free(--sp); argc--; }
+        if(frame_count > g_max_depth){
+            snprintf(errbuf, sizeof(errbuf), "desbordamiento de la pila de llamadas (profundidad %zu)", frame_count - 1);
+            RT_ERROR(errbuf);
+        }
+        if(frame_count == frames_cap){
+            vm_frame *nf = (vm_frame*)realloc(frames, frames_cap * 2u * sizeof(vm_frame));
+            if(!nf) RT_ERROR("sin memoria para la pila de llamadas");
+            frames = nf; frames_cap *= 2u;
+            frame = &frames[frame_count - 1];
+        }
+        value_t *args = sp - argc;
+        value_t native;
+        if(callee->decl && jit_call(callee->decl, args, argc, frame_count - 1, g_max_depth, &native)){
+            sp = args;
+            *sp++ = native; // los args de una función nativa son escalares
+            VM_NEXT();
+        }
+        ENSURE_STACK(args, callee->nslots + callee->max_stack);
+        while(sp < args + callee->nslots) *sp++ = v_void();
+        if(g_prof_enabled) prof_enter(callee->decl);
+
+        frame->ip = ip;
+        frame = &frames[frame_count++];
+        frame->fn = callee;
+        frame->slots = args;
+        slots = args;
+        ip = callee->chunk.code;
+        VM_NEXT();
+    }
+    VM_CASE(BC_TAILCALL){
+        uint16_t f = READ_U16(); uint16_t argc = READ_U16();
+        const bc_function *callee = &prog->funcs[f];
+        while(argc > callee->arity){ value_free(--sp); argc--; }
+        // el frame actual se reutiliza: se liberan sus slots y los args bajan a la base
+        value_t *args = sp - argc;
+        for(value_t *p = slots; p < args; p++) value_free(p);
+        memmove(slots, args, (size_t)argc * sizeof(value_t));
+        sp = slots + argc;
+        ENSURE_STACK(slots, callee->nslots + callee->max_stack);
+        while(sp < slots + callee->nslots) *sp++ = v_void();
+        if(g_prof_enabled) prof_tail(callee->decl);
+        frame->fn = callee;
+        frame->slots = slots;
+        ip = callee->chunk.code;
+        VM_NEXT();
+    }
+    VM_CASE(BC_CALL_BUILTIN){
+        uint16_t b = READ_U16(); uint16_t argc = READ_U16();
+        value_t r = prog->builtins[b](argc, sp - argc);
+        while(argc--) value_free(--sp);
+        *sp++ = r;
+        const char *berr = eval_builtin_error();
+        if(berr) RT_ERROR(berr);
+        VM_NEXT();
+    }
+    VM_CASE(BC_ARRAY){
+        uint16_t n = READ_U16(); uint16_t k = READ_U16();
+        value_t r;
+        const char *err = value_array_from((value_kind)k, sp - n, n, &r);
+        while(n--) value_free(--sp);
+        *sp++ = r;
+        if(err) RT_ERROR(err);
+        VM_NEXT();
+    }
+    VM_CASE(BC_INDEX){
+        value_t r;
+        const char *err = value_index(sp-2, sp-1, &r);
+        value_free(sp-2); value_free(sp-1);
+        sp--; sp[-1] = r;
+        if(err) RT_ERROR(err);
+        VM_NEXT();
+    }
+    VM_CASE(BC_SET_INDEX){
+        uint16_t op = READ_U16();
+        value_t cur = v_void(), r = v_void();
+        const char *err = op == OP_ASSIGN ? NULL : value_index(sp-3, sp-2, &cur);
+        if(!err){
+            value_t nv = compound_value(op, &cur, sp-1);
+            err = value_index_set(sp-3, sp-2, &nv, &r);
+            value_free(&nv);
+        }
+        value_free(sp-3); value_free(sp-2); value_free(sp-1);
+        sp -= 2; sp[-1] = r;
+        if(err) RT_ERROR(err);
+        VM_NEXT();
+    }
+    VM_CASE(BC_RETURN){
+        SAMPLE_POINT();
+        value_t r = *--sp;
+        for(value_t *p = slots; p < sp; p++) value_free(p);
+        if(g_prof_enabled) prof_leave();
+        sp = slots;
+        frame = &frames[--frame_count - 1];
+        slots = frame->slots;
+        ip = frame->ip;
+        *sp++ = r;
+        VM_NEXT();
+    }
+    VM_CASE(BC_HALT){ goto done; }
+
+    // ---- superinstrucciones tipadas (operandos int garantizados por el checker) ----
+    VM_CASE(BC_GET_LOCAL_RAW){ uint16_t s = READ_U16(); *sp++ = slots[s]; VM_NEXT(); }
+    VM_CASE(BC_ADD_I){ INT_BINARY(v_int(a + b)); VM_NEXT(); }
+    VM_CASE(BC_SUB_I){ INT_BINARY(v_int(a - b)); VM_NEXT(); }
+    VM_CASE(BC_MUL_I){ INT_BINARY(v_int(a * b)); VM_NEXT(); }
+    VM_CASE(BC_DIV_I){ INT_BINARY(v_int(b == 0 ? 0 : a / b)); VM_NEXT(); }
+    VM_CASE(BC_MOD_I){ INT_BINARY(v_int(b == 0 ? 0 : a % b)); VM_NEXT(); }
+    VM_CASE(BC_EQ_I){  INT_BINARY(v_bool(a == b)); VM_NEXT(); }
+    VM_CASE(BC_NEQ_I){ INT_BINARY(v_bool(a != b)); VM_NEXT(); }
+    VM_CASE(BC_LT_I){  INT_BINARY(v_bool(a <  b)); VM_NEXT(); }
+    VM_CASE(BC_LTE_I){ INT_BINARY(v_bool(a <= b)); VM_NEXT(); }
+    VM_CASE(BC_GT_I){  INT_BINARY(v_bool(a >  b)); VM_NEXT(); }
+    VM_CASE(BC_GTE_I){ INT_BINARY(v_bool(a >= b)); VM_NEXT(); }
+    VM_CASE(BC_ADD_IMM_I){ int16_t k = (int16_t)READ_U16(); sp[-1].as.i += k; VM_NEXT(); }
+    VM_CASE(BC_INC_LOCAL_I){
+        uint16_t s = READ_U16(); int16_t k = (int16_t)READ_U16();
+        slots[s].as.i += k;
+        VM_NEXT();
+    }
+    VM_CASE(BC_JUMP_IF_NOT_LT_I){  INT_CMP_JUMP(<);  VM_NEXT(); }
+    VM_CASE(BC_JUMP_IF_NOT_LTE_I){ INT_CMP_JUMP(<=); VM_NEXT(); }
+    VM_CASE(BC_JUMP_IF_NOT_GT_I){  INT_CMP_JUMP(>);  VM_NEXT(); }
+    VM_CASE(BC_JUMP_IF_NOT_GTE_I){ INT_CMP_JUMP(>=); VM_NEXT(); }
+    VM_CASE(BC_JUMP_IF_NOT_EQ_I){  INT_CMP_JUMP(==); VM_NEXT(); }
+    VM_CASE(BC_JUMP_IF_NOT_NEQ_I){ INT_CMP_JUMP(!=); VM_NEXT(); }
+
+#ifndef VM_USE_COMPUTED_GOTO
+    default: RT_ERROR("opcode inválido");
+    }
+#endif
+
+fatal: {
+        const bc_chunk *ch = &frame->fn->chunk;
+        size_t at = (size_t)(ip - ch->code);
+        int line = (at > 0 && at <= ch->count) ? ch->lines[at-1] : 0;
+        fprintf(stderr, "Error de ejecución @%d en %s: %s\n", line, frame->fn->name, errmsg);
+        ok = false;
+    }
+done:
+    while(sp > stack) value_free(--sp);
+    free(stack);
+    free(frames);
+    return ok;
+
+#undef READ_U16
+#undef RT_ERROR
+#undef SAMPLE_POINT
+#undef ENSURE_STACK
+#undef BINARY
+#undef INT_BINARY
+#undef INT_CMP_JUMP
+#undef VM_CASE
+#undef VM_NEXT
+}
@@ -0,0 +1,32 @@
+#!/bin/sh
+# Pruebas de regresión: corre cada tests/*.celer y compara su salida (stdout y
+# stderr) con el .expected de al lado. Sin una línea `*-- modos: ...` el
+# programa corre con cada motor (evaluador, VM, sin optimizar, sin inlining ni
+# JIT) y todos deben dar la misma salida; los modos se separan con `|`.
+#
+# Uso: tests/run.sh [build/celer]
+celer=${1:-build/celer}
+dir=$(dirname "$0")
+out=${TMPDIR:-/tmp}/celer_test.$$
+fail=0; total=0
+for src in "$dir"/*.celer; do
+    modes=$(sed -n 's/^\*-- modos: //p' "$src" | head -n 1)
+    [ -n "$modes" ] || modes=' |--vm|--no-opt|--no-inline --no-jit|--vm --no-opt'
+    old_ifs=$IFS; IFS='|'
+    for m in $modes; do
+        IFS=$old_ifs
+        total=$((total + 1))
+        # $m sin comillas: cada modo son cero o más opciones
+        "$celer" $m "$src" > "$out" 2>&1
+        if ! cmp -s "$out" "${src%.celer}.expected"; then
+            echo "FALLA $src [$m]"
+            diff "${src%.celer}.expected" "$out" | head -n 10
+            fail=$((fail + 1))
+        fi
+        IFS='|'
+    done
+    IFS=$old_ifs
+done
+rm -f "$out"
+echo "$((total - fail))/$total pruebas correctas"
+[ "$fail" -eq 0 ]